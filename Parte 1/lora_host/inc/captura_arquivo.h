@@ -0,0 +1,35 @@
+#ifndef CAPTURA_ARQUIVO_H
+#define CAPTURA_ARQUIVO_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "inc/captura.h"
+}
+
+// Arquivo .lcap aberto para acréscimo; pode ser usado por vários leitores
+class EscritorCaptura {
+public:
+    ~EscritorCaptura() { fechar(); }
+
+    bool abrir(const std::string &caminho);
+    // Recebe o hex de uma linha "CAP:" e grava o registro se ele for válido
+    bool adicionar_hex(const char *hex, size_t n);
+    void fechar();
+
+    uint64_t registros() const { return registros_; }
+
+private:
+    std::mutex mutex_;
+    FILE *arquivo_ = nullptr;
+    uint64_t registros_ = 0;
+};
+
+// Carrega todos os registros de um arquivo .lcap
+bool ler_captura(const std::string &caminho, std::vector<captura_registro_t> &registros);
+
+#endif
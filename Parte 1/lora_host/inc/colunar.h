@@ -0,0 +1,52 @@
+#ifndef COLUNAR_H
+#define COLUNAR_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "inc/registro.h"
+
+// Formato .lcol (little-endian):
+//   cabeçalho: "LCOL", u16 versão, u16 número de colunas
+//   blocos:    u32 n, seguido das colunas contíguas na ordem
+//              t_us u64, gateway u16, no u16, seq u32, rssi i16,
+//              snr i8, temp_x10 i16, umid_x10 i16, flags u8
+#define COLUNAR_VERSAO   1
+#define COLUNAR_COLUNAS  9
+#define COLUNAR_BLOCO    4096
+
+class EscritorColunar {
+public:
+    ~EscritorColunar() { fechar(); }
+
+    bool abrir(const std::string &caminho);
+    void adicionar(const Registro &reg);
+    void fechar();
+
+private:
+    void descarregar();
+
+    FILE *arquivo_ = nullptr;
+    std::vector<uint64_t> t_us_;
+    std::vector<uint16_t> gateway_, no_;
+    std::vector<uint32_t> seq_;
+    std::vector<int16_t> rssi_, temp_, umid_;
+    std::vector<int8_t> snr_;
+    std::vector<uint8_t> flags_;
+};
+
+// Série temporal em texto, uma linha por pacote
+class EscritorCsv {
+public:
+    ~EscritorCsv() { fechar(); }
+
+    bool abrir(const std::string &caminho);
+    void adicionar(const Registro &reg);
+    void fechar();
+
+private:
+    FILE *arquivo_ = nullptr;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef DECODIFICADOR_H
+#define DECODIFICADOR_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "inc/registro.h"
+
+class EscritorCaptura;
+
+// Separa a saída serial do lora_rx em linhas e junta cada
+// "Mensagem recebida: ..." com a linha "RSSI: ..." seguinte.
+// Linhas "CAP:" (captura ativa no gateway) vão para 'captura'.
+class LeitorSerial {
+public:
+    explicit LeitorSerial(uint16_t gateway, EscritorCaptura *captura = nullptr)
+        : gateway_(gateway), captura_(captura) {}
+
+    // Consome um trecho do fluxo; pacotes completos vão para 'saida'
+    void alimentar(const char *dados, size_t n, uint64_t t_us, std::vector<RegistroBruto> &saida);
+
+private:
+    void linha(const std::string &l, uint64_t t_us, std::vector<RegistroBruto> &saida);
+
+    uint16_t gateway_;
+    EscritorCaptura *captura_;
+    std::string parcial_;
+    std::string mensagem_;
+    bool pendente_ = false;
+};
+
+// Interpreta a mensagem de telemetria ("P2:T=25.3C U=60.1% #12", ou
+// "P2:E=crc #12" quando o nó não tem leitura válida)
+bool decodificar(const RegistroBruto &bruto, Registro &reg);
+
+// FNV-1a de 64 bits
+uint64_t hash_mensagem(const char *s, size_t n);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include "inc/registro.h"
+
+// Descarta o mesmo pacote ouvido por mais de um gateway: a chave é o hash
+// da mensagem, válida por uma janela de tempo (o contador do nó dá a volta).
+class Deduplicador {
+public:
+    explicit Deduplicador(uint64_t janela_us) : janela_us_(janela_us) {}
+
+    // true se o registro ainda não foi visto dentro da janela
+    bool novo(const Registro &reg);
+
+    uint64_t duplicados() const { return duplicados_; }
+
+private:
+    uint64_t janela_us_;
+    uint64_t mais_recente_ = 0;
+    uint64_t duplicados_ = 0;
+    std::unordered_map<uint64_t, uint64_t> vistos_;
+    std::deque<std::pair<uint64_t, uint64_t>> ordem_;
+};
+
+#endif
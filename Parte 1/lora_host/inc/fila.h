@@ -0,0 +1,73 @@
+#ifndef FILA_H
+#define FILA_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// Fila limitada entre threads; push bloqueia quando cheia, pop retorna
+// false quando a fila foi fechada e esvaziada.
+template <typename T>
+class Fila {
+public:
+    explicit Fila(size_t capacidade) : capacidade_(capacidade) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cheia_.wait(lock, [this] { return itens_.size() < capacidade_; });
+        itens_.push_back(std::move(item));
+        vazia_.notify_one();
+    }
+
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        vazia_.wait(lock, [this] { return !itens_.empty() || fechada_; });
+        if (itens_.empty()) return false;
+        item = std::move(itens_.front());
+        itens_.pop_front();
+        cheia_.notify_one();
+        return true;
+    }
+
+    void fechar() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fechada_ = true;
+        vazia_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cheia_, vazia_;
+    std::deque<T> itens_;
+    size_t capacidade_;
+    bool fechada_ = false;
+};
+
+// Barreira reutilizável: mantém os leitores do benchmark no mesmo passo
+class Barreira {
+public:
+    explicit Barreira(size_t participantes) : participantes_(participantes) {}
+
+    void aguardar() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        size_t geracao = geracao_;
+        if (++chegaram_ == participantes_) {
+            chegaram_ = 0;
+            geracao_++;
+            todos_.notify_all();
+            return;
+        }
+        todos_.wait(lock, [this, geracao] { return geracao != geracao_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable todos_;
+    size_t participantes_;
+    size_t chegaram_ = 0;
+    size_t geracao_ = 0;
+};
+
+#endif
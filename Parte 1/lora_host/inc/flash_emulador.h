@@ -0,0 +1,56 @@
+#ifndef FLASH_EMULADOR_H
+#define FLASH_EMULADOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Emulador da flash NOR da Pico W no host: apagar leva um setor de 4 KB a
+// 0xFF e programar só zera bits (E lógico com o que já está gravado), como
+// no chip. Guarda o desgaste de cada setor e conta as programações que
+// tentariam levar um bit de 0 para 1, que o chip ignoraria em silêncio.
+// As chamadas chegam pelos stubs flash_range_erase/_program de pico_host.
+class FlashEmulador {
+public:
+    static const uint32_t TAMANHO = 2 * 1024 * 1024;
+    static const uint32_t SETOR = 4096;
+    static const uint32_t PAGINA = 256;
+
+    FlashEmulador() : mem_(TAMANHO, 0xFF), apagamentos_(TAMANHO / SETOR, 0) {}
+
+    // Chip novo: tudo em 0xFF, contadores zerados
+    void reiniciar();
+
+    void apagar(uint32_t offset, size_t n);
+    void programar(uint32_t offset, const uint8_t *dados, size_t n);
+
+    // A próxima programação grava só os primeiros 'bytes' (queda de
+    // energia no meio da operação)
+    void cortar_proxima(size_t bytes) { corte_ = (long)bytes; }
+
+    // As próximas 'n' chamadas a flash_safe_execute estouram o prazo sem
+    // tocar na flash (outro core que não libera a XIP)
+    void recusar_proximas(uint32_t n) { recusas_ = n; }
+    bool recusar();
+
+    uint8_t *memoria() { return mem_.data(); }
+
+    uint32_t apagamentos(uint32_t setor) const { return apagamentos_[setor]; }
+    uint64_t programacoes() const { return programacoes_; }
+    uint64_t apagamentos_total() const { return apagamentos_total_; }
+    uint64_t conflitos() const { return conflitos_; }
+    uint64_t desalinhados() const { return desalinhados_; }
+
+private:
+    std::vector<uint8_t> mem_;
+    std::vector<uint32_t> apagamentos_;
+    long corte_ = -1;
+    uint32_t recusas_ = 0;
+    uint64_t programacoes_ = 0, apagamentos_total_ = 0;
+    uint64_t conflitos_ = 0, desalinhados_ = 0;
+};
+
+// Instância usada pelos stubs
+FlashEmulador &flash_emulador();
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef FONTE_H
+#define FONTE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "inc/fila.h"
+#include "inc/registro.h"
+
+class EscritorCaptura;
+
+typedef Fila<std::vector<RegistroBruto>> FilaBruta;
+
+// Pacotes por lote entregue ao pool de decodificação
+#define FONTE_LOTE 256
+
+// Lê um gateway (tty USB ou arquivo de replay) até o fim do fluxo
+bool ler_fonte(const std::string &caminho, uint16_t gateway, FilaBruta &fila, EscritorCaptura *captura);
+
+// Reinjeta uma captura já carregada em memória, com instantes sintéticos
+// a partir de t_base_us (usado pelo benchmark)
+void ler_memoria(const std::string &conteudo, uint16_t gateway, uint64_t t_base_us, FilaBruta &fila);
+
+// Instante atual do host em microssegundos
+uint64_t agora_us(void);
+
+#endif
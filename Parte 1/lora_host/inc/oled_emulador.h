@@ -0,0 +1,65 @@
+#ifndef OLED_EMULADOR_H
+#define OLED_EMULADOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Emulador do SSD1306 no host: decodifica as transações I2C (bytes de
+// controle, comandos e dados) que o driver ssd1306.c envia e mantém a
+// GDDRAM de 128x64 em memória. As escritas chegam pelo i2c_write_blocking
+// e pelo canal de DMA dos stubs em pico_host.
+class OledEmulador {
+public:
+    static const int LARGURA = 128;
+    static const int ALTURA = 64;
+    static const int PAGINAS = ALTURA / 8;
+
+    OledEmulador() { reiniciar(); }
+
+    void reiniciar();
+
+    // Uma transação I2C completa (sem o byte de endereço)
+    void transacao(const uint8_t *dados, size_t n);
+
+    bool pixel(int x, int y) const;
+    uint8_t byte(int coluna, int pagina) const { return gddram_[pagina][coluna]; }
+    bool ligado() const { return ligado_; }
+    bool invertido() const { return invertido_; }
+    uint8_t contraste() const { return contraste_; }
+
+    uint64_t transacoes() const { return transacoes_; }
+    uint64_t bytes() const { return bytes_; }
+    uint64_t comandos() const { return comandos_; }
+
+    // PBM ASCII (P1) de 128x64, 1 = pixel aceso
+    bool gravar_pbm(const std::string &caminho) const;
+    // Compara com um PBM gravado antes; retorna os pixels diferentes
+    // (-1 se o arquivo não pôde ser lido)
+    long comparar_pbm(const std::string &caminho) const;
+    // Prévia em texto ('#' aceso, '.' apagado)
+    std::string texto() const;
+
+private:
+    void comando(uint8_t c);
+    void dado(uint8_t d);
+    int argumentos(uint8_t c) const;
+
+    uint8_t gddram_[PAGINAS][LARGURA];
+    uint8_t modo_;              // 0 horizontal, 1 vertical, 2 página
+    uint8_t col_ini_, col_fim_, pag_ini_, pag_fim_;
+    uint8_t col_, pag_;
+    uint8_t contraste_;
+    bool ligado_, invertido_;
+
+    // Comando em andamento e seus argumentos
+    uint8_t cmd_[8];
+    int cmd_len_, cmd_faltam_;
+
+    uint64_t transacoes_, bytes_, comandos_;
+};
+
+// Instância que recebe as escritas dos stubs de I2C/DMA
+OledEmulador &oled_emulador();
+
+#endif
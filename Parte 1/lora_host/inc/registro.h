@@ -0,0 +1,40 @@
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+#include <cstdint>
+#include <string>
+
+// Pacote como aparece na saída serial de um gateway (lora_rx)
+struct RegistroBruto {
+    uint64_t t_us;          // Instante de chegada no host
+    uint16_t gateway;       // Índice da fonte que ouviu o pacote
+    int16_t rssi;
+    int8_t snr;
+    std::string mensagem;
+};
+
+// Flags do registro decodificado
+enum : uint8_t {
+    REG_TEM_NO    = 0x01,   // Prefixo "P<n>:" reconhecido
+    REG_TEM_TEMP  = 0x02,   // Campo T=
+    REG_TEM_UMID  = 0x04,   // Campo U=
+    REG_TEM_SEQ   = 0x08,   // Campo #<seq>
+    REG_ERRO_SENSOR = 0x10, // Campo E=<motivo>: amostra inválida, sem T=/U=
+    REG_ATRASADO  = 0x20,   // Campo ~<idade_s>: reenvio, t_us recuado pela idade
+};
+
+// Pacote decodificado, pronto para deduplicação e escrita
+struct Registro {
+    uint64_t t_us;
+    uint64_t chave;         // Hash da mensagem, usado na deduplicação
+    uint32_t seq;
+    uint16_t gateway;
+    uint16_t no;
+    int16_t rssi;
+    int16_t temp_x10;       // Décimos de °C
+    int16_t umid_x10;       // Décimos de %
+    int8_t snr;
+    uint8_t flags;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef RELOGIO_EMULADOR_H
+#define RELOGIO_EMULADOR_H
+
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include "pico/stdlib.h"
+}
+
+// Relógio simulado da Pico no host: time_us_32/64, sleep_ms e os alarmes
+// de pico_host correm sobre ele. O tempo só anda quando o código espera
+// (sleep_ms/sleep_us) ou quando o teste chama avancar(); os alarmes vencidos
+// disparam nesse momento, em ordem de prazo, como o IRQ do timer faria.
+class RelogioEmulador {
+public:
+    // Volta ao instante zero, sem alarmes
+    void reiniciar();
+
+    uint64_t agora_us() const { return agora_us_; }
+    void avancar(uint64_t us);
+
+    alarm_id_t agendar(uint64_t prazo_us, alarm_callback_t callback, void *dados);
+    bool cancelar(alarm_id_t id);
+    size_t pendentes() const { return alarmes_.size(); }
+
+private:
+    struct Alarme {
+        alarm_id_t id;
+        uint64_t prazo_us;
+        alarm_callback_t callback;
+        void *dados;
+    };
+
+    void disparar_vencidos();
+
+    uint64_t agora_us_ = 0;
+    alarm_id_t proximo_id_ = 1;
+    std::vector<Alarme> alarmes_;
+};
+
+// Instância usada pelos stubs
+RelogioEmulador &relogio_emulador();
+
+#endif
@@ -0,0 +1,546 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "inc/flash_emulador.h"
+
+extern "C" {
+#include "inc/config.h"
+#include "inc/diario.h"
+#include "inc/historico.h"
+#include "inc/gateway.h"
+}
+
+static void uso(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opções]\n"
+        "  -n cargas          cargas medidas no benchmark (padrão: 100000)\n"
+        "  -q                 descarta a saída do gateway\n",
+        prog);
+}
+
+// Mesma região de config.c: dois setores antes do histórico
+static const uint32_t REGIAO = FlashEmulador::TAMANHO - DIARIO_SETORES * DIARIO_SETOR_BYTES
+                               - HISTORICO_SETORES * HISTORICO_SETOR_BYTES - CONFIG_SLOTS * CONFIG_SLOT_BYTES;
+
+#define ENDERECO_GATEWAY  0x01
+#define ENDERECO_NO       0x02
+
+// Tentativas sem ACK até voltar ao enlace anterior, como em lora_tx.c
+#define ENLACE_REVERSAO_FALHAS  3
+
+// Os padrões do lora_tx.c
+static config_t padrao() {
+    config_t c = {};
+    c.freq_khz = 915000;
+    c.potencia_dbm = 20;
+    c.sf = 7;
+    c.largura_banda = 7;
+    c.codigo = 1;
+    c.rede_id = 0x2A;
+    c.endereco = ENDERECO_NO;
+    c.endereco_gateway = ENDERECO_GATEWAY;
+    c.decimacao = 5;
+    c.periodo_ms = 2000;
+    c.banda_temp_x10 = 2;
+    c.banda_umid_x10 = 10;
+    c.silencio_max_ms = 10 * 60 * 1000;
+    c.intervalo_min_ms = 60 * 1000;
+    return c;
+}
+
+// Só os campos da configuração, sem cabeçalho, geração e CRC
+static bool mesmos_campos(const config_t &a, const config_t &b) {
+    size_t inicio = offsetof(config_t, freq_khz), fim = offsetof(config_t, comando);
+    return memcmp((const uint8_t *)&a + inicio, (const uint8_t *)&b + inicio, fim - inicio) == 0;
+}
+
+// CRC-16/CCITT, como em config.c, para montar registros de outras versões
+static uint16_t crc16(const uint8_t *p, size_t n) {
+    uint16_t crc = 0xFFFF;
+    while (n--) {
+        crc ^= (uint16_t)*p++ << 8;
+        for (int b = 0; b < 8; ++b) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// Grava direto no slot um registro de 'tamanho' bytes (CRC nos dois últimos)
+static void gravar_registro(uint8_t slot, const uint8_t *dados, uint16_t tamanho) {
+    FlashEmulador &flash = flash_emulador();
+    uint32_t offset = REGIAO + slot * CONFIG_SLOT_BYTES;
+    uint8_t pagina[CONFIG_PAGINA_BYTES];
+    memset(pagina, 0xFF, sizeof(pagina));
+    memcpy(pagina, dados, tamanho - 2);
+    uint16_t crc = crc16(pagina, tamanho - 2);
+    memcpy(pagina + tamanho - 2, &crc, sizeof(crc));
+    flash.apagar(offset, CONFIG_SLOT_BYTES);
+    flash.programar(offset, pagina, sizeof(pagina));
+}
+
+static int falhas = 0;
+
+static void verificar(const char *nome, bool ok, const char *detalhe) {
+    fprintf(stderr, "%-14s %s  %s\n", nome, ok ? "ok     " : "FALHOU ", detalhe);
+    if (!ok) falhas++;
+}
+
+// ---------------------------------------------------------------------
+// Registro na flash
+// ---------------------------------------------------------------------
+
+static void verificar_flash() {
+    FlashEmulador &flash = flash_emulador();
+    const config_t base = padrao();
+    char detalhe[160];
+    config_t c;
+
+    // Flash em branco: o padrão do firmware, sem gravar nada
+    flash.reiniciar();
+    int slot = config_carregar(&c, &base);
+    snprintf(detalhe, sizeof(detalhe), "slot %d, %llu operações de flash", slot,
+             (unsigned long long)(flash.programacoes() + flash.apagamentos_total()));
+    verificar("padrao", slot < 0 && mesmos_campos(c, base) && c.geracao == 0 &&
+                        flash.programacoes() == 0 && flash.apagamentos_total() == 0, detalhe);
+
+    // Gravações seguidas alternam os slots e voltam iguais na carga
+    bool certo = true;
+    int slots[2] = {};
+    for (int i = 0; i < 10; ++i) {
+        c.potencia_dbm = (int8_t)(5 + i);
+        c.periodo_ms = 1000 + i;
+        if (!config_gravar(&c)) certo = false;
+        config_t lida;
+        slot = config_carregar(&lida, &base);
+        if (slot < 0 || lida.geracao != c.geracao || !mesmos_campos(lida, c)) certo = false;
+        if (slot >= 0) slots[slot]++;
+    }
+    snprintf(detalhe, sizeof(detalhe), "geração %lu, %d gravações no slot A e %d no B, %u e %u apagamentos",
+             (unsigned long)c.geracao, slots[0], slots[1],
+             flash.apagamentos(REGIAO / CONFIG_SLOT_BYTES), flash.apagamentos(REGIAO / CONFIG_SLOT_BYTES + 1));
+    verificar("alternancia", certo && c.geracao == 10 && slots[0] == 5 && slots[1] == 5, detalhe);
+
+    // Queda de energia no meio da gravação (depois de apagar e no meio da
+    // página): a configuração anterior continua valendo
+    const config_t antes = c;
+    bool intacta = true;
+    for (size_t corte : { (size_t)0, (size_t)20, sizeof(config_t) - 1 }) {
+        config_t nova = antes;
+        nova.freq_khz = 868000;
+        flash.cortar_proxima(corte);
+        bool gravou = config_gravar(&nova);
+        config_t lida;
+        config_carregar(&lida, &base);
+        if (gravou || lida.geracao != antes.geracao || !mesmos_campos(lida, antes)) intacta = false;
+    }
+    // E a próxima gravação completa segue normalmente
+    config_t nova = antes;
+    nova.freq_khz = 868000;
+    config_t lida;
+    bool depois = config_gravar(&nova) && config_carregar(&lida, &base) >= 0 && lida.freq_khz == 868000 &&
+                  lida.geracao == antes.geracao + 1;
+    snprintf(detalhe, sizeof(detalhe), "3 gravações cortadas, geração %lu mantida; a seguinte vale com geração %lu",
+             (unsigned long)antes.geracao, (unsigned long)lida.geracao);
+    verificar("corte", intacta && depois, detalhe);
+
+    // Um bit trocado no slot em vigor: vale o outro, da geração anterior
+    slot = config_carregar(&c, &base);
+    flash.memoria()[REGIAO + slot * CONFIG_SLOT_BYTES + offsetof(config_t, freq_khz)] ^= 0x01;
+    int outro = config_carregar(&lida, &base);
+    snprintf(detalhe, sizeof(detalhe), "slot %d corrompido, carregou o %d (geração %lu)", slot, outro,
+             (unsigned long)lida.geracao);
+    verificar("crc", outro == 1 - slot && lida.geracao == c.geracao - 1 && lida.freq_khz == antes.freq_khz, detalhe);
+
+    // Versão antiga, mais curta (até a decimação): os campos que ela tem e
+    // o padrão nos demais. Versão nova, mais longa: só os campos conhecidos
+    flash.reiniciar();
+    config_t velho = base;
+    velho.magica = CONFIG_MAGICA;
+    velho.versao = 0;
+    velho.tamanho = offsetof(config_t, periodo_ms) + 2;
+    velho.geracao = 7;
+    velho.sf = 10;
+    velho.decimacao = 3;
+    velho.periodo_ms = 1;
+    gravar_registro(1, (const uint8_t *)&velho, velho.tamanho);
+    slot = config_carregar(&c, &base);
+    bool antiga = slot == 1 && c.geracao == 7 && c.sf == 10 && c.decimacao == 3 &&
+                  c.periodo_ms == base.periodo_ms && c.versao == CONFIG_VERSAO && c.tamanho == sizeof(config_t);
+
+    uint8_t longo[sizeof(config_t) + 16];
+    memset(longo, 0xA5, sizeof(longo));
+    config_t novo = base;
+    novo.magica = CONFIG_MAGICA;
+    novo.versao = CONFIG_VERSAO + 1;
+    novo.tamanho = sizeof(longo);
+    novo.geracao = 8;
+    novo.intervalo_min_ms = 5000;
+    memcpy(longo, &novo, offsetof(config_t, reservado));
+    gravar_registro(0, longo, sizeof(longo));
+    slot = config_carregar(&c, &base);
+    bool nova_versao = slot == 0 && c.geracao == 8 && c.intervalo_min_ms == 5000 && c.sf == base.sf;
+    // Gravar de novo converte para esta versão
+    bool convertida = config_gravar(&c) && config_carregar(&lida, &base) == 1 && lida.geracao == 9 &&
+                      lida.intervalo_min_ms == 5000;
+    snprintf(detalhe, sizeof(detalhe), "registro de %u bytes (v0) e de %zu bytes (v%u) sobre o de %zu",
+             (unsigned)velho.tamanho, sizeof(longo), (unsigned)(CONFIG_VERSAO + 1), sizeof(config_t));
+    verificar("versoes", antiga && nova_versao && convertida, detalhe);
+
+    snprintf(detalhe, sizeof(detalhe), "%llu conflitos, %llu operações desalinhadas",
+             (unsigned long long)flash.conflitos(), (unsigned long long)flash.desalinhados());
+    verificar("flash", flash.conflitos() == 0 && flash.desalinhados() == 0, detalhe);
+}
+
+// ---------------------------------------------------------------------
+// Texto dos comandos e perfil de modem
+// ---------------------------------------------------------------------
+
+static void verificar_texto() {
+    const config_t base = padrao();
+    char detalhe[160];
+    char erro[8];
+
+    config_t c = base;
+    bool ok = config_aplicar_texto(&c, "f=868100,p=14,sf=9,bw=250000,cr=6,rede=7,end=5,gw=3,"
+                                       "per=5000,dec=2,bt=5,bu=20,sil=300000,int=0", erro, sizeof(erro));
+    bool campos = c.freq_khz == 868100 && c.potencia_dbm == 14 && c.sf == 9 && c.largura_banda == 8 &&
+                  c.codigo == 2 && c.rede_id == 7 && c.endereco == 5 && c.endereco_gateway == 3 &&
+                  c.periodo_ms == 5000 && c.decimacao == 2 && c.banda_temp_x10 == 5 && c.banda_umid_x10 == 20 &&
+                  c.silencio_max_ms == 300000 && c.intervalo_min_ms == 0;
+    verificar("texto", ok && campos, "todas as chaves aplicadas");
+
+    // Tudo ou nada: um campo recusado não deixa os anteriores aplicados
+    struct { const char *texto, *chave; } recusados[] = {
+        { "p=14,sf=13", "sf" }, { "p=30", "p" }, { "bw=100000", "bw" }, { "f=433000", "f" },
+        { "end=255", "end" }, { "p=14,x=1", "x" }, { "p=", "p" }, { "p=1a", "p" }, { "sf", "sf" },
+        { "gw=2", "end" }, { "cr=4", "cr" },
+    };
+    int certos = 0, total = 0;
+    for (const auto &r : recusados) {
+        c = base;
+        total++;
+        if (!config_aplicar_texto(&c, r.texto, erro, sizeof(erro)) && !strcmp(erro, r.chave) &&
+            !memcmp(&c, &base, sizeof(c))) {
+            certos++;
+        }
+    }
+    snprintf(detalhe, sizeof(detalhe), "%d de %d comandos inválidos recusados pela chave certa", certos, total);
+    verificar("validacao", certos == total, detalhe);
+
+    // O padrão dá o perfil que o rfm95_config fixava; LDRO a partir de
+    // SF11 em 125 kHz e fora em SF12 a 500 kHz (símbolo de 8 ms)
+    uint8_t m1, m2, m3;
+    config_modem(&base, &m1, &m2, &m3);
+    bool perfil = m1 == 0x72 && m2 == 0x74 && m3 == 0x04;
+    bool ldro = true;
+    for (uint8_t sf = 7; sf <= 12; ++sf) {
+        c = base;
+        c.sf = sf;
+        config_modem(&c, &m1, &m2, &m3);
+        if (((m3 & 0x08) != 0) != (sf >= 11)) ldro = false;
+    }
+    c = base;
+    c.sf = 12;
+    c.largura_banda = 9;
+    config_modem(&c, &m1, &m2, &m3);
+    ldro = ldro && !(m3 & 0x08);
+    verificar("modem", perfil && ldro, "0x72 0x74 0x04 no padrão; LDRO em SF11 e SF12 a 125 kHz, não em SF12 a 500 kHz");
+}
+
+// ---------------------------------------------------------------------
+// Comando pelo rádio: gateway.c contra a lógica de receive_config do nó
+// ---------------------------------------------------------------------
+
+struct No {
+    config_t cfg;
+    char prefixo[8];
+    unsigned aplicados = 0;
+    unsigned seguidas = 0;          // Rodadas sem ACK desde o último
+    unsigned revertidas = 0;
+    // false: o gateway fica no enlace de 'padrao()' e não ouve um nó que
+    // mudou de frequência, modem ou rede
+    bool gateway_segue = true;
+    // Perfil do rádio do gateway, que segue os comandos aceitos como o
+    // lora_rx.c (config_seguir); nulo: o gateway segue sempre ou nunca
+    config_t *gateway = nullptr;
+};
+
+// Quadro do nó entregue ao gateway
+static void entregar(const char *mensagem, uint8_t src, uint8_t flags) {
+    rfm95_packet_t packet = {};
+    size_t len = strlen(mensagem);
+    memcpy(packet.message, mensagem, len + 1);
+    packet.length = (uint8_t)len;
+    packet.addressed = true;
+    packet.header.dst = ENDERECO_GATEWAY;
+    packet.header.src = src;
+    packet.header.flags = flags;
+    packet.valid = true;
+    gateway_processar(&packet, 0);
+}
+
+// O que o lora_tx.c faz com o comando que veio na confirmação; retorna a
+// resposta (vazia se não havia comando)
+static void no_receber(No &no, const char *ack, char *resposta, size_t len) {
+    resposta[0] = '\0';
+    uint16_t id;
+    const char *campos;
+    uint32_t chave;
+    if (!config_ler_comando(ack, &id, &campos, &chave)) return;
+
+    char erro[8];
+    config_t novo = no.cfg;
+    bool repetido = chave == no.cfg.comando;
+    if (!repetido && !config_aplicar_texto(&novo, campos, erro, sizeof(erro))) {
+        snprintf(resposta, len, "%s:CFG=%u erro=%s", no.prefixo, id, erro);
+    } else {
+        novo.comando = chave;
+        if (!repetido) novo.provisoria = config_enlace_mudou(&no.cfg, &novo);
+        if (!repetido && !config_gravar(&novo)) snprintf(resposta, len, "%s:CFG=%u erro=flash", no.prefixo, id);
+        else snprintf(resposta, len, "%s:CFG=%u g=%lu", no.prefixo, id, (unsigned long)novo.geracao);
+    }
+    if (novo.geracao != no.cfg.geracao) {
+        no.cfg = novo;
+        no.aplicados++;
+        snprintf(no.prefixo, sizeof(no.prefixo), "P%u", no.cfg.endereco);
+    }
+}
+
+// Sem ACK (confirmar_enlace e reverter_enlace do lora_tx.c): depois de
+// ENLACE_REVERSAO_FALHAS seguidas num enlace provisório, volta ao anterior
+static void no_sem_ack(No &no) {
+    config_t anterior;
+    const config_t base = padrao();
+    if (++no.seguidas < ENLACE_REVERSAO_FALHAS || !no.cfg.provisoria) return;
+    if (!config_anterior(&no.cfg, &base, &anterior)) return;
+    anterior.geracao = no.cfg.geracao;
+    anterior.comando = no.cfg.comando;
+    anterior.provisoria = 0;
+    if (!config_gravar(&anterior)) return;
+    no.cfg = anterior;
+    no.seguidas = 0;
+    no.revertidas++;
+    snprintf(no.prefixo, sizeof(no.prefixo), "P%u", no.cfg.endereco);
+}
+
+static void no_com_ack(No &no) {
+    no.seguidas = 0;
+    if (!no.cfg.provisoria) return;
+    config_t novo = no.cfg;
+    novo.provisoria = 0;
+    if (config_gravar(&novo)) no.cfg = novo;
+}
+
+// Uma amostra do nó e a confirmação do gateway; false se a confirmação não
+// chegou (perda no ar ou o gateway em outro enlace)
+static bool rodada(No &no, uint32_t seq, bool perde_ack, bool perde_resposta, char *ack, size_t len) {
+    const config_t base = padrao();
+    ack[0] = '\0';
+    // O gateway só ouve a frequência, o modem e a rede dele
+    const config_t &gw = no.gateway ? *no.gateway : base;
+    uint8_t gw_endereco = no.gateway ? no.gateway->endereco : base.endereco_gateway;
+    bool ouvido = no.cfg.freq_khz == gw.freq_khz && no.cfg.sf == gw.sf &&
+                  no.cfg.largura_banda == gw.largura_banda && no.cfg.codigo == gw.codigo &&
+                  no.cfg.rede_id == gw.rede_id && no.cfg.endereco_gateway == gw_endereco;
+    if ((no.gateway || !no.gateway_segue) && !ouvido) {
+        no_sem_ack(no);
+        return false;
+    }
+
+    char pacote[64];
+    snprintf(pacote, sizeof(pacote), "%s:T=24.1C,U=60.2%% #%lu", no.prefixo, (unsigned long)seq);
+    entregar(pacote, no.cfg.endereco, RFM95_FLAG_PEDE_ACK);
+
+    uint8_t destino;
+    if (!gateway_confirmacao(&destino, ack, len) || destino != no.cfg.endereco || perde_ack) {
+        no_sem_ack(no);
+        return false;
+    }
+    no_com_ack(no);
+    char resposta[48];
+    uint8_t endereco = no.cfg.endereco;
+    no_receber(no, ack, resposta, sizeof(resposta));
+    // A resposta sai ainda com o endereço de antes
+    if (resposta[0] && !perde_resposta) entregar(resposta, endereco, 0);
+    char campos[GATEWAY_COMANDO_MAX];
+    if (no.gateway && gateway_comando_aceito(campos, sizeof(campos))) config_seguir(no.gateway, campos);
+    return true;
+}
+
+static void verificar_comando() {
+    FlashEmulador &flash = flash_emulador();
+    const config_t base = padrao();
+    char detalhe[200];
+    char ack[RFM95_MENSAGEM_MAX];
+
+    flash.reiniciar();
+    gateway_init();
+    No no;
+    config_carregar(&no.cfg, &base);
+    snprintf(no.prefixo, sizeof(no.prefixo), "P%u", no.cfg.endereco);
+    uint32_t seq = 1;
+
+    // Sem comando na fila a confirmação continua só "A:<seq>"
+    rodada(no, seq++, false, false, ack, sizeof(ack));
+    bool simples = !strcmp(ack, "A:1");
+
+    // Comando com a primeira confirmação perdida e a primeira resposta
+    // perdida: o gateway repete, o nó aplica uma vez só
+    uint16_t id = gateway_comando(ENDERECO_NO, "p=14,sf=9,per=10000");
+    rodada(no, seq++, true, false, ack, sizeof(ack));
+    bool anexado = strstr(ack, ";C:") != nullptr;
+    rodada(no, seq++, false, true, ack, sizeof(ack));
+    // O modem mudou: o enlace fica provisório até o ACK seguinte, que o
+    // confirma com mais uma geração
+    uint32_t geracao = no.cfg.geracao;
+    bool provisoria = no.cfg.provisoria;
+    rodada(no, seq++, false, false, ack, sizeof(ack));
+    bool repetido = strstr(ack, ";C:") != nullptr && provisoria && !no.cfg.provisoria &&
+                    no.cfg.geracao == geracao + 1 && no.aplicados == 1;
+    rodada(no, seq++, false, false, ack, sizeof(ack));
+    bool fila_vazia = strstr(ack, ";C:") == nullptr;
+
+    // Reboot: a configuração e o último comando aplicado voltam da flash
+    config_t reboot;
+    config_carregar(&reboot, &base);
+    bool persistiu = reboot.potencia_dbm == 14 && reboot.sf == 9 && reboot.periodo_ms == 10000 &&
+                     reboot.comando == no.cfg.comando && !reboot.provisoria;
+    snprintf(detalhe, sizeof(detalhe), "comando %u aplicado %u vez, geração %lu; ACK com comando: %s",
+             id, no.aplicados, (unsigned long)no.cfg.geracao, anexado ? "sim" : "não");
+    verificar("comando", id != 0 && simples && anexado && repetido && fila_vazia && persistiu, detalhe);
+
+    // Comando recusado: sai da fila, nada muda na flash
+    uint64_t programacoes = flash.programacoes();
+    gateway_comando(ENDERECO_NO, "sf=13");
+    rodada(no, seq++, false, false, ack, sizeof(ack));
+    rodada(no, seq++, false, false, ack, sizeof(ack));
+    bool recusado = strstr(ack, ";C:") == nullptr && flash.programacoes() == programacoes && no.cfg.sf == 9;
+
+    // Troca de endereço: a resposta sai no antigo e as amostras seguintes
+    // no novo, que passa a receber as confirmações
+    gateway_comando(ENDERECO_NO, "end=9");
+    rodada(no, seq++, false, false, ack, sizeof(ack));
+    bool novo_end = no.cfg.endereco == 9 && !strcmp(no.prefixo, "P9");
+    bool confirmado = rodada(no, seq++, false, false, ack, sizeof(ack)) && strstr(ack, ";C:") == nullptr;
+    snprintf(detalhe, sizeof(detalhe), "%lu respostas no gateway; nó agora em %u",
+             (unsigned long)gateway_estado()->configuracoes, no.cfg.endereco);
+    verificar("recusa_end", recusado && novo_end && confirmado && gateway_estado()->configuracoes == 3, detalhe);
+
+    // Modem trocado sem o gateway acompanhar: a resposta sai no perfil
+    // antigo, as amostras no novo se perdem e, depois de
+    // ENLACE_REVERSAO_FALHAS tentativas, o nó volta ao anterior (também
+    // depois de um reboot) sem aplicar o comando de novo
+    flash.reiniciar();
+    gateway_init();
+    No fixo;
+    fixo.gateway_segue = false;
+    config_carregar(&fixo.cfg, &base);
+    gateway_comando(ENDERECO_NO, "p=14");
+    rodada(fixo, seq++, false, false, ack, sizeof(ack));
+    rodada(fixo, seq++, false, false, ack, sizeof(ack));
+    uint32_t confirmada = fixo.cfg.geracao;
+    gateway_comando(ENDERECO_NO, "sf=10,per=5000");
+    rodada(fixo, seq++, false, false, ack, sizeof(ack));
+    bool trocou = fixo.cfg.sf == 10 && fixo.cfg.provisoria && gateway_estado()->configuracoes == 2;
+    unsigned perdidas = 0;
+    while (!rodada(fixo, seq++, false, false, ack, sizeof(ack)) && perdidas < 10) perdidas++;
+    config_carregar(&reboot, &base);
+    bool voltou = fixo.revertidas == 1 && perdidas == ENLACE_REVERSAO_FALHAS && fixo.aplicados == 2 &&
+                  fixo.cfg.sf == 7 && fixo.cfg.periodo_ms == base.periodo_ms && fixo.cfg.potencia_dbm == 14 &&
+                  !fixo.cfg.provisoria && fixo.cfg.geracao > confirmada && strstr(ack, ";C:") == nullptr &&
+                  reboot.geracao == fixo.cfg.geracao && reboot.sf == 7 && !reboot.provisoria;
+    snprintf(detalhe, sizeof(detalhe), "%u tentativas sem ACK em SF10, de volta a SF7 com p=14 (geração %lu)",
+             perdidas, (unsigned long)fixo.cfg.geracao);
+    verificar("reversao", trocou && voltou, detalhe);
+
+    // Gateway seguindo o nó: frequência, modem e o 'gw' mudam junto depois
+    // da resposta, e o ACK seguinte já sai no enlace novo e o confirma. A
+    // potência do gateway e os campos só do nó não mudam nada nele
+    flash.reiniciar();
+    gateway_init();
+    config_t radio = base;
+    radio.endereco = ENDERECO_GATEWAY;
+    No seguido;
+    seguido.gateway = &radio;
+    config_carregar(&seguido.cfg, &base);
+    gateway_comando(ENDERECO_NO, "f=868100,sf=9,bw=250000,gw=3,p=14");
+    rodada(seguido, seq++, false, false, ack, sizeof(ack));
+    bool mudou = radio.freq_khz == 868100 && radio.sf == 9 && radio.largura_banda == 8 &&
+                 radio.endereco == 3 && radio.potencia_dbm == base.potencia_dbm && seguido.cfg.provisoria;
+    bool junto = rodada(seguido, seq++, false, false, ack, sizeof(ack)) && !seguido.cfg.provisoria;
+    config_t antes = radio;
+    gateway_comando(ENDERECO_NO, "per=5000");
+    rodada(seguido, seq++, false, false, ack, sizeof(ack));
+    char campos[GATEWAY_COMANDO_MAX];
+    bool intacto = !memcmp(&antes, &radio, sizeof(radio)) && seguido.cfg.periodo_ms == 5000 &&
+                   !config_seguir(&radio, "per=5000") && !config_seguir(&radio, "h=0") &&
+                   !gateway_comando_aceito(campos, sizeof(campos));
+    snprintf(detalhe, sizeof(detalhe), "gateway em %lu kHz, SF%u, endereço %u; enlace %s",
+             (unsigned long)radio.freq_khz, radio.sf, radio.endereco, junto ? "confirmado" : "perdido");
+    verificar("segue", mudou && junto && intacto, detalhe);
+
+    // Comando maior que a fila aceita
+    char longo[GATEWAY_COMANDO_MAX + 1];
+    memset(longo, 'p', sizeof(longo) - 1);
+    longo[sizeof(longo) - 1] = '\0';
+    verificar("limite", gateway_comando(ENDERECO_NO, longo) == 0, "comando maior que a fila recusado");
+}
+
+// ---------------------------------------------------------------------
+// Tempo de carga
+// ---------------------------------------------------------------------
+
+static volatile uint32_t sumidouro;
+
+static double agora_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void benchmark(unsigned cargas) {
+    FlashEmulador &flash = flash_emulador();
+    const config_t base = padrao();
+    flash.reiniciar();
+
+    // Os dois slots válidos: o pior caso, dois CRCs
+    config_t c = base;
+    config_gravar(&c);
+    config_gravar(&c);
+
+    double inicio = agora_s();
+    for (unsigned i = 0; i < cargas; ++i) {
+        config_t lida;
+        sumidouro += config_carregar(&lida, &base) + lida.geracao;
+    }
+    double carga_s = (agora_s() - inicio) / cargas;
+
+    fprintf(stderr, "\nregistro de %zu bytes em 2 slots de %u KB (%u KB antes do histórico)\n",
+            sizeof(config_t), CONFIG_SLOT_BYTES / 1024, CONFIG_SLOTS * CONFIG_SLOT_BYTES / 1024);
+    fprintf(stderr, "carga com os dois slots válidos: %.3f us no host, %zu bytes lidos pela XIP\n",
+            carga_s * 1e6, 2 * sizeof(config_t));
+    fprintf(stderr, "gravação: 1 apagamento de setor e 1 página; cada slot leva 1/2 das gravações\n");
+}
+
+int main(int argc, char **argv) {
+    unsigned cargas = 100000;
+    bool silencioso = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) cargas = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-q")) silencioso = true;
+        else { uso(argv[0]); return 1; }
+    }
+    if (cargas == 0) {
+        uso(argv[0]);
+        return 1;
+    }
+    if (silencioso && !freopen("/dev/null", "w", stdout)) return 1;
+
+    verificar_flash();
+    verificar_texto();
+    verificar_comando();
+    benchmark(cargas);
+
+    if (falhas) fprintf(stderr, "\n%d verificações falharam\n", falhas);
+    return falhas ? 1 : 0;
+}
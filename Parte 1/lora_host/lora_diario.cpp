@@ -0,0 +1,525 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "inc/flash_emulador.h"
+
+extern "C" {
+#include "inc/diario.h"
+#include "inc/historico.h"
+#include "inc/lote.h"
+#include "inc/gateway.h"
+}
+
+static void uso(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opções]\n"
+        "  -n amostras        amostras acumuladas com o enlace fora (padrão: 2000)\n"
+        "  -p perda           ACKs perdidos no reenvio, em %% (padrão: 10)\n"
+        "  -q                 descarta a saída do gateway\n",
+        prog);
+}
+
+// Endereços e prazos do enlace, como em lora_tx.c
+#define REDE_ID             0x2A
+#define ENDERECO_GATEWAY    0x01
+#define ENDERECO_NO         0x02
+#define ENLACE_ACK_MS       400
+#define ENLACE_REENVIO_MS   (30 * 1000)
+
+// Do fim da transmissão do nó ao início do ACK (laço do gateway)
+#define VIRADA_MS           10
+
+// Intervalo entre amostras guardadas com o enlace fora
+#define INTERVALO_MS        (60 * 1000)
+
+// ---------------------------------------------------------------------
+// Amostras sintéticas no formato do diário do nó (empacotar_amostra):
+// instante no relógio do nó (s e ms), qualidade, n e os valores em décimos
+// ---------------------------------------------------------------------
+
+#define AMOSTRA_CABECALHO 8
+
+static int16_t temperatura(uint32_t i) { return (int16_t)(200 + i % 50); }
+static int16_t umidade(uint32_t i) { return (int16_t)(500 + (i * 7) % 100); }
+
+static uint32_t gravar_amostra(diario_t &d, uint32_t i, uint64_t t_ms) {
+    uint8_t buf[AMOSTRA_CABECALHO + 4];
+    int16_t valores[2] = { temperatura(i), umidade(i) };
+    uint32_t t_s = (uint32_t)(t_ms / 1000);
+    uint16_t t_frac = (uint16_t)(t_ms % 1000);
+    memcpy(buf, &t_s, sizeof(t_s));
+    memcpy(buf + 4, &t_frac, sizeof(t_frac));
+    buf[6] = 0;
+    buf[7] = 2;
+    memcpy(buf + AMOSTRA_CABECALHO, valores, sizeof(valores));
+    return diario_gravar(&d, buf, sizeof(buf), (uint32_t)t_ms);
+}
+
+static bool conferir_amostra(const diario_registro_t &r, uint32_t i) {
+    int16_t valores[2];
+    if (r.len != AMOSTRA_CABECALHO + sizeof(valores) || r.dados[7] != 2) return false;
+    memcpy(valores, r.dados + AMOSTRA_CABECALHO, sizeof(valores));
+    return valores[0] == temperatura(i) && valores[1] == umidade(i);
+}
+
+static uint64_t instante(const diario_registro_t &r) {
+    uint32_t t_s;
+    uint16_t t_frac;
+    memcpy(&t_s, r.dados, sizeof(t_s));
+    memcpy(&t_frac, r.dados + 4, sizeof(t_frac));
+    return (uint64_t)t_s * 1000 + t_frac;
+}
+
+// Texto da telemetria (formatar_registro do nó)
+static void formatar(const diario_registro_t &r, char *campos, size_t len, uint64_t *t_ms) {
+    int16_t valores[2];
+    *t_ms = instante(r);
+    memcpy(valores, r.dados + AMOSTRA_CABECALHO, sizeof(valores));
+    snprintf(campos, len, "T=%d.%dC U=%d.%d%%", valores[0] / 10, valores[0] % 10, valores[1] / 10, valores[1] % 10);
+}
+
+// Operações de flash pendentes até o diário ficar em dia
+static void drenar(diario_t &d, uint64_t agora_ms) {
+    while (diario_servico(&d, (uint32_t)agora_ms)) {}
+}
+
+// Relógio do nó após o reboot (retomar_relogio do nó): o do histórico
+// passa da amostra pendente mais nova do diário
+static void retomar_relogio(const diario_t &d, historico_t &h) {
+    diario_registro_t r;
+    for (uint32_t seq = d.proximo_seq; seq != diario_cauda(&d); --seq) {
+        if (!diario_ler(&d, seq - 1, &r)) continue;
+        historico_avancar(&h, (uint32_t)(instante(r) / 1000) + 1);
+        return;
+    }
+}
+
+// ---------------------------------------------------------------------
+// Verificações do diário na flash emulada
+// ---------------------------------------------------------------------
+
+static int falhas = 0;
+
+static void verificar(const char *nome, bool ok, const std::string &detalhe) {
+    fprintf(stderr, "%-14s %s  %s\n", nome, ok ? "ok     " : "FALHOU ", detalhe.c_str());
+    if (!ok) falhas++;
+}
+
+static std::string fmt(const char *f, unsigned long a = 0, unsigned long b = 0, unsigned long c = 0) {
+    char buf[160];
+    snprintf(buf, sizeof(buf), f, a, b, c);
+    return buf;
+}
+
+// Diário retomado após o reboot: cauda na primeira sem confirmação, dados
+// intactos e seq à frente de tudo que pode ter sido transmitido
+static void verificar_recuperacao() {
+    FlashEmulador &flash = flash_emulador();
+    flash.reiniciar();
+
+    diario_t d;
+    diario_init(&d);
+    uint32_t s0 = d.proximo_seq, t = 0;
+    for (uint32_t i = 0; i < 300; ++i, t += 1000) {
+        gravar_amostra(d, i, t);
+        diario_servico(&d, t);
+    }
+    diario_confirmar(&d, s0 + 199);
+    drenar(d, t + DIARIO_ATRASO_MS);
+
+    diario_t r;
+    diario_init(&r);
+    bool dados = true;
+    diario_registro_t reg;
+    for (uint32_t s = s0 + 200; s < s0 + 300; ++s) {
+        if (!diario_ler(&r, s, &reg) || !conferir_amostra(reg, s - s0)) dados = false;
+    }
+    verificar("recuperacao", diario_cauda(&r) == s0 + 200 && diario_pendentes(&r) >= 100 && dados,
+              fmt("cauda %lu (esperada %lu), %lu pendentes", diario_cauda(&r), s0 + 200, diario_pendentes(&r)));
+
+    // Registros que só estavam na RAM somem, mas o seq deles não volta
+    uint32_t ultimo = 0;
+    for (uint32_t i = 0; i < 5; ++i) ultimo = gravar_amostra(r, 300 + i, t + i * 1000);
+    diario_t r2;
+    diario_init(&r2);
+    verificar("sem_repeticao", r2.proximo_seq > ultimo && diario_cauda(&r2) == s0 + 200,
+              fmt("último seq gravado %lu, próximo após o reboot %lu", ultimo, r2.proximo_seq));
+}
+
+// Programação interrompida: o registro cortado falha no CRC e o anterior
+// continua legível
+static void verificar_corte() {
+    FlashEmulador &flash = flash_emulador();
+    flash.reiniciar();
+
+    diario_t d;
+    diario_init(&d);
+    uint32_t s0 = d.proximo_seq;
+    for (uint32_t i = 0; i < 3; ++i) gravar_amostra(d, i, 0);
+    // O corte cai dentro do segundo registro (a página começa com o marco
+    // do boot)
+    flash.cortar_proxima((d.cabeca % DIARIO_POR_PAGINA - 2) * DIARIO_REGISTRO_BYTES + 8);
+    drenar(d, DIARIO_ATRASO_MS);
+
+    diario_t r;
+    diario_init(&r);
+    diario_registro_t reg;
+    bool primeiro = diario_ler(&r, s0, &reg) && conferir_amostra(reg, 0);
+    bool cortado = !diario_ler(&r, s0 + 1, &reg) && !diario_ler(&r, s0 + 2, &reg);
+    verificar("corte", primeiro && cortado && diario_cauda(&r) == s0 && r.proximo_seq > s0 + 2,
+              fmt("cauda %lu, próximo seq %lu", diario_cauda(&r), r.proximo_seq));
+}
+
+// Flash recusada pelo flash_safe_execute (prazo estourado): as páginas e
+// as marcas de confirmação continuam pendentes e vão na próxima tentativa
+static void verificar_recusa() {
+    FlashEmulador &flash = flash_emulador();
+    flash.reiniciar();
+
+    diario_t d;
+    diario_init(&d);
+    uint32_t s0 = d.proximo_seq;
+    for (uint32_t i = 0; i < 12; ++i) gravar_amostra(d, i, 0);
+    flash.recusar_proximas(3);
+    drenar(d, DIARIO_ATRASO_MS);
+    uint32_t falhas_dados = d.stats.falhas;
+
+    diario_confirmar(&d, s0 + 4);
+    flash.recusar_proximas(2);
+    drenar(d, DIARIO_ATRASO_MS);
+
+    diario_t r;
+    diario_init(&r);
+    bool dados = true;
+    diario_registro_t reg;
+    for (uint32_t s = s0 + 5; s < s0 + 12; ++s) {
+        if (!diario_ler(&r, s, &reg) || !conferir_amostra(reg, s - s0)) dados = false;
+    }
+    verificar("recusa", falhas_dados == 3 && d.stats.falhas == 5 && diario_cauda(&r) == s0 + 5 && dados,
+              fmt("%lu operações recusadas, cauda %lu após o reboot (esperada %lu)", d.stats.falhas,
+                  diario_cauda(&r), s0 + 5));
+}
+
+// Três voltas com confirmação imediata: nada perdido, nenhum bit levado
+// de 0 a 1 e o mesmo desgaste em todos os setores
+static void verificar_desgaste() {
+    FlashEmulador &flash = flash_emulador();
+    flash.reiniciar();
+
+    diario_t d;
+    diario_init(&d);
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < 3 * DIARIO_SLOTS; ++i, t += 1000) {
+        diario_confirmar(&d, gravar_amostra(d, i, t));
+        diario_servico(&d, t);
+    }
+
+    uint32_t primeiro = FlashEmulador::TAMANHO / FlashEmulador::SETOR - DIARIO_SETORES;
+    uint32_t min = UINT32_MAX, max = 0;
+    for (uint32_t s = primeiro; s < primeiro + DIARIO_SETORES; ++s) {
+        if (flash.apagamentos(s) < min) min = flash.apagamentos(s);
+        if (flash.apagamentos(s) > max) max = flash.apagamentos(s);
+    }
+    bool fora = false;
+    for (uint32_t s = 0; s < primeiro; ++s) fora |= flash.apagamentos(s) != 0;
+    verificar("desgaste", d.stats.perdidos == 0 && flash.conflitos() == 0 && flash.desalinhados() == 0 &&
+                          max - min <= 1 && !fora,
+              fmt("apagamentos por setor %lu..%lu, %lu conflitos", min, max, (unsigned long)flash.conflitos()));
+    fprintf(stderr, "               %lu registros: %lu programações, %lu apagamentos, %lu esperas\n",
+            (unsigned long)d.stats.gravados, (unsigned long)d.stats.programacoes,
+            (unsigned long)d.stats.apagamentos, (unsigned long)d.stats.esperas);
+}
+
+// Sem confirmação a cabeça alcança a cauda e os mais antigos são perdidos
+static void verificar_transbordo() {
+    flash_emulador().reiniciar();
+
+    diario_t d;
+    diario_init(&d);
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < DIARIO_CAPACIDADE + 1000; ++i, t += 1000) {
+        gravar_amostra(d, i, t);
+        diario_servico(&d, t);
+    }
+    diario_registro_t reg;
+    verificar("transbordo", d.stats.perdidos >= 1000 && diario_pendentes(&d) <= DIARIO_CAPACIDADE &&
+                            d.stats.perdidos + diario_pendentes(&d) == d.stats.gravados &&
+                            diario_ler(&d, diario_cauda(&d), &reg),
+              fmt("%lu perdidos, %lu pendentes (capacidade %lu)", d.stats.perdidos, diario_pendentes(&d),
+                  DIARIO_CAPACIDADE));
+}
+
+// ---------------------------------------------------------------------
+// Reenvio pelo enlace: o laço de send_pending/receive_ack do nó contra a
+// lógica do gateway (gateway.c), com perda de ACKs
+// ---------------------------------------------------------------------
+
+typedef struct {
+    uint32_t quadros;
+    uint32_t bytes;
+    uint32_t amostras;          // Amostras transmitidas, com as repetidas
+    uint32_t repetidas;         // Em quadros cujo ACK se perdeu
+    uint32_t acks_perdidos;
+    uint64_t no_ar_us;          // Quadros e ACKs
+    uint64_t total_ms;          // Até o diário esvaziar
+} reenvio_t;
+
+static uint32_t aleatorio = 1;
+
+static uint32_t sortear() {
+    aleatorio = aleatorio * 1103515245u + 12345u;
+    return (aleatorio >> 16) & 0x7FFF;
+}
+
+// Amostras a cada INTERVALO_MS com o enlace fora
+static void acumular(diario_t &d, uint32_t n, uint64_t &t_ms) {
+    for (uint32_t i = 0; i < n; ++i, t_ms += INTERVALO_MS) {
+        gravar_amostra(d, i, t_ms);
+        diario_servico(&d, (uint32_t)t_ms);
+    }
+    drenar(d, t_ms);
+}
+
+static reenvio_t reenviar(diario_t &d, uint64_t t_ms, unsigned lote_max, unsigned perda) {
+    reenvio_t res = {};
+    uint64_t inicio_ms = t_ms;
+    char pacote[RFM95_MENSAGEM_MAX], campos[64];
+
+    while (diario_pendentes(&d) > 0) {
+        uint32_t seq = diario_cauda(&d), ultimo = seq;
+        uint64_t t_amostra;
+        diario_registro_t r;
+        if (!diario_ler(&d, seq, &r)) {
+            diario_confirmar(&d, seq);
+            continue;
+        }
+
+        if (diario_pendentes(&d) == 1 || lote_max == 1) {
+            formatar(r, campos, sizeof(campos), &t_amostra);
+            snprintf(pacote, sizeof(pacote), "P2:%s #%lu @%llu+%llu", campos, (unsigned long)seq,
+                     (unsigned long long)t_amostra * 1000, (unsigned long long)(t_ms - t_amostra) * 1000);
+        } else {
+            lote_t lote;
+            lote_iniciar(&lote, pacote, sizeof(pacote), "P2", seq);
+            for (uint32_t s = seq; s - seq < diario_pendentes(&d) && lote.n < lote_max; ++s) {
+                if (s != seq && !diario_ler(&d, s, &r)) break;
+                formatar(r, campos, sizeof(campos), &t_amostra);
+                if (!lote_adicionar(&lote, (uint32_t)((t_ms - t_amostra) / 1000), campos)) break;
+                ultimo = s;
+            }
+        }
+
+        rfm95_packet_t packet = {};
+        size_t len = strlen(pacote);
+        memcpy(packet.message, pacote, len + 1);
+        packet.length = (uint8_t)len;
+        packet.addressed = true;
+        packet.header.net_id = REDE_ID;
+        packet.header.dst = ENDERECO_GATEWAY;
+        packet.header.src = ENDERECO_NO;
+        packet.header.flags = RFM95_FLAG_PEDE_ACK;
+        packet.valid = true;
+
+        uint32_t no_ar = gateway_tempo_no_ar_us((uint8_t)(len + RFM95_HEADER_LEN));
+        t_ms += no_ar / 1000;
+        packet.timestamp_us = (uint64_t)t_ms * 1000;
+        gateway_processar(&packet, packet.timestamp_us);
+
+        res.quadros++;
+        res.bytes += len + RFM95_HEADER_LEN;
+        res.amostras += ultimo + 1 - seq;
+        res.no_ar_us += no_ar;
+
+        uint8_t destino;
+        char ack[16];
+        bool confirmado = false;
+        if (gateway_confirmacao(&destino, ack, sizeof(ack)) && destino == ENDERECO_NO) {
+            uint32_t no_ar_ack = gateway_tempo_no_ar_us((uint8_t)(strlen(ack) + RFM95_HEADER_LEN));
+            res.no_ar_us += no_ar_ack;
+            if (sortear() % 100 >= perda) {
+                t_ms += VIRADA_MS + no_ar_ack / 1000;
+                uint32_t s = strtoul(ack + 2, NULL, 10);
+                if (s >= seq && s <= ultimo) {
+                    diario_confirmar(&d, s);
+                    confirmado = true;
+                }
+            }
+        }
+        if (!confirmado) {
+            res.acks_perdidos++;
+            res.repetidas += ultimo + 1 - seq;
+            // A janela cobre a maior confirmação, como em send_pending
+            t_ms += ENLACE_ACK_MS + gateway_tempo_no_ar_us(RFM95_HEADER_LEN + RFM95_MENSAGEM_MAX - 1) / 1000 +
+                    ENLACE_REENVIO_MS;
+        }
+        diario_servico(&d, (uint32_t)t_ms);
+    }
+    res.total_ms = t_ms - inicio_ms;
+    return res;
+}
+
+static void configurar_gateway() {
+    // SF7, BW 125 kHz, CR 4/5, CRC ligado (perfil do nó e do gateway)
+    rfm95_profile_t perfil = {};
+    perfil.modem_config1 = 0x72;
+    perfil.modem_config2 = 0x74;
+    perfil.modem_config3 = 0x04;
+    gateway_init();
+    gateway_set_perfil(&perfil);
+}
+
+// Cada amostra chega uma vez; os reenvios de ACK perdido são descartados
+static void verificar_reenvio(uint32_t n, unsigned perda) {
+    flash_emulador().reiniciar();
+    configurar_gateway();
+
+    diario_t d;
+    diario_init(&d);
+    uint64_t t_ms = 0;
+    acumular(d, n, t_ms);
+    reenvio_t res = reenviar(d, t_ms, LOTE_MAX, perda);
+    fflush(stdout);
+
+    const gateway_estado_t *gw = gateway_estado();
+    verificar("reenvio", diario_pendentes(&d) == 0 && d.stats.perdidos == 0 &&
+                         res.amostras - gw->duplicadas == n && gw->duplicadas == res.repetidas,
+              fmt("%lu amostras em %lu quadros, %lu repetidas descartadas", n, res.quadros, gw->duplicadas));
+}
+
+// Amostras de um boot anterior reenviadas depois do reboot. Datadas no
+// relógio do nó (o do histórico mais o tempo desde o boot), as idades dos
+// lotes seguem o intervalo entre as amostras e a mais nova fica com só o
+// tempo deste boot, sem dar a volta nos ms desde o boot
+static void verificar_idade() {
+    flash_emulador().reiniciar();
+
+    diario_t d;
+    historico_t h;
+    diario_init(&d);
+    historico_init(&h);
+
+    // Boot anterior: parte do histórico vai para a flash, o bloco em
+    // montagem se perde no reboot
+    const uint32_t n = 300, boot_ms = 5000;
+    std::vector<uint64_t> t_amostra(n);
+    uint32_t s0 = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t desde_boot = boot_ms + i * INTERVALO_MS;
+        t_amostra[i] = (uint64_t)h.relogio_s * 1000 + desde_boot;
+        uint32_t seq = gravar_amostra(d, i, t_amostra[i]);
+        if (i == 0) s0 = seq;
+        int16_t valores[2] = { temperatura(i), umidade(i) };
+        historico_gravar(&h, desde_boot / 1000, valores, 2);
+        if (!diario_servico(&d, desde_boot)) historico_servico(&h);
+    }
+    drenar(d, t_amostra[n - 1] + DIARIO_ATRASO_MS);
+    while (historico_servico(&h)) {}
+
+    diario_t r;
+    historico_t h2;
+    diario_init(&r);
+    historico_init(&h2);
+    uint32_t relogio_flash = h2.relogio_s;
+    retomar_relogio(r, h2);
+
+    // 3 s depois do boot os pendentes saem em lotes
+    const uint32_t desde_boot = 3000;
+    uint64_t agora_ms = (uint64_t)h2.relogio_s * 1000 + desde_boot;
+    uint32_t conferidas = 0, erradas = 0, idade_nova = 0;
+    char pacote[RFM95_MENSAGEM_MAX], campos[64];
+    while (diario_pendentes(&r) > 0) {
+        uint32_t seq = diario_cauda(&r);
+        diario_registro_t reg;
+        if (!diario_ler(&r, seq, &reg)) {
+            diario_confirmar(&r, seq);
+            continue;
+        }
+        lote_t lote;
+        lote_iniciar(&lote, pacote, sizeof(pacote), "P2", seq);
+        for (uint32_t s = seq; s - seq < diario_pendentes(&r); ++s) {
+            if (s != seq && !diario_ler(&r, s, &reg)) break;
+            uint64_t t;
+            formatar(reg, campos, sizeof(campos), &t);
+            uint64_t idade = agora_ms > t ? agora_ms - t : 0;
+            if (!lote_adicionar(&lote, (uint32_t)(idade / 1000), campos)) break;
+        }
+
+        lote_leitor_t leitor;
+        uint32_t s = seq, idade_s = 0;
+        if (!lote_abrir(&leitor, pacote)) break;
+        while (lote_proxima(&leitor, &s, &idade_s, campos, sizeof(campos))) {
+            uint32_t i = s - s0;
+            if (i >= n || idade_s != (agora_ms - t_amostra[i]) / 1000) erradas++;
+            if (i == n - 1) idade_nova = idade_s;
+            conferidas++;
+        }
+        diario_confirmar(&r, s);
+    }
+
+    // A mais nova: o tempo deste boot mais a fração do segundo do relógio
+    bool nova = idade_nova >= desde_boot / 1000 && idade_nova <= desde_boot / 1000 + 1;
+    verificar("idade_reboot", relogio_flash * 1000ull <= t_amostra[n - 1] && conferidas == n && erradas == 0 && nova,
+              fmt("%lu amostras do boot anterior, %lu idades erradas, a mais nova com %lu s", conferidas, erradas,
+                  idade_nova));
+}
+
+// Vazão do reenvio pelo tamanho do lote
+static void benchmark(uint32_t n, unsigned perda) {
+    static const unsigned lotes[] = { 1, 2, 4, 8 };
+    double base = 0;
+
+    fprintf(stderr, "\nreenvio de %lu amostras, %u%% de ACKs perdidos (SF7, BW 125 kHz, CR 4/5)\n",
+            (unsigned long)n, perda);
+    fprintf(stderr, "%5s %8s %8s %10s %10s %11s %7s\n",
+            "lote", "quadros", "bytes", "no ar (s)", "total (s)", "amostras/s", "ganho");
+    for (unsigned lote : lotes) {
+        flash_emulador().reiniciar();
+        configurar_gateway();
+        aleatorio = 1;
+
+        diario_t d;
+        diario_init(&d);
+        uint64_t t_ms = 0;
+        acumular(d, n, t_ms);
+        reenvio_t res = reenviar(d, t_ms, lote, perda);
+        fflush(stdout);
+
+        double taxa = res.total_ms ? n * 1000.0 / res.total_ms : 0.0;
+        if (lote == 1) base = taxa;
+        fprintf(stderr, "%5u %8lu %8lu %10.2f %10.1f %11.2f %6.2fx\n", lote, (unsigned long)res.quadros,
+                (unsigned long)res.bytes, res.no_ar_us / 1e6, res.total_ms / 1000.0, taxa,
+                base > 0 ? taxa / base : 0.0);
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t amostras = 2000;
+    unsigned perda = 10;
+    bool silencioso = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) amostras = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc) perda = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-q")) silencioso = true;
+        else { uso(argv[0]); return 1; }
+    }
+    if (amostras == 0 || amostras > DIARIO_CAPACIDADE || perda >= 100) {
+        uso(argv[0]);
+        return 1;
+    }
+    if (silencioso && !freopen("/dev/null", "w", stdout)) return 1;
+
+    verificar_recuperacao();
+    verificar_corte();
+    verificar_recusa();
+    verificar_desgaste();
+    verificar_transbordo();
+    verificar_reenvio(amostras, perda);
+    verificar_idade();
+    benchmark(amostras, perda);
+
+    if (falhas) fprintf(stderr, "\n%d verificações falharam\n", falhas);
+    return falhas ? 1 : 0;
+}
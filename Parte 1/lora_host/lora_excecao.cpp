@@ -0,0 +1,122 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+extern "C" {
+#include "inc/excecao.h"
+}
+
+static void uso(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opções] serie.csv [serie.csv...]\n"
+        "  -t décimos     banda da temperatura (padrão: 2 = 0,2 °C)\n"
+        "  -u décimos     banda da umidade (padrão: 10 = 1 %%)\n"
+        "  -s segundos    silêncio máximo (padrão: 600)\n"
+        "  -i segundos    intervalo mínimo entre envios (padrão: 60)\n",
+        prog);
+}
+
+// Relatório de um nó ao longo da série
+struct Relatorio {
+    excecao_t e;
+    uint64_t primeiro_us = 0, ultimo_us = 0;
+};
+
+static int32_t bandas[2] = { 2, 10 };
+static uint32_t silencio_ms = 600 * 1000, intervalo_ms = 60 * 1000;
+
+// "12.3" / "-0.4" -> décimos; vazio: sem valor
+static bool ler_decimos(const char *s, int32_t &v) {
+    if (!*s) return false;
+    bool negativo = *s == '-';
+    if (negativo) ++s;
+    long inteiro = strtol(s, (char **)&s, 10);
+    long fracao = (*s == '.' && s[1] >= '0' && s[1] <= '9') ? s[1] - '0' : 0;
+    v = (int32_t)(inteiro * 10 + fracao);
+    if (negativo) v = -v;
+    return true;
+}
+
+// Linha do CSV do lora_ingest: t_us,gateway,no,seq,rssi,snr,temp,umid,flags
+static bool processar_csv(const char *caminho, std::map<unsigned, Relatorio> &nos) {
+    FILE *f = fopen(caminho, "r");
+    if (!f) {
+        perror(caminho);
+        return false;
+    }
+
+    char linha[256];
+    while (fgets(linha, sizeof(linha), f)) {
+        const char *campos[9];
+        int n = 0;
+        char *p = linha;
+        linha[strcspn(linha, "\r\n")] = '\0';
+        while (n < 9) {
+            campos[n++] = p;
+            char *virgula = strchr(p, ',');
+            if (!virgula) break;
+            *virgula = '\0';
+            p = virgula + 1;
+        }
+        if (n < 9 || campos[0][0] < '0' || campos[0][0] > '9') continue;   // Cabeçalho
+
+        uint64_t t_us = strtoull(campos[0], nullptr, 10);
+        unsigned no = (unsigned)strtoul(campos[2], nullptr, 10);
+        int32_t valores[2] = { 0, 0 };
+        bool valida = ler_decimos(campos[6], valores[0]) && ler_decimos(campos[7], valores[1]);
+
+        auto it = nos.find(no);
+        if (it == nos.end()) {
+            it = nos.emplace(no, Relatorio()).first;
+            excecao_init(&it->second.e, 2, bandas, silencio_ms, intervalo_ms);
+            it->second.primeiro_us = t_us;
+        }
+        it->second.ultimo_us = t_us;
+        excecao_avaliar(&it->second.e, valores, valida, (uint32_t)(t_us / 1000));
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::map<unsigned, Relatorio> nos;
+    bool algum = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) bandas[0] = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-u") && i + 1 < argc) bandas[1] = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) silencio_ms = (uint32_t)atoi(argv[++i]) * 1000;
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) intervalo_ms = (uint32_t)atoi(argv[++i]) * 1000;
+        else if (argv[i][0] == '-') { uso(argv[0]); return 1; }
+        else {
+            if (!processar_csv(argv[i], nos)) return 1;
+            algum = true;
+        }
+    }
+    if (!algum) {
+        uso(argv[0]);
+        return 1;
+    }
+
+    printf("bandas: T %d.%d C, U %d.%d %%  silêncio %u s  intervalo %u s\n",
+           bandas[0] / 10, bandas[0] % 10, bandas[1] / 10, bandas[1] % 10,
+           silencio_ms / 1000, intervalo_ms / 1000);
+    printf("%4s %9s %9s %9s %9s %9s %9s\n", "no", "amostras", "enviadas", "mudanca", "silencio", "limitadas", "economia");
+
+    uint64_t total = 0, enviadas = 0;
+    for (const auto &par : nos) {
+        const excecao_t &e = par.second.e;
+        double economia = e.avaliadas ? 100.0 * (e.avaliadas - e.enviadas) / e.avaliadas : 0.0;
+        printf("%4u %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %8.1f%%\n",
+               par.first, e.avaliadas, e.enviadas, e.por_mudanca, e.por_silencio, e.limitadas, economia);
+        total += e.avaliadas;
+        enviadas += e.enviadas;
+    }
+    if (total > 0)
+        printf("total: %" PRIu64 " amostras, %" PRIu64 " envios (%.1f%% a menos)\n",
+               total, enviadas, 100.0 * (total - enviadas) / total);
+    return 0;
+}
@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "inc/flash_emulador.h"
+
+extern "C" {
+#include "inc/diario.h"
+#include "inc/historico.h"
+}
+
+static void uso(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opções] [serie.csv]\n"
+        "  -d dias            dias da série sintética (padrão: 90)\n"
+        "  -i segundos        intervalo da série sintética (padrão: 60)\n"
+        "  -n no              nó do CSV do lora_ingest (padrão: o primeiro)\n"
+        "  -c consultas       consultas por instante no benchmark (padrão: 2000)\n",
+        prog);
+}
+
+struct Amostra {
+    uint32_t t;             // Segundos desde o boot do nó
+    int16_t v[2];           // Temperatura e umidade, em décimos
+};
+
+static uint32_t aleatorio = 1;
+
+static uint32_t sortear() {
+    aleatorio = aleatorio * 1103515245u + 12345u;
+    return (aleatorio >> 16) & 0x7FFF;
+}
+
+// Série com o jeito da saída filtrada do AHT20: ciclo diário, deriva lenta,
+// pouco ruído, o intervalo com a folga das rodadas e uma falha de leitura
+// de vez em quando
+static std::vector<Amostra> sintetica(uint32_t dias, uint32_t intervalo_s) {
+    std::vector<Amostra> serie;
+    double deriva_t = 0, deriva_u = 0;
+    for (uint64_t t_ms = 0; t_ms < (uint64_t)dias * 86400000; t_ms += intervalo_s * 1000 + sortear() % 600 - 300) {
+        double dia = 2 * M_PI * (t_ms / 1000.0) / 86400;
+        deriva_t += ((int)(sortear() % 3) - 1) * 0.2;
+        deriva_u += ((int)(sortear() % 3) - 1) * 0.5;
+        deriva_t *= 0.999;
+        deriva_u *= 0.999;
+        Amostra a;
+        a.t = (uint32_t)(t_ms / 1000);
+        a.v[0] = (int16_t)lround(240 + 45 * sin(dia) + deriva_t);
+        a.v[1] = (int16_t)lround(600 - 90 * sin(dia) + deriva_u);
+        if (sortear() % 5000 == 0) a.v[0] = a.v[1] = SERIE_INVALIDO;
+        serie.push_back(a);
+    }
+    return serie;
+}
+
+// "12.3" / "-0.4" -> décimos; vazio: sem valor
+static bool ler_decimos(const char *s, int16_t &v) {
+    if (!*s) return false;
+    bool negativo = *s == '-';
+    if (negativo) ++s;
+    long inteiro = strtol(s, (char **)&s, 10);
+    long fracao = (*s == '.' && s[1] >= '0' && s[1] <= '9') ? s[1] - '0' : 0;
+    v = (int16_t)(negativo ? -(inteiro * 10 + fracao) : inteiro * 10 + fracao);
+    return true;
+}
+
+// Linha do CSV do lora_ingest: t_us,gateway,no,seq,rssi,snr,temp,umid,flags
+static bool ler_csv(const char *caminho, int no, std::vector<Amostra> &serie) {
+    FILE *f = fopen(caminho, "r");
+    if (!f) {
+        perror(caminho);
+        return false;
+    }
+
+    char linha[256];
+    uint64_t inicio_us = 0;
+    while (fgets(linha, sizeof(linha), f)) {
+        const char *campos[9];
+        int n = 0;
+        char *p = linha;
+        linha[strcspn(linha, "\r\n")] = '\0';
+        while (n < 9) {
+            campos[n++] = p;
+            char *virgula = strchr(p, ',');
+            if (!virgula) break;
+            *virgula = '\0';
+            p = virgula + 1;
+        }
+        if (n < 9 || campos[0][0] < '0' || campos[0][0] > '9') continue;   // Cabeçalho
+
+        uint64_t t_us = strtoull(campos[0], nullptr, 10);
+        int este = (int)strtoul(campos[2], nullptr, 10);
+        if (no < 0) no = este;
+        if (este != no) continue;
+        if (serie.empty()) inicio_us = t_us;
+        if (t_us < inicio_us) continue;
+
+        Amostra a;
+        a.t = (uint32_t)((t_us - inicio_us) / 1000000);
+        if (!ler_decimos(campos[6], a.v[0]) || !ler_decimos(campos[7], a.v[1])) a.v[0] = a.v[1] = SERIE_INVALIDO;
+        if (!serie.empty() && a.t < serie.back().t) continue;
+        serie.push_back(a);
+    }
+    fclose(f);
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// Histórico na flash emulada
+// ---------------------------------------------------------------------
+
+struct Lida {
+    uint32_t t;
+    int16_t v[2];
+    bool operator==(const Lida &o) const { return t == o.t && v[0] == o.v[0] && v[1] == o.v[1]; }
+};
+
+// Grava a série como o laço do nó: uma amostra e um serviço por vez. As
+// amostras aceitas vão para 'ref' no instante do histórico
+static void alimentar(historico_t &h, const std::vector<Amostra> &serie, std::vector<Lida> &ref) {
+    for (const Amostra &a : serie) {
+        if (historico_gravar(&h, a.t, a.v, 2)) ref.push_back({ historico_instante(&h, a.t), { a.v[0], a.v[1] } });
+        historico_servico(&h);
+    }
+}
+
+// Tudo o que uma consulta a partir de t devolve
+static std::vector<Lida> consultar(const historico_t &h, uint32_t t) {
+    std::vector<Lida> saida;
+    historico_cursor_t c;
+    if (!historico_buscar(&h, t, &c)) return saida;
+    Lida l;
+    int16_t v[SERIE_GRANDEZAS_MAX];
+    uint8_t n;
+    while (historico_proxima(&h, &c, &l.t, v, &n)) {
+        l.v[0] = v[0];
+        l.v[1] = n > 1 ? v[1] : 0;
+        saida.push_back(l);
+    }
+    return saida;
+}
+
+// 'lidas' é um trecho final de 'ref' (a volta descarta só as mais antigas)
+static bool sufixo(const std::vector<Lida> &lidas, const std::vector<Lida> &ref) {
+    if (lidas.empty() || lidas.size() > ref.size()) return false;
+    return std::equal(lidas.begin(), lidas.end(), ref.end() - lidas.size());
+}
+
+static int falhas = 0;
+
+static void verificar(const char *nome, bool ok, const char *detalhe) {
+    fprintf(stderr, "%-14s %s  %s\n", nome, ok ? "ok     " : "FALHOU ", detalhe);
+    if (!ok) falhas++;
+}
+
+// Primeira amostra em t ou depois, pela busca binária na referência
+static size_t limite(const std::vector<Lida> &ref, uint32_t t) {
+    return std::lower_bound(ref.begin(), ref.end(), t, [](const Lida &l, uint32_t x) { return l.t < x; }) - ref.begin();
+}
+
+// Texto de historico_formatar de volta em amostras (duas grandezas)
+static bool ler_texto(const char *p, std::vector<Lida> &lidas) {
+    if (strncmp(p, "h=", 2) != 0) return false;
+    p += 2;
+    uint32_t t = 0;
+    for (bool primeira = true; *p; primeira = false) {
+        char *fim;
+        unsigned long x = strtoul(p, &fim, 10);
+        if (fim == p) return false;
+        t = primeira ? (uint32_t)x : t + (uint32_t)x;
+        Lida l = { t, { 0, 0 } };
+        p = fim;
+        for (int i = 0; i < 2; ++i) {
+            if (*p++ != (i ? ',' : ':')) return false;
+            if (*p == '-') {
+                l.v[i] = SERIE_INVALIDO;
+                p++;
+                continue;
+            }
+            l.v[i] = (int16_t)strtol(p, &fim, 10);
+            if (fim == p) return false;
+            p = fim;
+        }
+        lidas.push_back(l);
+        if (*p == ' ') p++;
+        else if (*p) return false;
+    }
+    return true;
+}
+
+static void verificar_tudo(uint32_t intervalo_s) {
+    FlashEmulador &flash = flash_emulador();
+    char detalhe[160];
+
+    // Mais de uma volta na região
+    flash.reiniciar();
+    historico_t h;
+    historico_init(&h);
+    std::vector<Lida> ref;
+    std::vector<Amostra> serie = sintetica(400, intervalo_s);
+    alimentar(h, serie, ref);
+
+    std::vector<Lida> tudo = consultar(h, 0);
+    snprintf(detalhe, sizeof(detalhe), "%zu de %zu amostras retidas após %lu blocos",
+             tudo.size(), ref.size(), (unsigned long)h.stats.blocos);
+    verificar("sem_perdas", h.stats.blocos > HISTORICO_BLOCOS && sufixo(tudo, ref) &&
+                            tudo.size() >= (size_t)(HISTORICO_SETORES - 2) * HISTORICO_POR_SETOR * 100, detalhe);
+
+    // Consultas pelo índice contra a busca na referência retida
+    size_t erradas = 0;
+    for (int i = 0; i < 500; ++i) {
+        uint32_t t = tudo.front().t - 100 + (uint32_t)(((uint64_t)sortear() << 15 | sortear()) %
+                                                       (tudo.back().t - tudo.front().t + 200));
+        historico_cursor_t c;
+        size_t esperado = limite(tudo, t);
+        Lida l;
+        int16_t v[SERIE_GRANDEZAS_MAX];
+        uint8_t n;
+        bool achou = historico_buscar(&h, t, &c) && historico_proxima(&h, &c, &l.t, v, &n);
+        if (achou) {
+            l.v[0] = v[0];
+            l.v[1] = v[1];
+        }
+        bool certo = esperado == tudo.size() ? !achou : achou && l == tudo[esperado];
+        if (!certo) erradas++;
+    }
+    snprintf(detalhe, sizeof(detalhe), "%zu de 500 consultas diferentes da referência", erradas);
+    verificar("consulta", erradas == 0, detalhe);
+
+    // Consulta pelo rádio: páginas de texto que cabem no quadro, cada uma
+    // a partir do fim da anterior, contra a referência
+    char texto[180];
+    size_t pagina_erradas = 0, paginas = 0, lidas_texto = 0;
+    for (int i = 0; i < 20; ++i) {
+        uint32_t t = tudo[(((size_t)sortear() << 15) | sortear()) % tudo.size()].t;
+        size_t esperado = limite(tudo, t);
+        for (int p = 0; p < 10 && esperado < tudo.size(); ++p, ++paginas) {
+            std::vector<Lida> lidas;
+            uint8_t n = historico_formatar(&h, t, texto, sizeof(texto));
+            bool certo = n > 0 && strlen(texto) < sizeof(texto) && ler_texto(texto, lidas) && lidas.size() == n &&
+                         esperado + n <= tudo.size() && std::equal(lidas.begin(), lidas.end(), tudo.begin() + esperado);
+            if (!certo) {
+                pagina_erradas++;
+                break;
+            }
+            lidas_texto += n;
+            esperado += n;
+            t = lidas.back().t + 1;
+        }
+    }
+    bool vazia = historico_formatar(&h, tudo.back().t + 1, texto, sizeof(texto)) == 0 && texto[0] == '\0';
+    snprintf(detalhe, sizeof(detalhe), "%zu de %zu páginas diferentes da referência, %.1f amostras por página",
+             pagina_erradas, paginas, paginas ? (double)lidas_texto / paginas : 0.0);
+    verificar("texto", pagina_erradas == 0 && paginas > 0 && vazia, detalhe);
+
+    // Reboot: o bloco em RAM se perde, o resto continua e o relógio segue
+    // à frente
+    historico_t r;
+    historico_init(&r);
+    std::vector<Lida> depois = consultar(r, 0);
+    bool prefixo = !depois.empty() && depois.size() < tudo.size() &&
+                   std::equal(depois.begin(), depois.end(), tudo.begin());
+    // As novas amostras recomeçam do boot e seguem depois das antigas
+    std::vector<Lida> ref2 = depois;
+    std::vector<Amostra> mais(serie.begin(), serie.begin() + 1000);
+    alimentar(r, mais, ref2);
+    std::vector<Lida> tudo2 = consultar(r, 0);
+    snprintf(detalhe, sizeof(detalhe), "%zu amostras retomadas, relógio em %lu s (última %lu s)",
+             depois.size(), (unsigned long)r.relogio_s, (unsigned long)(depois.empty() ? 0 : depois.back().t));
+    verificar("reboot", prefixo && r.relogio_s > depois.back().t && ref2.size() == depois.size() + mais.size() &&
+                        sufixo(tudo2, ref2) && tudo2.size() > mais.size(), detalhe);
+
+    // Programação interrompida: só o bloco cortado some
+    flash.reiniciar();
+    historico_init(&h);
+    ref.clear();
+    std::vector<Amostra> curta(serie.begin(), serie.begin() + 3000);
+    uint32_t blocos = 0;
+    for (const Amostra &a : curta) {
+        if (historico_gravar(&h, a.t, a.v, 2)) ref.push_back({ historico_instante(&h, a.t), { a.v[0], a.v[1] } });
+        // Corta a programação do quinto bloco
+        if (h.stats.blocos == 5 && blocos == 4) flash.cortar_proxima(100);
+        blocos = h.stats.blocos;
+        historico_servico(&h);
+    }
+    historico_init(&r);
+    depois = consultar(r, 0);
+    size_t faltando = 0;
+    bool ordem = true;
+    for (size_t i = 0, j = 0; i < depois.size(); ++i) {
+        while (j < ref.size() && !(ref[j] == depois[i])) {
+            ++j;
+            ++faltando;
+        }
+        if (j == ref.size()) ordem = false;
+        else ++j;
+    }
+    snprintf(detalhe, sizeof(detalhe), "%zu amostras perdidas (bloco cortado)", faltando);
+    verificar("corte", ordem && faltando > 0 && faltando < 300, detalhe);
+
+    // Flash recusada pelo flash_safe_execute: o bloco continua no buffer e
+    // vai na próxima chamada do serviço, sem perder amostras
+    flash.reiniciar();
+    historico_init(&h);
+    ref.clear();
+    blocos = 0;
+    for (const Amostra &a : curta) {
+        if (historico_gravar(&h, a.t, a.v, 2)) ref.push_back({ historico_instante(&h, a.t), { a.v[0], a.v[1] } });
+        if (h.stats.blocos == 5 && blocos == 4) flash.recusar_proximas(2);
+        blocos = h.stats.blocos;
+        historico_servico(&h);
+    }
+    historico_init(&r);
+    depois = consultar(r, 0);
+    bool inicio = !depois.empty() && depois.size() < ref.size() && std::equal(depois.begin(), depois.end(), ref.begin());
+    snprintf(detalhe, sizeof(detalhe), "%lu operações recusadas, %zu de %zu amostras retomadas (o resto em RAM)",
+             (unsigned long)h.stats.falhas, depois.size(), ref.size());
+    verificar("recusa", h.stats.falhas == 2 && inicio && ref.size() - depois.size() < 300, detalhe);
+
+    snprintf(detalhe, sizeof(detalhe), "%llu conflitos, %llu operações desalinhadas",
+             (unsigned long long)flash.conflitos(), (unsigned long long)flash.desalinhados());
+    verificar("flash", flash.conflitos() == 0 && flash.desalinhados() == 0, detalhe);
+}
+
+// ---------------------------------------------------------------------
+// Compressão e consultas
+// ---------------------------------------------------------------------
+
+// Impede que o compilador descarte as consultas medidas
+static volatile uint64_t sumidouro;
+
+static double agora_s() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void benchmark(const std::vector<Amostra> &serie, unsigned consultas) {
+    FlashEmulador &flash = flash_emulador();
+    flash.reiniciar();
+    historico_t h;
+    historico_init(&h);
+    std::vector<Lida> ref;
+    alimentar(h, serie, ref);
+    if (ref.size() < 2) return;
+
+    uint32_t blocos = h.stats.blocos + 1;
+    double bytes = blocos * (double)SERIE_BLOCO_BYTES;
+    double por_amostra = bytes / ref.size();
+    double periodo_s = (double)(ref.back().t - ref.front().t) / (ref.size() - 1);
+    double capacidade_dias = (HISTORICO_SETORES - 1) * HISTORICO_SETOR_BYTES / por_amostra * periodo_s / 86400;
+
+    fprintf(stderr, "\n%zu amostras em %.1f dias, uma a cada %.1f s\n", ref.size(),
+            (ref.back().t - ref.front().t) / 86400.0, periodo_s);
+    fprintf(stderr, "%u blocos: %.2f bytes/amostra (%.1f bits), %.1fx menor que o registro de 10 bytes"
+                    " e %.1fx menor que o do diário\n",
+            blocos, por_amostra, por_amostra * 8, 10 / por_amostra, DIARIO_REGISTRO_BYTES / por_amostra);
+    fprintf(stderr, "região de %u KB: %.0f dias de histórico neste ritmo\n",
+            HISTORICO_SETORES * HISTORICO_SETOR_BYTES / 1024, capacidade_dias);
+
+    // Decodificação sequencial de tudo
+    double inicio = agora_s();
+    size_t total = consultar(h, 0).size();
+    double seq_s = agora_s() - inicio;
+    fprintf(stderr, "decodificação sequencial: %.1f M amostras/s\n", total / seq_s / 1e6);
+
+    // Primeira amostra em t: pelo índice e varrendo desde o começo
+    std::vector<uint32_t> instantes;
+    for (unsigned i = 0; i < consultas; ++i) {
+        instantes.push_back(ref.front().t + (uint32_t)(((uint64_t)sortear() << 15 | sortear()) %
+                                                       (ref.back().t - ref.front().t + 1)));
+    }
+    inicio = agora_s();
+    for (uint32_t t : instantes) {
+        historico_cursor_t c;
+        if (historico_buscar(&h, t, &c)) sumidouro += c.bloco;
+    }
+    double indice_s = agora_s() - inicio;
+
+    // A varredura é lenta: uma amostra das consultas basta
+    size_t varridas = std::max<size_t>(instantes.size() / 20, 1);
+    inicio = agora_s();
+    for (size_t i = 0; i < varridas; ++i) {
+        uint32_t t = instantes[i];
+        historico_cursor_t c;
+        uint32_t ts;
+        int16_t v[SERIE_GRANDEZAS_MAX];
+        uint8_t n;
+        if (!historico_buscar(&h, 0, &c)) break;
+        while (historico_proxima(&h, &c, &ts, v, &n) && ts < t) {}
+        sumidouro += ts;
+    }
+    double varredura_s = agora_s() - inicio;
+    fprintf(stderr, "consulta por instante: %.2f us pelo índice, %.1f us varrendo (%.0fx)\n",
+            indice_s / consultas * 1e6, varredura_s / varridas * 1e6,
+            indice_s > 0 ? (varredura_s / varridas) / (indice_s / consultas) : 0.0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t dias = 90, intervalo_s = 60;
+    unsigned consultas = 2000;
+    int no = -1;
+    const char *csv = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-d") && i + 1 < argc) dias = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) intervalo_s = (uint32_t)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) no = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) consultas = (unsigned)atoi(argv[++i]);
+        else if (argv[i][0] == '-' || csv) { uso(argv[0]); return 1; }
+        else csv = argv[i];
+    }
+    if (dias == 0 || intervalo_s < 2 || consultas == 0) {
+        uso(argv[0]);
+        return 1;
+    }
+
+    verificar_tudo(intervalo_s);
+
+    std::vector<Amostra> serie;
+    if (csv) {
+        if (!ler_csv(csv, no, serie)) return 1;
+    } else {
+        serie = sintetica(dias, intervalo_s);
+    }
+    benchmark(serie, consultas);
+
+    if (falhas) fprintf(stderr, "\n%d verificações falharam\n", falhas);
+    return falhas ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "inc/captura_arquivo.h"
+#include "inc/colunar.h"
+#include "inc/decodificador.h"
+#include "inc/dedup.h"
+#include "inc/fila.h"
+#include "inc/fonte.h"
+
+typedef Fila<std::vector<Registro>> FilaDecodificada;
+
+static void uso(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opções] fonte [fonte...]\n"
+        "  fonte              tty do gateway (/dev/ttyACM0) ou arquivo de replay\n"
+        "  -o arquivo.lcol    saída colunar\n"
+        "  -c arquivo.csv     saída em série temporal (CSV)\n"
+        "  -r arquivo.lcap    acrescenta os quadros brutos das linhas CAP:\n"
+        "  -j threads         threads de decodificação (padrão: núcleos)\n"
+        "  -w ms              janela de deduplicação (padrão: 30000)\n"
+        "  -b repetições      benchmark: reinjeta as fontes em memória\n",
+        prog);
+}
+
+static bool carregar(const std::string &caminho, std::string &conteudo) {
+    std::ifstream f(caminho, std::ios::binary);
+    if (!f) {
+        perror(caminho.c_str());
+        return false;
+    }
+    std::ostringstream ss;
+    ss << f.rdbuf();
+    conteudo = ss.str();
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::string saida_lcol, saida_csv, saida_lcap;
+    unsigned threads = std::thread::hardware_concurrency();
+    uint64_t janela_us = 30000ULL * 1000;
+    unsigned repeticoes = 0;
+    std::vector<std::string> fontes;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        bool tem_valor = i + 1 < argc;
+        if (!strcmp(a, "-o") && tem_valor) saida_lcol = argv[++i];
+        else if (!strcmp(a, "-c") && tem_valor) saida_csv = argv[++i];
+        else if (!strcmp(a, "-r") && tem_valor) saida_lcap = argv[++i];
+        else if (!strcmp(a, "-j") && tem_valor) threads = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(a, "-w") && tem_valor) janela_us = strtoull(argv[++i], nullptr, 10) * 1000;
+        else if (!strcmp(a, "-b") && tem_valor) repeticoes = (unsigned)atoi(argv[++i]);
+        else if (a[0] == '-') { uso(argv[0]); return 1; }
+        else fontes.push_back(a);
+    }
+    if (fontes.empty()) {
+        uso(argv[0]);
+        return 1;
+    }
+    if (threads == 0) threads = 1;
+
+    // No benchmark as capturas são carregadas antes para medir só o pipeline
+    std::vector<std::string> conteudos;
+    if (repeticoes > 0) {
+        for (const auto &f : fontes) {
+            conteudos.emplace_back();
+            if (!carregar(f, conteudos.back())) return 1;
+        }
+    }
+
+    EscritorColunar lcol;
+    EscritorCsv csv;
+    EscritorCaptura lcap;
+    if (!saida_lcol.empty() && !lcol.abrir(saida_lcol)) return 1;
+    if (!saida_csv.empty() && !csv.abrir(saida_csv)) return 1;
+    if (!saida_lcap.empty() && !lcap.abrir(saida_lcap)) return 1;
+
+    FilaBruta fila_bruta(threads * 8);
+    FilaDecodificada fila_decodificada(threads * 8);
+
+    // Pool de decodificação
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&] {
+            std::vector<RegistroBruto> lote;
+            while (fila_bruta.pop(lote)) {
+                std::vector<Registro> saida(lote.size());
+                for (size_t i = 0; i < lote.size(); ++i) decodificar(lote[i], saida[i]);
+                fila_decodificada.push(std::move(saida));
+            }
+        });
+    }
+
+    // Deduplicação e escrita em uma única thread
+    uint64_t total = 0, unicos = 0, duplicados = 0;
+    std::thread escritor([&] {
+        Deduplicador dedup(janela_us);
+        std::vector<Registro> lote;
+        while (fila_decodificada.pop(lote)) {
+            for (const Registro &reg : lote) {
+                total++;
+                if (!dedup.novo(reg)) continue;
+                unicos++;
+                lcol.adicionar(reg);
+                csv.adicionar(reg);
+            }
+        }
+        duplicados = dedup.duplicados();
+    });
+
+    auto inicio = std::chrono::steady_clock::now();
+
+    // Uma thread por gateway
+    Barreira barreira(fontes.size());
+    std::vector<std::thread> leitores;
+    for (size_t g = 0; g < fontes.size(); ++g) {
+        leitores.emplace_back([&, g] {
+            if (repeticoes == 0) {
+                ler_fonte(fontes[g], (uint16_t)g, fila_bruta, saida_lcap.empty() ? nullptr : &lcap);
+                return;
+            }
+            // Cada repetição cai fora da janela da anterior; a barreira evita
+            // que um gateway adiantado expire as chaves dos demais
+            for (unsigned r = 0; r < repeticoes; ++r) {
+                ler_memoria(conteudos[g], (uint16_t)g, (uint64_t)r * 2 * (janela_us + 1), fila_bruta);
+                barreira.aguardar();
+            }
+        });
+    }
+
+    for (auto &t : leitores) t.join();
+    fila_bruta.fechar();
+    for (auto &t : pool) t.join();
+    fila_decodificada.fechar();
+    escritor.join();
+
+    lcol.fechar();
+    csv.fechar();
+    lcap.fechar();
+
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    fprintf(stderr, "pacotes: %" PRIu64 "  únicos: %" PRIu64 "  duplicados: %" PRIu64 "\n",
+            total, unicos, duplicados);
+    if (!saida_lcap.empty()) fprintf(stderr, "quadros capturados: %" PRIu64 "\n", lcap.registros());
+    if (repeticoes > 0) {
+        fprintf(stderr, "benchmark: %u fontes x %u repetições, %u threads, %.3f s, %.0f registros/s\n",
+                (unsigned)fontes.size(), repeticoes, threads, segundos,
+                segundos > 0 ? total / segundos : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "inc/captura_arquivo.h"
+
+extern "C" {
+#include "inc/gateway.h"
+}
+
+static void uso(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opções] captura.lcap [captura.lcap...]\n"
+        "  -n repetições      reprocessa as capturas N vezes (padrão: 1)\n"
+        "  -q                 descarta a saída da aplicação (benchmark)\n"
+        "  -a rede,endereco   aplica o filtro de endereço do gateway\n",
+        prog);
+}
+
+// Filtro de endereço, como configurado por rfm95_set_address/_filter
+static bool filtro = false;
+static unsigned rede_id, endereco;
+
+// Mesmo critério de aceitação de rfm95_receive_message (rfm95_check_frame)
+static bool montar_pacote(const captura_registro_t &reg, rfm95_packet_t &packet, rfm95_stats_t &stats) {
+    if (!(reg.flags & CAPTURA_CRC_OK)) {
+        stats.crc_errors++;
+        return false;
+    }
+    if (!(reg.flags & CAPTURA_HEADER_OK)) {
+        stats.header_errors++;
+        return false;
+    }
+    unsigned cabecalho = filtro ? RFM95_HEADER_LEN : 0;
+    if (reg.length < cabecalho) {
+        stats.header_errors++;
+        return false;
+    }
+    if (reg.length == cabecalho || reg.length - cabecalho >= sizeof(packet.message)) {
+        stats.oversize_drops++;
+        return false;
+    }
+    if (filtro && (reg.payload[0] != rede_id ||
+                   (reg.payload[1] != endereco && reg.payload[1] != RFM95_ADDR_BROADCAST))) {
+        stats.foreign_drops++;
+        return false;
+    }
+    stats.rx_ok++;
+
+    // Mesmas faixas de rfm95_count_link
+    int rssi = (reg.rssi + 140) / 10, snr = (reg.snr + 20) / 5;
+    stats.rssi_hist[rssi < 0 ? 0 : rssi >= RFM95_RSSI_BUCKETS ? RFM95_RSSI_BUCKETS - 1 : rssi]++;
+    stats.snr_hist[snr < 0 ? 0 : snr >= RFM95_SNR_BUCKETS ? RFM95_SNR_BUCKETS - 1 : snr]++;
+
+    uint8_t tamanho = reg.length - cabecalho;
+    memcpy(packet.message, reg.payload + cabecalho, tamanho);
+    packet.message[tamanho] = '\0';
+    packet.length = tamanho;
+    packet.addressed = filtro;
+    if (filtro) {
+        packet.header.net_id = reg.payload[0];
+        packet.header.dst = reg.payload[1];
+        packet.header.src = reg.payload[2];
+        packet.header.flags = reg.payload[3];
+    }
+    packet.timestamp_us = reg.t_us;
+    packet.rssi = reg.rssi;
+    packet.snr = reg.snr;
+    packet.valid = true;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    unsigned repeticoes = 1;
+    bool silencioso = false;
+    std::vector<captura_registro_t> registros;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) repeticoes = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-q")) silencioso = true;
+        else if (!strcmp(argv[i], "-a") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%i,%i", &rede_id, &endereco) != 2) { uso(argv[0]); return 1; }
+            filtro = true;
+        }
+        else if (argv[i][0] == '-') { uso(argv[0]); return 1; }
+        else if (!ler_captura(argv[i], registros)) return 1;
+    }
+    if (registros.empty()) {
+        uso(argv[0]);
+        return 1;
+    }
+    if (silencioso && !freopen("/dev/null", "w", stdout)) return 1;
+
+    gateway_init();
+
+    uint64_t aceitos = 0;
+    rfm95_stats_t stats = {};
+    auto inicio = std::chrono::steady_clock::now();
+    for (unsigned r = 0; r < repeticoes; ++r) {
+        for (const captura_registro_t &reg : registros) {
+            rfm95_packet_t packet;
+            rfm95_profile_t profile = {};
+            profile.freq_hz = reg.freq_hz;
+            profile.modem_config1 = reg.modem_config1;
+            profile.modem_config2 = reg.modem_config2;
+            gateway_set_perfil(&profile);
+
+            // Sem a espera do laço de polling: o tratamento ocorre no RxDone
+            if (montar_pacote(reg, packet, stats) && gateway_processar(&packet, reg.t_us)) aceitos++;
+        }
+    }
+    double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    fflush(stdout);
+
+    uint64_t total = (uint64_t)registros.size() * repeticoes;
+    const gateway_estado_t *gw = gateway_estado();
+    fprintf(stderr, "quadros: %llu  aceitos: %llu  rx_count: %lu\n",
+            (unsigned long long)total, (unsigned long long)aceitos, (unsigned long)gw->rx_count);
+    fprintf(stderr, "replay: %.3f s, %.0f quadros/s\n", segundos, segundos > 0 ? total / segundos : 0.0);
+
+    if (!silencioso) {
+        gateway_imprimir_metricas(&stats);
+        gateway_imprimir_latencias();
+    }
+    return 0;
+}
@@ -0,0 +1,432 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include "inc/relogio_emulador.h"
+
+extern "C" {
+#include "inc/aht20.h"
+#include "inc/sensores.h"
+}
+
+static void uso(const char *prog) {
+    fprintf(stderr,
+        "uso: %s [opções]\n"
+        "  -q                 descarta o log dos sensores\n",
+        prog);
+}
+
+// ---------------------------------------------------------------------
+// Barramento: o AHT20 real não é exercitado aqui, só as suas conversões.
+// Os pinos simulam um escravo segurando SDA até receber alguns pulsos de
+// SCL, para a recuperação do barramento de sensores.c
+// ---------------------------------------------------------------------
+
+#define PINO_SDA 14
+#define PINO_SCL 15
+
+struct Barramento {
+    uint32_t sda_presa = 0;     // Pulsos de SCL até o escravo soltar SDA
+    uint32_t pulsos = 0;        // Subidas de SCL por GPIO
+    bool scl_baixo = false;
+    bool devolvidos = true;     // SDA e SCL de volta ao I2C
+};
+
+static Barramento barramento;
+
+extern "C" {
+
+int i2c_write_timeout_us(i2c_inst_t *, uint8_t, const uint8_t *, size_t, bool, uint) {
+    return PICO_ERROR_GENERIC;
+}
+
+int i2c_read_timeout_us(i2c_inst_t *, uint8_t, uint8_t *, size_t, bool, uint) {
+    return PICO_ERROR_GENERIC;
+}
+
+void gpio_init(uint) {
+    barramento.devolvidos = false;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    if (gpio != PINO_SCL) return;
+    if (out) {
+        barramento.scl_baixo = true;
+    } else if (barramento.scl_baixo) {
+        barramento.scl_baixo = false;
+        barramento.pulsos++;
+        if (barramento.sda_presa > 0) barramento.sda_presa--;
+    }
+}
+
+void gpio_put(uint, bool) {}
+
+bool gpio_get(uint gpio) {
+    return gpio != PINO_SDA || barramento.sda_presa == 0;
+}
+
+void gpio_pull_up(uint) {}
+
+void gpio_set_function(uint, uint fn) {
+    barramento.devolvidos = fn == GPIO_FUNC_I2C;
+}
+
+}
+
+// ---------------------------------------------------------------------
+// Sensores falsos: conversão com duração fixa e um roteiro de coletas
+// ---------------------------------------------------------------------
+
+struct Leitura {
+    sensor_coleta_t resultado;
+    int16_t valor;
+};
+
+struct Falso {
+    explicit Falso(uint32_t ms) : conversao_ms(ms) {}
+
+    uint32_t conversao_ms;
+    bool medindo = false;
+    uint64_t pronto_us = 0;
+    std::deque<Leitura> roteiro;        // Consumido antes do padrão
+    Leitura padrao = {SENSOR_COLETA_OK, 0};
+    bool reset_ok = true;
+    uint32_t disparos = 0, resets = 0;
+};
+
+static Falso falsos[2] = {Falso(40), Falso(80)};
+static std::string ordem_disparos;
+
+template <int N>
+static bool falso_iniciar(i2c_inst_t *) {
+    return true;
+}
+
+template <int N>
+static bool falso_disparar(i2c_inst_t *) {
+    Falso &f = falsos[N];
+    f.disparos++;
+    f.medindo = true;
+    f.pronto_us = relogio_emulador().agora_us() + (uint64_t)f.conversao_ms * 1000;
+    ordem_disparos += (char)('0' + N);
+    return true;
+}
+
+// Coleta antes do fim da conversão devolve ocupado, como o AHT20
+template <int N>
+static sensor_coleta_t falso_coletar(i2c_inst_t *, int16_t *valores) {
+    Falso &f = falsos[N];
+    if (!f.medindo) return SENSOR_COLETA_ERRO;
+    if (relogio_emulador().agora_us() < f.pronto_us) return SENSOR_COLETA_OCUPADO;
+    f.medindo = false;
+
+    Leitura l = f.padrao;
+    if (!f.roteiro.empty()) {
+        l = f.roteiro.front();
+        f.roteiro.pop_front();
+    }
+    valores[0] = l.valor;
+    valores[1] = (int16_t)(l.valor + 1);
+    return l.resultado;
+}
+
+template <int N>
+static bool falso_resetar(i2c_inst_t *) {
+    Falso &f = falsos[N];
+    f.resets++;
+    f.medindo = false;
+    return f.reset_ok;
+}
+
+static const sensor_grandeza_t grandezas_p[] = {
+    { "P", "", 0 },
+};
+
+static const sensor_grandeza_t grandezas_tu[] = {
+    { "T", "C", 1 },
+    { "U", "%", 1 },
+};
+
+// Registrado primeiro, mas com a conversão mais curta: é disparado depois
+static const sensor_driver_t driver_rapido = {
+    "rapido", 1, grandezas_p, 40,
+    falso_iniciar<0>, falso_disparar<0>, falso_coletar<0>, falso_resetar<0>,
+};
+
+static const sensor_driver_t driver_lento = {
+    "lento", 2, grandezas_tu, 80,
+    falso_iniciar<1>, falso_disparar<1>, falso_coletar<1>, falso_resetar<1>,
+};
+
+static Falso &rapido = falsos[0];
+static Falso &lento = falsos[1];
+
+// Grandezas na amostra: P do rápido, depois T e U do lento
+#define G_P 0
+#define G_T 1
+
+static int falhas = 0;
+
+static void verificar(const char *nome, bool ok, const char *detalhe) {
+    fprintf(stderr, "%-14s %s  %s\n", nome, ok ? "ok     " : "FALHOU ", detalhe);
+    if (!ok) falhas++;
+}
+
+// ---------------------------------------------------------------------
+// Conversão em ponto fixo contra o %.1f
+// ---------------------------------------------------------------------
+
+// Texto que o caminho em ponto flutuante daria. Em double as duas
+// fórmulas são exatas (raw * 200 / 2^20 é diádico), então o %.1f do
+// host arredonda o valor exato, empate para o par. "-0.0" vira "0.0":
+// a telemetria nunca mandou zero com sinal.
+static void ref_amostra(char *out, size_t len, uint32_t raw_t, uint32_t raw_h) {
+    double umidade = (double)raw_h * 100.0 / 1048576.0;
+    double temperatura = (double)raw_t * 200.0 / 1048576.0 - 50.0;
+    char t[12], u[12];
+    snprintf(t, sizeof(t), "%.1f", temperatura);
+    snprintf(u, sizeof(u), "%.1f", umidade);
+    snprintf(out, len, "T=%sC U=%s%%", strcmp(t, "-0.0") ? t : "0.0", u);
+}
+
+// Todos os 2^20 valores brutos de cada grandeza (a umidade percorre a
+// faixa ao contrário da temperatura), pelo mesmo caminho do firmware
+static void verificar_conversao() {
+    char ref[48], novo[32], detalhe[128] = "";
+    uint32_t divergentes = 0;
+
+    for (uint32_t raw = 0; raw < (1u << 20); ++raw) {
+        uint32_t raw_h = (1u << 20) - 1 - raw;
+        int16_t valores[2] = { aht20_temperature_x10(raw), aht20_humidity_x10(raw_h) };
+        sensores_formatar_valores(novo, sizeof(novo), &aht20_driver, valores);
+        ref_amostra(ref, sizeof(ref), raw, raw_h);
+        if (strcmp(ref, novo) != 0) {
+            if (divergentes == 0) snprintf(detalhe, sizeof(detalhe), "raw %u: %s | %s", raw, ref, novo);
+            divergentes++;
+        }
+    }
+
+    if (divergentes == 0) snprintf(detalhe, sizeof(detalhe), "2^20 valores brutos iguais ao %%.1f");
+    else {
+        size_t n = strlen(detalhe);
+        snprintf(detalhe + n, sizeof(detalhe) - n, " (%u divergentes)", divergentes);
+    }
+    verificar("conversao", divergentes == 0, detalhe);
+}
+
+// ---------------------------------------------------------------------
+// Agendador das rodadas (sensores.c) com os sensores falsos
+// ---------------------------------------------------------------------
+
+// Passos de 1 ms até uma rodada fechar; false se nenhuma fechou em 30 s
+static bool rodada() {
+    for (int i = 0; i < 30000; ++i) {
+        if (sensores_servico()) return true;
+        relogio_emulador().avancar(1000);
+    }
+    return false;
+}
+
+static int16_t valor(uint8_t grandeza) {
+    int16_t v = 0;
+    sensores_valor(grandeza, &v);
+    return v;
+}
+
+static void esvaziar_fila() {
+    sensores_amostra_t a;
+    while (sensores_consumir(&a)) {}
+}
+
+static void registrar() {
+    sensores_init(NULL, PINO_SDA, PINO_SCL);
+    rapido.padrao = {SENSOR_COLETA_OK, 50};
+    lento.padrao = {SENSOR_COLETA_OK, 200};
+    bool ok = sensores_registrar(&driver_rapido) == G_P && sensores_registrar(&driver_lento) == G_T &&
+              sensores_grandezas() == 3;
+    verificar("registro", ok, "índice da primeira grandeza de cada sensor");
+    sensores_configurar(1000, 1);
+}
+
+// Disparos em sequência, conversão mais longa primeiro: com 80 ms e 40 ms
+// a rodada dura os 80 ms do mais lento, não a soma
+static void verificar_rodada() {
+    ordem_disparos.clear();
+    bool fechou = rodada();
+    uint32_t latencia = sensores_latencia_us();
+    bool ok = fechou && ordem_disparos == "10" && latencia == 80000 &&
+              sensores_qualidade(0) == SENSOR_OK && sensores_qualidade(1) == SENSOR_OK;
+
+    char detalhe[96];
+    snprintf(detalhe, sizeof(detalhe), "80 ms + 40 ms: rodada de %u us, disparos \"%s\"",
+             latencia, ordem_disparos.c_str());
+    verificar("rodada", ok, detalhe);
+
+    char texto[48];
+    sensores_ler(texto, sizeof(texto));
+    verificar("texto", !strcmp(texto, "P=50 T=20.0C U=20.1%"), texto);
+}
+
+// Mediana de 3 tira o pico isolado; o IIR anda 1/2^SENSORES_IIR_SHIFT da
+// diferença por leitura até chegar ao degrau
+static void verificar_filtro() {
+    bool sem_pico = true;
+    lento.roteiro = {{SENSOR_COLETA_OK, 200}, {SENSOR_COLETA_OK, 900},
+                     {SENSOR_COLETA_OK, 200}, {SENSOR_COLETA_OK, 200}};
+    for (int i = 0; i < 4; ++i) {
+        rodada();
+        if (valor(G_T) != 200) sem_pico = false;
+    }
+
+    lento.padrao = {SENSOR_COLETA_OK, 300};
+    rodada();
+    int16_t primeiro = valor(G_T);      // Mediana ainda em 200
+    rodada();
+    int16_t segundo = valor(G_T);       // Primeiro passo do IIR
+    int rodadas = 2;
+    while (valor(G_T) != 300 && rodadas < 40) {
+        rodada();
+        rodadas++;
+    }
+
+    bool ok = sem_pico && primeiro == 200 && segundo == 200 + (100 >> SENSORES_IIR_SHIFT) && valor(G_T) == 300;
+    char detalhe[96];
+    snprintf(detalhe, sizeof(detalhe), "pico de 900 ignorado; degrau 200->300: %d, %d, 300 em %d rodadas",
+             primeiro, segundo, rodadas);
+    verificar("filtro", ok, detalhe);
+}
+
+// CRC errado é repetido na mesma rodada; só SENSORES_TENTATIVAS falhas
+// seguidas recuperam o barramento e resetam o sensor
+static void verificar_crc() {
+    uint32_t recuperacoes = sensores_recuperacoes();
+    uint32_t disparos = rapido.disparos;
+    for (int i = 0; i < SENSORES_TENTATIVAS - 1; ++i) rapido.roteiro.push_back({SENSOR_COLETA_CRC, 0});
+    rapido.roteiro.push_back({SENSOR_COLETA_OK, 50});
+    rodada();
+    bool repetido = rapido.disparos - disparos == SENSORES_TENTATIVAS &&
+                    sensores_qualidade(0) == SENSOR_OK && sensores_recuperacoes() == recuperacoes;
+
+    uint32_t resets = rapido.resets;
+    for (int i = 0; i < SENSORES_TENTATIVAS; ++i) rapido.roteiro.push_back({SENSOR_COLETA_CRC, 0});
+    rodada();
+    char texto[48];
+    bool validas = sensores_ler(texto, sizeof(texto));
+    bool desistiu = sensores_qualidade(0) == SENSOR_CRC && sensores_recuperacoes() == recuperacoes + 1 &&
+                    rapido.resets == resets + 1 && !validas && !strncmp(texto, "E=crc ", 6);
+
+    // Depois da falha o filtro recomeça da próxima leitura, sem misturar
+    rapido.padrao = {SENSOR_COLETA_OK, 70};
+    rodada();
+    bool voltou = sensores_qualidade(0) == SENSOR_OK && valor(G_P) == 70;
+
+    char detalhe[96];
+    snprintf(detalhe, sizeof(detalhe), "%d CRC: repetido; %d: \"%.14s\", reset e volta em %d",
+             SENSORES_TENTATIVAS - 1, SENSORES_TENTATIVAS, texto, valor(G_P));
+    verificar("crc", repetido && desistiu && voltou, detalhe);
+}
+
+// Recuperação com SDA presa: pulsos de SCL até o escravo soltar a linha
+// (no máximo 9), mais o do STOP manual, e os pinos voltam ao I2C
+static void verificar_barramento() {
+    bool ok = true;
+    uint32_t pulsos[2];
+    const uint32_t presa[2] = {5, 100};
+    for (int i = 0; i < 2; ++i) {
+        barramento = Barramento();
+        barramento.sda_presa = presa[i];
+        for (int t = 0; t < SENSORES_TENTATIVAS; ++t) rapido.roteiro.push_back({SENSOR_COLETA_ERRO, 0});
+        rodada();
+        pulsos[i] = barramento.pulsos;
+        ok = ok && barramento.devolvidos && sensores_qualidade(0) == SENSOR_SEM_RESPOSTA;
+    }
+    ok = ok && pulsos[0] == 5 + 1 && pulsos[1] == 9 + 1;
+    barramento = Barramento();
+    rodada();
+
+    char detalhe[96];
+    snprintf(detalhe, sizeof(detalhe), "SDA presa por 5 e 100 pulsos: %u e %u subidas de SCL", pulsos[0], pulsos[1]);
+    verificar("barramento", ok && sensores_qualidade(0) == SENSOR_OK, detalhe);
+}
+
+// Sensor que não volta do reset fica fora das rodadas por
+// SENSORES_AUSENTE_MS e então é tentado de novo
+static void verificar_ausente() {
+    rapido.reset_ok = false;
+    for (int t = 0; t < SENSORES_TENTATIVAS; ++t) rapido.roteiro.push_back({SENSOR_COLETA_ERRO, 0});
+    rodada();
+    rapido.reset_ok = true;
+    uint64_t inicio = relogio_emulador().agora_us();
+    bool ausente = sensores_qualidade(0) == SENSOR_AUSENTE;
+
+    uint32_t disparos = rapido.disparos;
+    uint32_t rodadas = 0;
+    while (relogio_emulador().agora_us() - inicio < (uint64_t)(SENSORES_AUSENTE_MS - 1000) * 1000) {
+        rodada();
+        rodadas++;
+        if (sensores_qualidade(0) != SENSOR_AUSENTE) ausente = false;
+    }
+    bool parado = rapido.disparos == disparos;
+    uint32_t paradas = rodadas;
+    while (rapido.disparos == disparos && rodadas < 100) {
+        rodada();
+        rodadas++;
+    }
+    bool voltou = sensores_qualidade(0) == SENSOR_OK;
+
+    char detalhe[96];
+    snprintf(detalhe, sizeof(detalhe), "sem disparos por %u rodadas, volta após %u s",
+             paradas, (unsigned)((relogio_emulador().agora_us() - inicio) / 1000000));
+    verificar("ausente", ausente && parado && voltou, detalhe);
+}
+
+// Uma amostra na fila a cada 'decimacao' rodadas; com o rádio atrasado a
+// mais antiga é sobrescrita e contada
+static void verificar_fila() {
+    const uint8_t decimacao = 3;
+    sensores_configurar(1000, decimacao);
+    esvaziar_fila();
+
+    sensores_amostra_t a;
+    for (int i = 0; i < decimacao - 1; ++i) rodada();
+    bool cedo = !sensores_consumir(&a);
+    rodada();
+    bool uma = sensores_consumir(&a) && !sensores_consumir(&a) && a.n == 3 &&
+               a.t_us == time_us_32() && a.valores[G_P] == valor(G_P);
+
+    uint32_t perdidas = sensores_perdidas();
+    for (int i = 0; i < decimacao * (SENSORES_FILA + 2); ++i) rodada();
+    uint32_t na_fila = 0;
+    while (sensores_consumir(&a)) na_fila++;
+    bool cheia = na_fila == SENSORES_FILA && sensores_perdidas() == perdidas + 2;
+
+    char detalhe[96];
+    snprintf(detalhe, sizeof(detalhe), "1 a cada %u rodadas; %u na fila, %u perdidas",
+             decimacao, na_fila, sensores_perdidas() - perdidas);
+    verificar("fila", cedo && uma && cheia, detalhe);
+    sensores_configurar(1000, 1);
+}
+
+int main(int argc, char **argv) {
+    bool silencioso = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-q")) silencioso = true;
+        else { uso(argv[0]); return 1; }
+    }
+    if (silencioso && !freopen("/dev/null", "w", stdout)) return 1;
+
+    relogio_emulador().reiniciar();
+    verificar_conversao();
+    registrar();
+    verificar_rodada();
+    verificar_filtro();
+    verificar_crc();
+    verificar_barramento();
+    verificar_ausente();
+    verificar_fila();
+
+    if (falhas) fprintf(stderr, "\n%d verificações falharam\n", falhas);
+    return falhas ? 1 : 0;
+}
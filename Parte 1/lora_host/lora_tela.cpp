@@ -0,0 +1,313 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "inc/oled_emulador.h"
+
+extern "C" {
+#include "inc/ssd1306.h"
+#include "inc/tela.h"
+#include "inc/grafico.h"
+}
+#include "inc/font.h"
+
+// Renderiza as telas de update_display() (tela.c do nó ou do gateway) no
+// emulador do SSD1306. Cada tela é aplicada sobre a anterior, como no
+// firmware, e o quadro que chega ao emulador pelo I2C é conferido com o
+// ram_buffer, o que valida também o envio parcial.
+
+struct Tela {
+    const char *nome;
+    tela_estado_t estado;
+};
+
+#ifdef TELA_RX
+static const char PROGRAMA[] = "tela_rx";
+
+static Tela tela(const char *nome, const char *status, uint32_t rx, const char *msg,
+                 int16_t rssi, int8_t snr, bool captura) {
+    Tela t;
+    memset(&t, 0, sizeof(t));
+    t.nome = nome;
+    strncpy(t.estado.status, status, sizeof(t.estado.status) - 1);
+    strncpy(t.estado.last_message, msg, sizeof(t.estado.last_message) - 1);
+    t.estado.rx_count = rx;
+    t.estado.last_rssi = rssi;
+    t.estado.last_snr = snr;
+    t.estado.captura = captura;
+    return t;
+}
+
+static std::vector<Tela> roteiro() {
+    return {
+        tela("escutando", "ESCUTANDO", 0, "", 0, 0, false),
+        tela("recebido", "RECEBIDO", 1, "P2:T=25.3C U=60.1% #1", -87, 9, false),
+        tela("captura", "ESCUTANDO", 1, "P2:T=25.3C U=60.1% #1", -87, 9, true),
+        tela("fraco", "RECEBIDO", 1234, "P2:T=-1.5C U=99.9% #210", -120, -12, true),
+    };
+}
+#else
+static const char PROGRAMA[] = "tela_tx";
+
+static Tela tela(const char *nome, const char *status, uint32_t tx, const char *msg,
+                 uint32_t amostras, int16_t temp_x10, int16_t umid_x10) {
+    Tela t;
+    memset(&t, 0, sizeof(t));
+    t.nome = nome;
+    strncpy(t.estado.status, status, sizeof(t.estado.status) - 1);
+    strncpy(t.estado.last_message, msg, sizeof(t.estado.last_message) - 1);
+    t.estado.tx_count = tx;
+    t.estado.amostras = amostras;
+    t.estado.temp_x10 = temp_x10;
+    t.estado.umid_x10 = umid_x10;
+    return t;
+}
+
+static std::vector<Tela> roteiro() {
+    return {
+        tela("pronto", "PRONTO PARA TX", 0, "Aguardando...", 0, 0, 0),
+        tela("enviado", "ENVIADO", 1, "P2:T=25.3C U=60.1% #1 @1000+35", 1, 253, 601),
+        tela("teste", "ENVIADO", 2, "Test Message", 1, 253, 601),
+        tela("sensor", "ENVIADO", 3, "P2:T=26.1C U=58.0% #2 @2000+35", 2, 261, 580),
+        tela("contador", "ENVIADO", 65535, "P2:T=-1.5C U=99.9% #255 @4294967295+120", 3, -15, 999),
+    };
+}
+#endif
+
+static void uso() {
+    fprintf(stderr,
+        "uso: %s [opções]\n"
+        "  -o dir        grava cada tela em dir/<nome>.pbm\n"
+        "  -c dir        compara com dir/<nome>.pbm (referências gravadas com -o)\n"
+        "  -t            imprime as telas em texto\n"
+        "  -a            envia pelo caminho de DMA (ssd1306_send_data_async)\n"
+        "  -b repetições benchmark das primitivas de desenho\n",
+        PROGRAMA);
+}
+
+// Mesmo quadro no emulador e no framebuffer do driver
+static long conferir_transporte(const ssd1306_t *ssd) {
+    const OledEmulador &oled = oled_emulador();
+    long diferentes = 0;
+    for (int p = 0; p < SSD1306_PAGES; ++p)
+        for (int c = 0; c < OledEmulador::LARGURA; ++c)
+            if (oled.byte(c, p) != ssd->ram_buffer[ssd1306_index(c, p)]) diferentes++;
+    return diferentes;
+}
+
+// ---------------------------------------------------------------------
+// Benchmark: primitivas do driver contra versões pixel a pixel
+// ---------------------------------------------------------------------
+
+static void ref_rect_fill(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t w, uint8_t h, bool value) {
+    for (uint8_t x = left; x < left + w && x < SSD1306_WIDTH; ++x)
+        for (uint8_t y = top; y < top + h && y < SSD1306_HEIGHT; ++y)
+            ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
+    for (uint8_t x = x0; x <= x1 && x < SSD1306_WIDTH; ++x) ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y) {
+    uint16_t index = (c >= ' ' && c <= '~') ? (c - ' ') * 8 : 0;
+    for (uint8_t i = 0; i < 8 && x + i < SSD1306_WIDTH; ++i)
+        for (uint8_t j = 0; j < 8 && y + j < SSD1306_HEIGHT; ++j)
+            ssd1306_pixel(ssd, x + i, y + j, font[index + i] & (1 << j));
+}
+
+template <typename F>
+static double medir_ns(unsigned repeticoes, F f) {
+    auto inicio = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < repeticoes; ++i) f();
+    std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - inicio;
+    return d.count() / repeticoes;
+}
+
+static bool benchmark(ssd1306_t *ssd, unsigned repeticoes) {
+    static ssd1306_t ref;
+    ssd1306_init(&ref, false, 0x3C, i2c1);
+
+    // Equivalência com as versões pixel a pixel em operações aleatórias, na
+    // geometria do build; nada pode escrever além do ram_buffer
+    srand(1);
+    long diferentes = 0;
+    uint8_t tx_antes[SSD1306_BUFSIZE];
+    memcpy(tx_antes, ssd->tx_buffer, sizeof(tx_antes));
+    for (int i = 0; i < 2000; ++i) {
+        uint8_t x = rand() % SSD1306_WIDTH, y = rand() % SSD1306_HEIGHT;
+        uint8_t w = 1 + rand() % 64, h = 1 + rand() % (SSD1306_HEIGHT / 2);
+        bool v = rand() & 1;
+        char c = ' ' + rand() % 95;
+        ssd1306_rect(ssd, y, x, w, h, v, true);
+        ref_rect_fill(&ref, y, x, w, h, v);
+        ssd1306_hline(ssd, x, x + w - 1, (y + h) % SSD1306_HEIGHT, !v);
+        ref_hline(&ref, x, x + w - 1, (y + h) % SSD1306_HEIGHT, !v);
+        ssd1306_draw_char(ssd, c, x, y);
+        ref_draw_char(&ref, c, x, y);
+        if (i % 100 == 0) {
+            diferentes += memcmp(ssd->ram_buffer + 1, ref.ram_buffer + 1, SSD1306_BUFSIZE - 1) != 0;
+        }
+    }
+    diferentes += memcmp(tx_antes, ssd->tx_buffer, sizeof(tx_antes)) != 0;
+    printf("equivalência pixel a pixel (%dx%d): %s\n", SSD1306_WIDTH, SSD1306_HEIGHT, diferentes ? "DIVERGE" : "ok");
+
+    char texto[] = "LoRa BitDogLab!";
+    printf("%-22s %12s %12s\n", "primitiva", "driver ns", "pixel ns");
+    printf("%-22s %12.1f %12.1f\n", "rect 64x32",
+           medir_ns(repeticoes, [&] { ssd1306_rect(ssd, 16, 32, 64, 32, true, true); }),
+           medir_ns(repeticoes, [&] { ref_rect_fill(&ref, 16, 32, 64, 32, true); }));
+    printf("%-22s %12.1f %12.1f\n", "string 15 y=8",
+           medir_ns(repeticoes, [&] { ssd1306_draw_string(ssd, texto, 0, 8); }),
+           medir_ns(repeticoes, [&] {
+               for (uint8_t i = 0; texto[i]; ++i) ref_draw_char(&ref, texto[i], i * 8, 8);
+           }));
+    printf("%-22s %12.1f %12.1f\n", "string 15 y=12",
+           medir_ns(repeticoes, [&] { ssd1306_draw_string(ssd, texto, 0, 12); }),
+           medir_ns(repeticoes, [&] {
+               for (uint8_t i = 0; texto[i]; ++i) ref_draw_char(&ref, texto[i], i * 8, 12);
+           }));
+    printf("%-22s %12.1f\n", "fill",
+           medir_ns(repeticoes, [&] { ssd1306_fill(ssd, false); }));
+    printf("%-22s %12.1f\n", "send_data (tela cheia)",
+           medir_ns(repeticoes, [&] { ssd1306_invalidate(ssd); ssd1306_send_data(ssd); }));
+
+    // Sparkline: redesenho incremental (deslocamento + colunas novas) contra
+    // o redesenho completo, com escala fixa e automática
+    static ssd1306_t inc, cheio;
+    ssd1306_init(&inc, false, 0x3C, i2c1);
+    ssd1306_init(&cheio, false, 0x3C, i2c1);
+    static serie_t serie;
+    sparkline_t gi[2], gc[2];
+    serie_init(&serie);
+    sparkline_init(&gi[0], &serie, 0, 64, SSD1306_PAGES - 2, 2, 0, 0);
+    sparkline_init(&gc[0], &serie, 0, 64, SSD1306_PAGES - 2, 2, 0, 0);
+    sparkline_init(&gi[1], &serie, 64, 64, 0, SSD1306_PAGES, -100, 100);
+    sparkline_init(&gc[1], &serie, 64, 64, 0, SSD1306_PAGES, -100, 100);
+    long graf_diferentes = 0;
+    double ns_inc = 0, ns_cheio = 0;
+    for (unsigned i = 0; i < 1000; ++i) {
+        int novas = 1 + (rand() % 8 == 0 ? rand() % 4 : 0);
+        for (int n = 0; n < novas; ++n)
+            serie_adicionar(&serie, (int16_t)(rand() % 160 - 80));
+        for (int g = 0; g < 2; ++g) {
+            ns_inc += medir_ns(1, [&] { sparkline_desenhar(&inc, &gi[g]); });
+            gc[g].sujo = true;
+            ns_cheio += medir_ns(1, [&] { sparkline_desenhar(&cheio, &gc[g]); });
+        }
+        graf_diferentes += memcmp(inc.ram_buffer + 1, cheio.ram_buffer + 1, SSD1306_BUFSIZE - 1) != 0;
+    }
+    printf("sparkline incremental: %s\n", graf_diferentes ? "DIVERGE" : "ok");
+    printf("%-22s %12.1f %12.1f  (incremental / completo)\n", "sparkline", ns_inc / 2000, ns_cheio / 2000);
+    diferentes += graf_diferentes;
+
+    // Atualização típica: só o contador muda
+    std::vector<Tela> telas = roteiro();
+    tela_init(ssd);
+    tela_atualizar(ssd, &telas[0].estado);
+    ssd1306_send_data(ssd);
+    uint32_t bytes = 0;
+    double ns = medir_ns(repeticoes, [&] {
+#ifdef TELA_RX
+        telas[0].estado.rx_count++;
+#else
+        telas[0].estado.tx_count++;
+#endif
+        tela_atualizar(ssd, &telas[0].estado);
+        ssd1306_send_data(ssd);
+        bytes += ssd->bytes_last_frame;
+    });
+    printf("%-22s %12.1f ns  %u bytes/quadro\n", "contador + envio", ns, bytes / repeticoes);
+
+    return diferentes == 0;
+}
+
+// Regiões e pixels fora do painel não podem escrever no ram_buffer nem
+// nas faixas sujas (que só têm SSD1306_PAGES entradas)
+static bool conferir_limites() {
+    static ssd1306_t ssd;
+    ssd1306_init(&ssd, false, 0x3C, i2c1);
+    ssd1306_fill(&ssd, false);
+    static uint8_t antes[SSD1306_BUFSIZE];
+    memcpy(antes, ssd.ram_buffer, sizeof(antes));
+
+    serie_t serie;
+    serie_init(&serie);
+    for (int i = 0; i < 40; ++i) serie_adicionar(&serie, (int16_t)(i * 7 % 23));
+    sparkline_t g;
+    bool recusadas = !sparkline_init(&g, &serie, 0, 64, SSD1306_PAGES - 1, 2, 0, 0) &&
+                     !sparkline_desenhar(&ssd, &g) &&
+                     !sparkline_init(&g, &serie, 100, 64, 0, 1, 0, 0) &&
+                     !sparkline_init(&g, &serie, 0, 0, 0, 1, 0, 0);
+    bool aceita = sparkline_init(&g, &serie, 64, 64, SSD1306_PAGES - 1, 1, 0, 0);
+
+    ssd1306_pixel(&ssd, 10, SSD1306_HEIGHT, true);
+    ssd1306_pixel(&ssd, 10, 255, true);
+    ssd1306_pixel(&ssd, SSD1306_WIDTH, 0, true);
+    ssd1306_mark_dirty(&ssd, 0, 255, SSD1306_PAGES - 1, 255);
+    bool intacto = memcmp(antes, ssd.ram_buffer, sizeof(antes)) == 0;
+
+    bool ok = recusadas && aceita && intacto;
+    printf("%-10s %s\n", "limites", ok ? "ok" : "FALHOU");
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    std::string dir_saida, dir_comparar;
+    bool texto = false, dma = false;
+    unsigned repeticoes = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        bool tem_valor = i + 1 < argc;
+        if (!strcmp(a, "-o") && tem_valor) dir_saida = argv[++i];
+        else if (!strcmp(a, "-c") && tem_valor) dir_comparar = argv[++i];
+        else if (!strcmp(a, "-t")) texto = true;
+        else if (!strcmp(a, "-a")) dma = true;
+        else if (!strcmp(a, "-b") && tem_valor) repeticoes = (unsigned)atoi(argv[++i]);
+        else { uso(); return 1; }
+    }
+
+    static ssd1306_t ssd;
+    ssd1306_init(&ssd, false, 0x3C, i2c1);
+
+    if (repeticoes > 0) return benchmark(&ssd, repeticoes) ? 0 : 1;
+
+    OledEmulador &oled = oled_emulador();
+    oled.reiniciar();
+    ssd1306_config(&ssd);
+    if (dma) ssd1306_init_dma(&ssd);
+    tela_init(&ssd);
+
+    int falhas = 0;
+    for (const Tela &t : roteiro()) {
+        tela_atualizar(&ssd, &t.estado);
+        if (dma) ssd1306_send_data_async(&ssd);
+        else ssd1306_send_data(&ssd);
+
+        long transporte = conferir_transporte(&ssd);
+        printf("%-10s %5u bytes%s", t.nome, ssd.bytes_last_frame,
+               transporte ? "  TRANSPORTE DIVERGE" : "");
+        if (transporte) falhas++;
+
+        if (!dir_saida.empty() && !oled.gravar_pbm(dir_saida + "/" + t.nome + ".pbm")) return 1;
+        if (!dir_comparar.empty()) {
+            long d = oled.comparar_pbm(dir_comparar + "/" + t.nome + ".pbm");
+            if (d < 0) printf("  sem referência");
+            else if (d > 0) printf("  %ld pixels diferentes", d);
+            else printf("  igual");
+            if (d != 0) falhas++;
+        }
+        printf("\n");
+        if (texto) printf("%s\n", oled.texto().c_str());
+    }
+
+    if (!conferir_limites()) falhas++;
+    if (!oled.ligado()) {
+        printf("display desligado após a configuração\n");
+        falhas++;
+    }
+    return falhas ? 1 : 0;
+}
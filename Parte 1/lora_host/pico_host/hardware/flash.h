@@ -0,0 +1,25 @@
+#ifndef PICO_HOST_FLASH_H
+#define PICO_HOST_FLASH_H
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLASH_PAGE_SIZE         (1u << 8)
+#define FLASH_SECTOR_SIZE       (1u << 12)
+#define PICO_FLASH_SIZE_BYTES   (2 * 1024 * 1024)
+
+// A janela XIP aponta para a memória do emulador (src/flash_emulador.cpp)
+extern uint8_t *flash_host_memoria;
+#define XIP_BASE ((uintptr_t)flash_host_memoria)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef PICO_HOST_I2C_H
+#define PICO_HOST_I2C_H
+
+#include "pico/stdlib.h"
+
+// Escritas I2C do host são decodificadas pelo emulador do SSD1306
+// (lora_host/src/oled_emulador.cpp)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct i2c_inst i2c_inst_t;
+
+typedef struct {
+    volatile uint32_t enable;
+    volatile uint32_t tar;
+    volatile uint32_t data_cmd;
+    volatile uint32_t status;
+    volatile uint32_t clr_tx_abrt;
+} i2c_hw_t;
+
+#define I2C_IC_DATA_CMD_STOP_BITS       0x00000200u
+#define I2C_IC_STATUS_TFE_BITS          0x00000004u
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS 0x00000020u
+
+extern i2c_inst_t *i2c0, *i2c1;
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+// Sem emulador por trás: implementadas pela ferramenta que as usa
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us);
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c);
+uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef PICO_HOST_IRQ_H
+#define PICO_HOST_IRQ_H
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*irq_handler_t)(void);
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+void irq_set_enabled(uint num, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
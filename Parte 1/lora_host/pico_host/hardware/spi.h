@@ -0,0 +1,8 @@
+#ifndef PICO_HOST_SPI_H
+#define PICO_HOST_SPI_H
+
+#include "pico/stdlib.h"
+
+typedef struct spi_inst spi_inst_t;
+
+#endif
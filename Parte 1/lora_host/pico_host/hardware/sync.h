@@ -0,0 +1,18 @@
+#ifndef PICO_HOST_SYNC_H
+#define PICO_HOST_SYNC_H
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ao reabilitar as interrupções o IRQ de DMA pendente é atendido
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef PICO_HOST_PICO_FLASH_H
+#define PICO_HOST_PICO_FLASH_H
+
+#include "pico/stdlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sem o outro core no host: a operação roda direto, a não ser que o
+// emulador (src/flash_emulador.cpp) simule o prazo estourado
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+
+static inline bool flash_safe_execute_core_init(void) { return true; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef PICO_HOST_STDLIB_H
+#define PICO_HOST_STDLIB_H
+
+// Substituto mínimo do pico/stdlib.h para compilar a lógica das
+// aplicações no host
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned int uint;
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+#define PICO_ERROR_TIMEOUT -2
+
+static inline void tight_loop_contents(void) {}
+
+// Tempo e alarmes correm no relógio simulado de src/relogio_emulador.cpp:
+// só avançam com sleep_ms/sleep_us ou pelo emulador
+typedef uint64_t absolute_time_t;
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+bool time_reached(absolute_time_t t);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+
+// GPIO: quem usa fornece a implementação (o barramento simulado do teste)
+#define GPIO_IN 0
+#define GPIO_OUT 1
+#define GPIO_FUNC_I2C 3
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, uint fn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
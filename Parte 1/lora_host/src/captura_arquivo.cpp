@@ -0,0 +1,79 @@
+#include "inc/captura_arquivo.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+bool EscritorCaptura::abrir(const std::string &caminho) {
+    arquivo_ = fopen(caminho.c_str(), "ab");
+    if (!arquivo_) {
+        perror(caminho.c_str());
+        return false;
+    }
+    // Arquivo novo recebe o cabeçalho; os demais só crescem
+    if (ftell(arquivo_) == 0) {
+        const uint8_t versao = CAPTURA_VERSAO;
+        fwrite(CAPTURA_MAGICO, 1, 4, arquivo_);
+        fwrite(&versao, 1, 1, arquivo_);
+    }
+    return true;
+}
+
+static int valor_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool EscritorCaptura::adicionar_hex(const char *hex, size_t n) {
+    uint8_t bin[CAPTURA_MAX_REGISTRO];
+    if (n % 2 || n / 2 > sizeof(bin)) return false;
+
+    for (size_t i = 0; i < n / 2; ++i) {
+        int hi = valor_hex(hex[2 * i]), lo = valor_hex(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        bin[i] = (uint8_t)(hi << 4 | lo);
+    }
+
+    // Linhas truncadas pela serial são descartadas
+    captura_registro_t reg;
+    if (captura_desserializar(bin, n / 2, &reg) != n / 2) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!arquivo_) return false;
+    fwrite(bin, 1, n / 2, arquivo_);
+    registros_++;
+    return true;
+}
+
+void EscritorCaptura::fechar() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!arquivo_) return;
+    fclose(arquivo_);
+    arquivo_ = nullptr;
+}
+
+bool ler_captura(const std::string &caminho, std::vector<captura_registro_t> &registros) {
+    std::ifstream f(caminho, std::ios::binary);
+    if (!f) {
+        perror(caminho.c_str());
+        return false;
+    }
+    std::vector<uint8_t> dados((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+    if (dados.size() < 5 || memcmp(dados.data(), CAPTURA_MAGICO, 4) != 0 || dados[4] != CAPTURA_VERSAO) {
+        fprintf(stderr, "%s: não é uma captura .lcap v%d\n", caminho.c_str(), CAPTURA_VERSAO);
+        return false;
+    }
+
+    size_t pos = 5;
+    captura_registro_t reg;
+    size_t n;
+    while ((n = captura_desserializar(dados.data() + pos, dados.size() - pos, &reg)) > 0) {
+        registros.push_back(reg);
+        pos += n;
+    }
+    if (pos != dados.size())
+        fprintf(stderr, "%s: %zu bytes finais incompletos ignorados\n", caminho.c_str(), dados.size() - pos);
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "inc/colunar.h"
+#include <cinttypes>
+
+bool EscritorColunar::abrir(const std::string &caminho) {
+    arquivo_ = fopen(caminho.c_str(), "wb");
+    if (!arquivo_) {
+        perror(caminho.c_str());
+        return false;
+    }
+    const uint16_t versao = COLUNAR_VERSAO, colunas = COLUNAR_COLUNAS;
+    fwrite("LCOL", 1, 4, arquivo_);
+    fwrite(&versao, sizeof(versao), 1, arquivo_);
+    fwrite(&colunas, sizeof(colunas), 1, arquivo_);
+    return true;
+}
+
+void EscritorColunar::adicionar(const Registro &reg) {
+    t_us_.push_back(reg.t_us);
+    gateway_.push_back(reg.gateway);
+    no_.push_back(reg.no);
+    seq_.push_back(reg.seq);
+    rssi_.push_back(reg.rssi);
+    snr_.push_back(reg.snr);
+    temp_.push_back(reg.temp_x10);
+    umid_.push_back(reg.umid_x10);
+    flags_.push_back(reg.flags);
+    if (t_us_.size() >= COLUNAR_BLOCO) descarregar();
+}
+
+template <typename T>
+static void escrever_coluna(FILE *f, std::vector<T> &col) {
+    fwrite(col.data(), sizeof(T), col.size(), f);
+    col.clear();
+}
+
+void EscritorColunar::descarregar() {
+    if (!arquivo_ || t_us_.empty()) return;
+    const uint32_t n = (uint32_t)t_us_.size();
+    fwrite(&n, sizeof(n), 1, arquivo_);
+    escrever_coluna(arquivo_, t_us_);
+    escrever_coluna(arquivo_, gateway_);
+    escrever_coluna(arquivo_, no_);
+    escrever_coluna(arquivo_, seq_);
+    escrever_coluna(arquivo_, rssi_);
+    escrever_coluna(arquivo_, snr_);
+    escrever_coluna(arquivo_, temp_);
+    escrever_coluna(arquivo_, umid_);
+    escrever_coluna(arquivo_, flags_);
+}
+
+void EscritorColunar::fechar() {
+    if (!arquivo_) return;
+    descarregar();
+    fclose(arquivo_);
+    arquivo_ = nullptr;
+}
+
+bool EscritorCsv::abrir(const std::string &caminho) {
+    arquivo_ = fopen(caminho.c_str(), "w");
+    if (!arquivo_) {
+        perror(caminho.c_str());
+        return false;
+    }
+    fputs("t_us,gateway,no,seq,rssi,snr,temp,umid,flags\n", arquivo_);
+    return true;
+}
+
+// Décimos -> "x.y" preservando o sinal de valores entre -1 e 0
+static const char *decimos(int16_t v, char *buf, size_t len) {
+    int a = v < 0 ? -v : v;
+    snprintf(buf, len, "%s%d.%d", v < 0 ? "-" : "", a / 10, a % 10);
+    return buf;
+}
+
+void EscritorCsv::adicionar(const Registro &reg) {
+    if (!arquivo_) return;
+    char temp[12], umid[12];
+    fprintf(arquivo_, "%" PRIu64 ",%u,%u,%" PRIu32 ",%d,%d,%s,%s,%u\n",
+            reg.t_us, reg.gateway, reg.no, reg.seq, reg.rssi, reg.snr,
+            (reg.flags & REG_TEM_TEMP) ? decimos(reg.temp_x10, temp, sizeof(temp)) : "",
+            (reg.flags & REG_TEM_UMID) ? decimos(reg.umid_x10, umid, sizeof(umid)) : "",
+            reg.flags);
+}
+
+void EscritorCsv::fechar() {
+    if (!arquivo_) return;
+    fclose(arquivo_);
+    arquivo_ = nullptr;
+}
@@ -0,0 +1,146 @@
+#include "inc/decodificador.h"
+#include "inc/captura_arquivo.h"
+#include <cstdlib>
+#include <cstring>
+
+static const char PREFIXO_MSG[] = "Mensagem recebida: ";
+static const char PREFIXO_RSSI[] = "RSSI: ";
+
+void LeitorSerial::alimentar(const char *dados, size_t n, uint64_t t_us, std::vector<RegistroBruto> &saida) {
+    size_t inicio = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (dados[i] != '\n') continue;
+
+        size_t fim = i;
+        if (fim > inicio && dados[fim - 1] == '\r') --fim;
+
+        if (parcial_.empty()) {
+            linha(std::string(dados + inicio, fim - inicio), t_us, saida);
+        } else {
+            parcial_.append(dados + inicio, fim - inicio);
+            if (!parcial_.empty() && parcial_.back() == '\r') parcial_.pop_back();
+            linha(parcial_, t_us, saida);
+            parcial_.clear();
+        }
+        inicio = i + 1;
+    }
+    parcial_.append(dados + inicio, n - inicio);
+}
+
+void LeitorSerial::linha(const std::string &l, uint64_t t_us, std::vector<RegistroBruto> &saida) {
+    if (l.compare(0, sizeof(CAPTURA_PREFIXO) - 1, CAPTURA_PREFIXO) == 0) {
+        if (captura_) captura_->adicionar_hex(l.c_str() + sizeof(CAPTURA_PREFIXO) - 1, l.size() - (sizeof(CAPTURA_PREFIXO) - 1));
+        return;
+    }
+
+    if (l.compare(0, sizeof(PREFIXO_MSG) - 1, PREFIXO_MSG) == 0) {
+        mensagem_.assign(l, sizeof(PREFIXO_MSG) - 1, std::string::npos);
+        pendente_ = true;
+        return;
+    }
+
+    if (!pendente_ || l.compare(0, sizeof(PREFIXO_RSSI) - 1, PREFIXO_RSSI) != 0) return;
+
+    // "RSSI: %d dBm, SNR: %d dB"
+    const char *p = l.c_str() + sizeof(PREFIXO_RSSI) - 1;
+    char *fim;
+    long rssi = strtol(p, &fim, 10);
+    const char *snr_txt = strstr(fim, "SNR:");
+    long snr = snr_txt ? strtol(snr_txt + 4, nullptr, 10) : 0;
+
+    RegistroBruto bruto;
+    bruto.t_us = t_us;
+    bruto.gateway = gateway_;
+    bruto.rssi = (int16_t)rssi;
+    bruto.snr = (int8_t)snr;
+    bruto.mensagem = std::move(mensagem_);
+    saida.push_back(std::move(bruto));
+
+    mensagem_.clear();
+    pendente_ = false;
+}
+
+uint64_t hash_mensagem(const char *s, size_t n) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (uint8_t)s[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Converte "25.3" / "-1.0" em décimos, sem passar por float
+static bool ler_decimos(const char *&p, int16_t &valor) {
+    bool negativo = false;
+    if (*p == '-') { negativo = true; ++p; }
+    if (*p < '0' || *p > '9') return false;
+
+    int32_t v = 0;
+    while (*p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    v *= 10;
+    if (*p == '.') {
+        ++p;
+        if (*p >= '0' && *p <= '9') v += *p++ - '0';
+        while (*p >= '0' && *p <= '9') ++p;
+    }
+    valor = (int16_t)(negativo ? -v : v);
+    return true;
+}
+
+bool decodificar(const RegistroBruto &bruto, Registro &reg) {
+    const std::string &m = bruto.mensagem;
+
+    reg.t_us = bruto.t_us;
+    reg.gateway = bruto.gateway;
+    reg.rssi = bruto.rssi;
+    reg.snr = bruto.snr;
+    reg.chave = hash_mensagem(m.data(), m.size());
+    reg.seq = 0;
+    reg.no = 0;
+    reg.temp_x10 = 0;
+    reg.umid_x10 = 0;
+    reg.flags = 0;
+
+    const char *p = m.c_str();
+
+    // Identificação do nó: "P<n>:"
+    if (p[0] == 'P' && p[1] >= '0' && p[1] <= '9') {
+        char *fim;
+        unsigned long no = strtoul(p + 1, &fim, 10);
+        if (*fim == ':') {
+            reg.no = (uint16_t)no;
+            reg.flags |= REG_TEM_NO;
+            p = fim + 1;
+        }
+    }
+
+    while (*p) {
+        if (p[0] == 'T' && p[1] == '=') {
+            p += 2;
+            if (ler_decimos(p, reg.temp_x10)) reg.flags |= REG_TEM_TEMP;
+        } else if (p[0] == 'U' && p[1] == '=') {
+            p += 2;
+            if (ler_decimos(p, reg.umid_x10)) reg.flags |= REG_TEM_UMID;
+        } else if (p[0] == 'E' && p[1] == '=') {
+            p += 2;
+            reg.flags |= REG_ERRO_SENSOR;
+        } else if (p[0] == '#' && p[1] >= '0' && p[1] <= '9') {
+            char *fim;
+            reg.seq = (uint32_t)strtoul(p + 1, &fim, 10);
+            reg.flags |= REG_TEM_SEQ;
+            p = fim;
+        } else if (p[0] == '~' && p[1] >= '0' && p[1] <= '9') {
+            // Amostra reenviada do diário do nó: o instante passa a ser o
+            // da amostra, não o da chegada
+            char *fim;
+            uint64_t idade_us = (uint64_t)strtoul(p + 1, &fim, 10) * 1000000;
+            if (idade_us <= reg.t_us) reg.t_us -= idade_us;
+            reg.flags |= REG_ATRASADO;
+            p = fim;
+        } else {
+            ++p;
+        }
+    }
+
+    return reg.flags != 0;
+}
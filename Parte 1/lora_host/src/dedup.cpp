@@ -0,0 +1,26 @@
+#include "inc/dedup.h"
+
+bool Deduplicador::novo(const Registro &reg) {
+    if (reg.t_us > mais_recente_) mais_recente_ = reg.t_us;
+
+    // Expira as chaves fora da janela
+    while (!ordem_.empty() && ordem_.front().first + janela_us_ < mais_recente_) {
+        auto it = vistos_.find(ordem_.front().second);
+        if (it != vistos_.end() && it->second == ordem_.front().first) vistos_.erase(it);
+        ordem_.pop_front();
+    }
+
+    auto it = vistos_.find(reg.chave);
+    if (it != vistos_.end()) {
+        uint64_t delta = reg.t_us > it->second ? reg.t_us - it->second : it->second - reg.t_us;
+        if (delta <= janela_us_) {
+            duplicados_++;
+            return false;
+        }
+        it->second = reg.t_us;
+    } else {
+        vistos_.emplace(reg.chave, reg.t_us);
+    }
+    ordem_.emplace_back(reg.t_us, reg.chave);
+    return true;
+}
@@ -0,0 +1,86 @@
+#include "../inc/flash_emulador.h"
+#include <algorithm>
+
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+static_assert(FlashEmulador::TAMANHO == PICO_FLASH_SIZE_BYTES, "tamanho da flash difere do stub");
+static_assert(FlashEmulador::SETOR == FLASH_SECTOR_SIZE && FlashEmulador::PAGINA == FLASH_PAGE_SIZE,
+              "geometria da flash difere do stub");
+
+void FlashEmulador::reiniciar() {
+    std::fill(mem_.begin(), mem_.end(), 0xFF);
+    std::fill(apagamentos_.begin(), apagamentos_.end(), 0);
+    corte_ = -1;
+    recusas_ = 0;
+    programacoes_ = apagamentos_total_ = conflitos_ = desalinhados_ = 0;
+}
+
+void FlashEmulador::apagar(uint32_t offset, size_t n) {
+    // O SDK exige setores inteiros
+    if (offset % SETOR || n % SETOR || offset + n > TAMANHO) {
+        desalinhados_++;
+        return;
+    }
+    std::fill(mem_.begin() + offset, mem_.begin() + offset + n, 0xFF);
+    for (uint32_t s = offset / SETOR; s < (offset + n) / SETOR; ++s) apagamentos_[s]++;
+    apagamentos_total_ += n / SETOR;
+}
+
+void FlashEmulador::programar(uint32_t offset, const uint8_t *dados, size_t n) {
+    // O SDK exige páginas inteiras
+    if (offset % PAGINA || n % PAGINA || offset + n > TAMANHO) {
+        desalinhados_++;
+        return;
+    }
+    programacoes_++;
+
+    size_t gravar = n;
+    if (corte_ >= 0) {
+        gravar = std::min(n, (size_t)corte_);
+        corte_ = -1;
+    }
+    bool conflito = false;
+    for (size_t i = 0; i < gravar; ++i) {
+        uint8_t &b = mem_[offset + i];
+        if (dados[i] & ~b) conflito = true;
+        b &= dados[i];
+    }
+    if (conflito) conflitos_++;
+}
+
+bool FlashEmulador::recusar() {
+    if (recusas_ == 0) return false;
+    recusas_--;
+    return true;
+}
+
+FlashEmulador &flash_emulador() {
+    static FlashEmulador flash;
+    return flash;
+}
+
+// ---------------------------------------------------------------------
+// Stubs do SDK (hardware/flash.h e pico/flash.h)
+// ---------------------------------------------------------------------
+
+extern "C" {
+
+uint8_t *flash_host_memoria = flash_emulador().memoria();
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    flash_emulador().apagar(flash_offs, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    flash_emulador().programar(flash_offs, data, count);
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    if (flash_emulador().recusar()) return PICO_ERROR_TIMEOUT;
+    func(param);
+    return PICO_OK;
+}
+
+}
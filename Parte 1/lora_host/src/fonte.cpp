@@ -0,0 +1,72 @@
+#include "inc/fonte.h"
+#include "inc/decodificador.h"
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+uint64_t agora_us(void) {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+// Porta CDC do Pico: modo raw, a taxa é ignorada pelo USB mas fica definida
+static void configurar_tty(int fd) {
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) return;
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B115200);
+    cfsetospeed(&tio, B115200);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+bool ler_fonte(const std::string &caminho, uint16_t gateway, FilaBruta &fila, EscritorCaptura *captura) {
+    int fd = open(caminho.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror(caminho.c_str());
+        return false;
+    }
+    if (isatty(fd)) configurar_tty(fd);
+
+    LeitorSerial leitor(gateway, captura);
+    std::vector<RegistroBruto> lote;
+    lote.reserve(FONTE_LOTE);
+    char buf[16384];
+
+    bool tty = isatty(fd);
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        leitor.alimentar(buf, (size_t)n, agora_us(), lote);
+        // Em tty o lote sai a cada leitura para não segurar pacotes
+        if (lote.size() >= FONTE_LOTE || (tty && !lote.empty())) {
+            fila.push(std::move(lote));
+            lote = std::vector<RegistroBruto>();
+            lote.reserve(FONTE_LOTE);
+        }
+    }
+    if (!lote.empty()) fila.push(std::move(lote));
+
+    close(fd);
+    return true;
+}
+
+void ler_memoria(const std::string &conteudo, uint16_t gateway, uint64_t t_base_us, FilaBruta &fila) {
+    LeitorSerial leitor(gateway);
+    std::vector<RegistroBruto> lote;
+    lote.reserve(FONTE_LOTE);
+
+    const size_t passo = 4096;
+    for (size_t i = 0; i < conteudo.size(); i += passo) {
+        size_t n = conteudo.size() - i < passo ? conteudo.size() - i : passo;
+        leitor.alimentar(conteudo.data() + i, n, t_base_us, lote);
+        if (lote.size() >= FONTE_LOTE) {
+            fila.push(std::move(lote));
+            lote = std::vector<RegistroBruto>();
+            lote.reserve(FONTE_LOTE);
+        }
+    }
+    if (!lote.empty()) fila.push(std::move(lote));
+}
@@ -0,0 +1,258 @@
+#include "inc/oled_emulador.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+extern "C" {
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+}
+
+void OledEmulador::reiniciar() {
+    memset(gddram_, 0, sizeof(gddram_));
+    modo_ = 2;  // Valor de reset do SSD1306
+    col_ini_ = 0;
+    col_fim_ = LARGURA - 1;
+    pag_ini_ = 0;
+    pag_fim_ = PAGINAS - 1;
+    col_ = 0;
+    pag_ = 0;
+    contraste_ = 0x7F;
+    ligado_ = false;
+    invertido_ = false;
+    cmd_len_ = 0;
+    cmd_faltam_ = 0;
+    transacoes_ = 0;
+    bytes_ = 0;
+    comandos_ = 0;
+}
+
+void OledEmulador::transacao(const uint8_t *dados, size_t n) {
+    transacoes_++;
+    bytes_ += n;
+
+    // Controle: Co (bit 7) = 1 -> um byte e novo controle; Co = 0 -> o
+    // resto da transação. D/C# (bit 6) escolhe dados ou comandos.
+    size_t i = 0;
+    while (i < n) {
+        uint8_t controle = dados[i++];
+        bool continua = controle & 0x80;
+        bool eh_dado = controle & 0x40;
+        size_t fim = continua ? (i + 1 < n ? i + 1 : n) : n;
+        for (; i < fim; ++i) {
+            if (eh_dado) dado(dados[i]);
+            else comando(dados[i]);
+        }
+    }
+}
+
+int OledEmulador::argumentos(uint8_t c) const {
+    switch (c) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    case 0x21: case 0x22: case 0xA3:
+        return 2;
+    case 0x29: case 0x2A:
+        return 5;
+    case 0x26: case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+void OledEmulador::comando(uint8_t c) {
+    if (cmd_faltam_ > 0) {
+        cmd_[cmd_len_++] = c;
+        if (--cmd_faltam_ > 0) return;
+    } else {
+        comandos_++;
+        cmd_[0] = c;
+        cmd_len_ = 1;
+        cmd_faltam_ = argumentos(c);
+        if (cmd_faltam_ > 0) return;
+    }
+
+    uint8_t op = cmd_[0];
+    switch (op) {
+    case 0x20:
+        modo_ = cmd_[1] & 0x03;
+        break;
+    case 0x21:
+        col_ini_ = col_ = cmd_[1] & 0x7F;
+        col_fim_ = cmd_[2] & 0x7F;
+        break;
+    case 0x22:
+        pag_ini_ = pag_ = cmd_[1] & 0x07;
+        pag_fim_ = cmd_[2] & 0x07;
+        break;
+    case 0x81:
+        contraste_ = cmd_[1];
+        break;
+    case 0xA6: case 0xA7:
+        invertido_ = op & 1;
+        break;
+    case 0xAE: case 0xAF:
+        ligado_ = op & 1;
+        break;
+    default:
+        // Endereçamento do modo página
+        if (op <= 0x0F) col_ = (col_ & 0xF0) | op;
+        else if (op <= 0x1F) col_ = (col_ & 0x0F) | ((op & 0x07) << 4);
+        else if (op >= 0xB0 && op <= 0xB7) pag_ = op & 0x07;
+        break;
+    }
+    cmd_len_ = 0;
+}
+
+void OledEmulador::dado(uint8_t d) {
+    gddram_[pag_][col_] = d;
+
+    switch (modo_) {
+    case 0:  // Horizontal
+        if (col_++ >= col_fim_) {
+            col_ = col_ini_;
+            if (pag_++ >= pag_fim_) pag_ = pag_ini_;
+        }
+        break;
+    case 1:  // Vertical
+        if (pag_++ >= pag_fim_) {
+            pag_ = pag_ini_;
+            if (col_++ >= col_fim_) col_ = col_ini_;
+        }
+        break;
+    default:  // Página: só a coluna avança
+        if (++col_ >= LARGURA) col_ = 0;
+        break;
+    }
+}
+
+bool OledEmulador::pixel(int x, int y) const {
+    bool aceso = (gddram_[y >> 3][x] >> (y & 7)) & 1;
+    return aceso != invertido_;
+}
+
+bool OledEmulador::gravar_pbm(const std::string &caminho) const {
+    FILE *f = fopen(caminho.c_str(), "w");
+    if (!f) {
+        perror(caminho.c_str());
+        return false;
+    }
+    fprintf(f, "P1\n%d %d\n", LARGURA, ALTURA);
+    for (int y = 0; y < ALTURA; ++y) {
+        for (int x = 0; x < LARGURA; ++x) fputc(pixel(x, y) ? '1' : '0', f);
+        fputc('\n', f);
+    }
+    return fclose(f) == 0;
+}
+
+long OledEmulador::comparar_pbm(const std::string &caminho) const {
+    std::ifstream f(caminho);
+    std::string magico;
+    int largura = 0, altura = 0;
+    if (!(f >> magico >> largura >> altura) || magico != "P1" || largura != LARGURA || altura != ALTURA)
+        return -1;
+
+    long diferentes = 0;
+    for (int y = 0; y < ALTURA; ++y) {
+        for (int x = 0; x < LARGURA; ++x) {
+            char c;
+            if (!(f >> c)) return -1;
+            if ((c == '1') != pixel(x, y)) diferentes++;
+        }
+    }
+    return diferentes;
+}
+
+std::string OledEmulador::texto() const {
+    std::string s;
+    s.reserve((LARGURA + 1) * ALTURA);
+    for (int y = 0; y < ALTURA; ++y) {
+        for (int x = 0; x < LARGURA; ++x) s += pixel(x, y) ? '#' : '.';
+        s += '\n';
+    }
+    return s;
+}
+
+OledEmulador &oled_emulador() {
+    static OledEmulador oled;
+    return oled;
+}
+
+// ---------------------------------------------------------------------
+// Stubs do SDK usados pelo ssd1306.c
+// ---------------------------------------------------------------------
+
+static i2c_hw_t i2c_hw_host = { 1, 0, 0, I2C_IC_STATUS_TFE_BITS, 0 };
+
+static irq_handler_t dma_irq_handler;
+static bool dma_irq_habilitado;
+static bool dma_irq_pendente;
+static int interrupcoes_desabilitadas;
+
+static void atender_dma_irq() {
+    if (interrupcoes_desabilitadas == 0 && dma_irq_pendente && dma_irq_habilitado && dma_irq_handler)
+        dma_irq_handler();
+}
+
+extern "C" {
+
+i2c_inst_t *i2c0, *i2c1;
+
+int i2c_write_blocking(i2c_inst_t *, uint8_t, const uint8_t *src, size_t len, bool) {
+    oled_emulador().transacao(src, len);
+    return (int)len;
+}
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *) { return &i2c_hw_host; }
+
+uint i2c_get_dreq(i2c_inst_t *, bool) { return 0; }
+
+int dma_claim_unused_channel(bool) { return 0; }
+
+dma_channel_config dma_channel_get_default_config(uint) { return dma_channel_config{0}; }
+void channel_config_set_transfer_data_size(dma_channel_config *, enum dma_channel_transfer_size) {}
+void channel_config_set_read_increment(dma_channel_config *, bool) {}
+void channel_config_set_write_increment(dma_channel_config *, bool) {}
+void channel_config_set_dreq(dma_channel_config *, uint) {}
+void dma_channel_configure(uint, const dma_channel_config *, volatile void *, const volatile void *, uint, bool) {}
+
+// Palavras data_cmd: o bit de STOP separa as transações
+void dma_channel_transfer_from_buffer_now(uint, const volatile void *read_addr, uint32_t transfer_count) {
+    const volatile uint16_t *palavras = (const volatile uint16_t *)read_addr;
+    uint8_t transacao[2048];
+    size_t n = 0;
+    for (uint32_t i = 0; i < transfer_count; ++i) {
+        if (n < sizeof(transacao)) transacao[n++] = palavras[i] & 0xFF;
+        if (palavras[i] & I2C_IC_DATA_CMD_STOP_BITS) {
+            oled_emulador().transacao(transacao, n);
+            n = 0;
+        }
+    }
+    if (n > 0) oled_emulador().transacao(transacao, n);
+    dma_irq_pendente = true;
+    atender_dma_irq();
+}
+
+bool dma_channel_is_busy(uint) { return false; }
+void dma_channel_set_irq1_enabled(uint, bool enabled) { dma_irq_habilitado = enabled; }
+bool dma_channel_get_irq1_status(uint) { return dma_irq_pendente; }
+void dma_channel_acknowledge_irq1(uint) { dma_irq_pendente = false; }
+
+void irq_add_shared_handler(uint, irq_handler_t handler, uint8_t) { dma_irq_handler = handler; }
+void irq_set_enabled(uint, bool) {}
+
+uint32_t save_and_disable_interrupts(void) {
+    interrupcoes_desabilitadas++;
+    return 0;
+}
+
+void restore_interrupts(uint32_t) {
+    if (interrupcoes_desabilitadas > 0) interrupcoes_desabilitadas--;
+    atender_dma_irq();
+}
+
+}
@@ -0,0 +1,110 @@
+#include "inc/relogio_emulador.h"
+#include <algorithm>
+
+void RelogioEmulador::reiniciar() {
+    agora_us_ = 0;
+    proximo_id_ = 1;
+    alarmes_.clear();
+}
+
+void RelogioEmulador::avancar(uint64_t us) {
+    uint64_t fim = agora_us_ + us;
+    for (;;) {
+        // Alarme mais próximo dentro do intervalo: o relógio para nele
+        auto prox = std::min_element(alarmes_.begin(), alarmes_.end(),
+                                     [](const Alarme &a, const Alarme &b) { return a.prazo_us < b.prazo_us; });
+        if (prox == alarmes_.end() || prox->prazo_us > fim) break;
+        if (prox->prazo_us > agora_us_) agora_us_ = prox->prazo_us;
+        disparar_vencidos();
+    }
+    agora_us_ = fim;
+}
+
+void RelogioEmulador::disparar_vencidos() {
+    for (size_t i = 0; i < alarmes_.size();) {
+        if (alarmes_[i].prazo_us > agora_us_) {
+            i++;
+            continue;
+        }
+        Alarme a = alarmes_[i];
+        alarmes_.erase(alarmes_.begin() + (long)i);
+        // Retorno positivo reagenda em relação ao prazo, negativo ao agora
+        int64_t r = a.callback(a.id, a.dados);
+        if (r > 0) a.prazo_us += (uint64_t)r;
+        else if (r < 0) a.prazo_us = agora_us_ + (uint64_t)-r;
+        if (r != 0) alarmes_.push_back(a);
+        i = 0;
+    }
+}
+
+alarm_id_t RelogioEmulador::agendar(uint64_t prazo_us, alarm_callback_t callback, void *dados) {
+    // Ids nunca se repetem: cancelar um alarme que já disparou não tem efeito
+    alarm_id_t id = proximo_id_++;
+    alarmes_.push_back({id, prazo_us, callback, dados});
+    return id;
+}
+
+bool RelogioEmulador::cancelar(alarm_id_t id) {
+    for (size_t i = 0; i < alarmes_.size(); ++i) {
+        if (alarmes_[i].id == id) {
+            alarmes_.erase(alarmes_.begin() + (long)i);
+            return true;
+        }
+    }
+    return false;
+}
+
+RelogioEmulador &relogio_emulador() {
+    static RelogioEmulador relogio;
+    return relogio;
+}
+
+// ---------------------------------------------------------------------
+// Stubs do SDK (pico/time.h e hardware/timer.h, via pico/stdlib.h)
+// ---------------------------------------------------------------------
+
+extern "C" {
+
+uint32_t time_us_32(void) {
+    return (uint32_t)relogio_emulador().agora_us();
+}
+
+uint64_t time_us_64(void) {
+    return relogio_emulador().agora_us();
+}
+
+absolute_time_t get_absolute_time(void) {
+    return relogio_emulador().agora_us();
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return relogio_emulador().agora_us() + (uint64_t)ms * 1000;
+}
+
+bool time_reached(absolute_time_t t) {
+    return relogio_emulador().agora_us() >= t;
+}
+
+void sleep_ms(uint32_t ms) {
+    relogio_emulador().avancar((uint64_t)ms * 1000);
+}
+
+void sleep_us(uint64_t us) {
+    relogio_emulador().avancar(us);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    RelogioEmulador &r = relogio_emulador();
+    if (ms == 0) {
+        // Prazo já vencido: com fire_if_past o callback roda aqui e não há id
+        if (fire_if_past) callback(0, user_data);
+        return 0;
+    }
+    return r.agendar(r.agora_us() + (uint64_t)ms * 1000, callback, user_data);
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    return relogio_emulador().cancelar(id);
+}
+
+}
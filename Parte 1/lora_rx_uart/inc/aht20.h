@@ -0,0 +1,68 @@
+#ifndef AHT20_H
+#define AHT20_H
+
+
+#include "hardware/i2c.h" // Incluído para a definição de i2c_inst_t
+#include <stdbool.h>      // Incluído para a definição de bool, true, false
+#include <stdint.h>
+#include "sensor_driver.h"
+
+// Endereço I2C do AHT20
+#define AHT20_I2C_ADDR  0x38
+
+// Comandos do AHT20
+#define AHT20_CMD_INIT      0xBE
+#define AHT20_CMD_TRIGGER   0xAC
+#define AHT20_CMD_RESET     0xBA
+
+// Tempo de conversão após o comando de medição (datasheet: 80 ms)
+#define AHT20_CONVERSAO_MS  80
+
+// Temperatura e umidade em décimos (°C e %UR), em ponto fixo: o RP2040
+// não tem FPU e o resto do caminho (telemetria, tela) já usa décimos
+typedef struct {
+    int16_t temperature_x10;
+    int16_t humidity_x10;
+} AHT20_Data;
+
+// Resultado da coleta de uma medição disparada
+typedef enum {
+    AHT20_OK,           // Dados lidos
+    AHT20_OCUPADO,      // Conversão ainda em andamento: tentar depois
+    AHT20_ERRO,         // Falha no barramento ou nenhuma medição disparada
+    AHT20_ERRO_CRC      // Dados lidos, mas o CRC-8 não confere
+} aht20_status_t;
+
+// Inicializa o sensor AHT20
+bool aht20_init(i2c_inst_t *i2c);
+
+// Faz a leitura de temperatura e umidade do AHT20 (bloqueia durante a
+// conversão; equivale a aht20_trigger + espera + aht20_collect)
+bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data);
+
+// Medição não bloqueante: aht20_trigger envia o comando e arma um alarme
+// para o fim da conversão; aht20_ready indica que o alarme disparou e
+// aht20_collect lê e confere (CRC) o resultado. Com 'disparar_proxima' a
+// próxima medição é disparada logo após a leitura (pipeline).
+bool aht20_trigger(i2c_inst_t *i2c);
+bool aht20_ready(void);
+bool aht20_busy(void);
+aht20_status_t aht20_collect(i2c_inst_t *i2c, AHT20_Data *data, bool disparar_proxima);
+
+// Conversão dos valores brutos de 20 bits para décimos, arredondando o
+// valor exato ao décimo mais próximo (empate para o par, como o %.1f)
+int16_t aht20_humidity_x10(uint32_t raw);
+int16_t aht20_temperature_x10(uint32_t raw);
+
+// Reseta o sensor AHT20 (descarta a medição em andamento e reinicializa)
+bool aht20_reset(i2c_inst_t *i2c);
+
+bool aht20_check(i2c_inst_t *i2c);
+
+// CRC-8 do AHT20 (polinômio 0x31, valor inicial 0xFF) sobre status e dados
+uint8_t aht20_crc8(const uint8_t *dados, size_t n);
+
+// Driver para o registro de sensores: grandezas T (°C) e U (%), em décimos
+extern const sensor_driver_t aht20_driver;
+
+#endif // AHT20_H
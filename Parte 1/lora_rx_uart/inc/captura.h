@@ -0,0 +1,54 @@
+#ifndef CAPTURA_H
+#define CAPTURA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Formato de captura de quadros LoRa (.lcap)
+//
+// Arquivo: "LCAP" + u8 versão, seguido de registros concatenados.
+// Registro (little-endian):
+//   u8  tamanho do payload
+//   u8  flags (CAPTURA_*)
+//   u64 instante em us
+//   i16 RSSI (dBm)
+//   i8  SNR (dB)
+//   u8  RegModemConfig1, u8 RegModemConfig2
+//   u32 frequência em Hz
+//   payload
+//
+// No gateway cada registro sai pela USB como uma linha "CAP:<hex>".
+
+#define CAPTURA_MAGICO          "LCAP"
+#define CAPTURA_VERSAO          1
+#define CAPTURA_CABECALHO       19
+#define CAPTURA_MAX_REGISTRO    (CAPTURA_CABECALHO + 255)
+#define CAPTURA_PREFIXO         "CAP:"
+
+// Flags do registro
+#define CAPTURA_CRC_OK          0x01
+#define CAPTURA_HEADER_OK       0x02
+
+typedef struct {
+    uint64_t t_us;
+    uint32_t freq_hz;
+    int16_t rssi;
+    int8_t snr;
+    uint8_t flags;
+    uint8_t modem_config1;
+    uint8_t modem_config2;
+    uint8_t length;
+    uint8_t payload[255];
+} captura_registro_t;
+
+// Serializa o registro; retorna o número de bytes escritos (0 se não couber)
+size_t captura_serializar(const captura_registro_t *reg, uint8_t *buf, size_t len);
+
+// Lê um registro de buf; retorna os bytes consumidos (0 se incompleto)
+size_t captura_desserializar(const uint8_t *buf, size_t len, captura_registro_t *reg);
+
+// Emite o registro na saída padrão como linha "CAP:<hex>"
+void captura_emitir(const captura_registro_t *reg);
+
+#endif
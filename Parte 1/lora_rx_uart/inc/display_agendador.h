@@ -0,0 +1,36 @@
+#ifndef DISPLAY_AGENDADOR_H
+#define DISPLAY_AGENDADOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "ssd1306.h"
+
+// Maior estado de tela publicado pela aplicação
+#define DISPLAY_ESTADO_MAX 128
+
+// Período padrão entre quadros (10 fps)
+#define DISPLAY_PERIODO_MS 100
+
+// Desenha o estado no framebuffer; retorna true se algo mudou
+typedef bool (*display_render_fn)(ssd1306_t *ssd, const void *estado);
+
+typedef struct {
+    uint32_t publicacoes;   // Chamadas a display_agendador_publicar
+    uint32_t quadros;       // Estados efetivamente desenhados
+    uint32_t envios;        // Quadros enviados ao display
+} display_agendador_stats_t;
+
+// Leva o desenho e o envio para o core 1. A aplicação só publica o estado;
+// publicações entre dois quadros são agrupadas e o display é atualizado no
+// máximo a cada 'periodo_ms'. Com 'dma' o envio usa ssd1306_send_data_async
+// (o canal e o IRQ ficam no core 1).
+void display_agendador_iniciar(ssd1306_t *ssd, display_render_fn render, size_t tamanho,
+                               uint32_t periodo_ms, bool dma);
+
+// Copia o estado (tamanho informado em iniciar) e agenda um quadro
+void display_agendador_publicar(const void *estado);
+
+void display_agendador_stats(display_agendador_stats_t *stats);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "rfm95.h"
+
+// Nós acompanhados na deduplicação dos reenvios
+#define GATEWAY_NOS 8
+
+// Um seq até esta distância abaixo do último recebido do nó é reenvio
+// (confirmação perdida); mais longe, o nó recomeçou a contagem
+#define GATEWAY_JANELA_DUP 64
+
+// Histograma de latência em faixas de potência de 2:
+// a faixa i conta amostras em [2^i, 2^(i+1)) us
+#define GATEWAY_LAT_FAIXAS 24
+
+// Comandos de configuração na fila, um por nó
+#define GATEWAY_COMANDOS 8
+#define GATEWAY_COMANDO_MAX 120
+
+typedef struct {
+    uint32_t faixas[GATEWAY_LAT_FAIXAS];
+    uint32_t amostras;
+    uint32_t max_us;
+} gateway_histograma_t;
+
+typedef struct {
+    gateway_histograma_t fila_no;       // Amostra -> início do TX, informado pelo nó
+    gateway_histograma_t tempo_no_ar;   // Calculado pelo perfil de modem
+    gateway_histograma_t fila_gateway;  // RxDone (IRQ) -> tratamento do pacote
+    gateway_histograma_t fim_a_fim;     // Soma das três parcelas
+} gateway_latencia_t;
+
+// Estado da aplicação de recepção, independente do hardware para que
+// capturas possam ser reprocessadas no host (lora_host/lora_replay)
+typedef struct {
+    char last_message[64];
+    int16_t last_rssi;
+    int8_t last_snr;
+    uint32_t rx_count;
+    uint32_t amostras_lote;     // Amostras que chegaram em quadros de lote
+    uint32_t duplicadas;        // Amostras reenviadas que já tinham chegado
+    uint32_t configuracoes;     // Respostas dos nós a comandos de configuração
+    gateway_latencia_t latencia;
+} gateway_estado_t;
+
+void gateway_init(void);
+
+// Perfil de modem usado no cálculo do tempo no ar
+void gateway_set_perfil(const rfm95_profile_t *profile);
+
+// Trata um pacote recebido no instante agora_us; retorna true se ele foi
+// aceito. Quadros de lote (lote.h) saem como uma mensagem por amostra, com
+// a idade em " ~<segundos>"; amostras repetidas não saem de novo
+bool gateway_processar(const rfm95_packet_t *packet, uint64_t agora_us);
+
+// Confirmação pedida pelo último pacote aceito (RFM95_FLAG_PEDE_ACK):
+// "A:<seq>", cumulativa até o último seq do quadro, com ";C:<id>:<campos>"
+// se há comando na fila para o nó. false se não há confirmação a enviar
+bool gateway_confirmacao(uint8_t *destino, char *out, size_t len);
+
+// Põe na fila um comando de configuração ("chave=valor,...", config.h do
+// nó) para 'destino'. Ele segue em toda confirmação para esse nó até a
+// resposta "P<n>:CFG=<id> ..." chegar, que sai como "Config no <n>: ...";
+// substitui o que o nó ainda tinha na fila. Retorna o id ou 0 se não coube
+uint16_t gateway_comando(uint8_t destino, const char *campos);
+
+// Campos do último comando que um nó aceitou (resposta "g=<geração>") desde
+// a chamada anterior, para o gateway acompanhar uma troca do enlace
+// (config_seguir). false se não houve nenhum
+bool gateway_comando_aceito(char *campos, size_t len);
+
+// Tempo no ar de um quadro de 'length' bytes no perfil atual (tempo_no_ar_us)
+uint32_t gateway_tempo_no_ar_us(uint8_t length);
+
+const gateway_estado_t *gateway_estado(void);
+
+// Resumo dos histogramas de latência na saída padrão
+void gateway_imprimir_latencias(void);
+
+// Contadores do driver (rfm95_get_stats) como linhas "MET"
+void gateway_imprimir_metricas(const rfm95_stats_t *stats);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Amostras por quadro de lote
+#define LOTE_MAX 8
+
+// Quadro de lote, para reenviar as amostras guardadas no diário do nó:
+//
+//   "P2:L#<seq>|<idade_s> <campos>|<idade_s> <campos>..."
+//
+// As amostras têm seqs consecutivos a partir de <seq>, <idade_s> é a
+// idade de cada uma (em segundos) no envio do quadro e <campos> é o texto
+// da telemetria ("T=23.4C U=56.7%" ou "E=crc")
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    uint32_t seq0;
+    uint8_t n;
+} lote_t;
+
+// 'no' é o prefixo do nó ("P2")
+void lote_iniciar(lote_t *l, char *buf, size_t cap, const char *no, uint32_t seq0);
+
+// Acrescenta a próxima amostra; false se ela não cabe (o quadro fica como
+// estava)
+bool lote_adicionar(lote_t *l, uint32_t idade_s, const char *campos);
+
+// Leitura de um quadro de lote no gateway
+typedef struct {
+    const char *p;
+    char no[8];
+    uint32_t seq;
+} lote_leitor_t;
+
+// Reconhece um quadro de lote
+bool lote_abrir(lote_leitor_t *r, const char *msg);
+
+// Próxima amostra do quadro; false no fim
+bool lote_proxima(lote_leitor_t *r, uint32_t *seq, uint32_t *idade_s, char *campos, size_t len);
+
+#endif
@@ -21,6 +21,7 @@
 #define REG_RX_NB_BYTES             0x13
 #define REG_PKT_SNR_VALUE           0x19
 #define REG_PKT_RSSI_VALUE          0x1A
+#define REG_HOP_CHANNEL             0x1C
 #define REG_MODEM_CONFIG            0x1D
 #define REG_MODEM_CONFIG2           0x1E
 #define REG_PREAMBLE_MSB            0x20
@@ -72,26 +73,103 @@
 #define CRC_OFF                     0x00
 #define CRC_ON                      0x04
 
+// RegHopChannel: CRC presente no cabeçalho do pacote recebido
+#define HOP_CHANNEL_CRC_ON_PAYLOAD  0x40
+
 // Power Amplifier Config
 #define PA_DAC_20                   0x87
 
 // Flags de interrupção (do rfm95.h original)
 #define RFM95_IRQ_TX_DONE           0x08
+#define RFM95_IRQ_VALID_HEADER      0x10
+#define RFM95_IRQ_PAYLOAD_CRC_ERROR 0x20
 #define RFM95_IRQ_RX_DONE           0x40
+#define RFM95_IRQ_RX_TIMEOUT        0x80
+
+// Cabeçalho de endereçamento opcional, no início do payload LoRa.
+// O SX1276 não filtra endereços em modo LoRa; com o filtro ativo o
+// driver lê só estes bytes do FIFO antes de decidir se lê o restante.
+#define RFM95_HEADER_LEN            4
+#define RFM95_ADDR_BROADCAST        0xFF
+
+// Flags do cabeçalho usados pelas aplicações
+#define RFM95_FLAG_PEDE_ACK         0x01    // O destino deve confirmar o quadro
+#define RFM95_FLAG_ACK              0x02    // Confirmação ("A:<seq>")
+
+// Maior mensagem entregue em rfm95_packet_t (com o terminador), o
+// suficiente para os quadros de lote do nó
+#define RFM95_MENSAGEM_MAX          200
+
+typedef struct {
+    uint8_t net_id;
+    uint8_t dst;
+    uint8_t src;
+    uint8_t flags;
+} rfm95_header_t;
 
 // Estrutura para dados recebidos
 typedef struct {
-    char message[64];
+    char message[RFM95_MENSAGEM_MAX];
+    rfm95_header_t header;  // Válido se addressed
+    bool addressed;
+    uint64_t timestamp_us;  // Instante do RxDone (capturado na IRQ)
     int16_t rssi;
     int8_t snr;
     uint8_t length;
     bool valid;
 } rfm95_packet_t;
 
+// Quadro bruto entregue ao callback de captura (inclui quadros com erro)
+typedef struct {
+    const uint8_t *data;
+    uint64_t time_us;
+    int16_t rssi;
+    int8_t snr;
+    uint8_t length;
+    uint8_t irq_flags;
+} rfm95_frame_t;
+
+typedef void (*rfm95_capture_cb_t)(const rfm95_frame_t *frame);
+
+// Perfil de modem ativo, como configurado por rfm95_config
+typedef struct {
+    uint32_t freq_hz;
+    uint8_t modem_config1;
+    uint8_t modem_config2;
+    uint8_t modem_config3;
+    int8_t tx_power;
+} rfm95_profile_t;
+
+// Estatísticas do enlace e de erros de PHY
+#define RFM95_RSSI_BUCKETS          14  // Faixas de 10 dB, de -140 a 0 dBm
+#define RFM95_SNR_BUCKETS           8   // Faixas de 5 dB, de -20 a +20 dB
+
+typedef struct {
+    uint32_t rx_ok;             // Quadros entregues
+    uint32_t crc_errors;        // PayloadCrcError
+    uint32_t header_errors;     // Sem ValidHeader ou sem CRC no cabeçalho
+    uint32_t oversize_drops;    // Vazios ou maiores que rfm95_packet_t
+    uint32_t foreign_drops;     // Outra rede ou outro destino (filtro)
+    uint32_t rx_timeouts;
+    uint32_t tx_ok;
+    uint32_t tx_timeouts;       // TxDone não veio no dobro do tempo no ar + 100 ms
+    uint32_t rssi_hist[RFM95_RSSI_BUCKETS];
+    uint32_t snr_hist[RFM95_SNR_BUCKETS];
+} rfm95_stats_t;
+
 // Funções públicas
 void rfm95_init(spi_inst_t *spi, uint cs, uint rst, uint irq);
 void rfm95_config(float freq, int tx_power);
+// Troca o perfil de modem (RegModemConfig1..3), em standby; o rádio fica
+// em standby
+void rfm95_set_modem(uint8_t modem_config1, uint8_t modem_config2, uint8_t modem_config3);
+// Tempo no ar de um quadro de 'length' bytes (cabeçalho incluído) no
+// perfil de modem atual (tempo_no_ar_us)
+uint32_t rfm95_tempo_no_ar_us(uint8_t length);
 void rfm95_send_message(const char *msg);
+void rfm95_send_to(uint8_t dst, uint8_t flags, const char *msg);
+void rfm95_set_address(uint8_t net_id, uint8_t addr);
+void rfm95_set_address_filter(bool enabled);
 bool rfm95_receive_message(rfm95_packet_t *packet);
 void rfm95_set_mode_rx(void);
 void rfm95_set_mode_tx(void);
@@ -99,5 +177,10 @@ void rfm95_set_mode_standby(void);
 bool rfm95_available(void);
 int16_t rfm95_get_rssi(void);
 int8_t rfm95_get_snr(void);
+void rfm95_set_capture_callback(rfm95_capture_cb_t cb);
+void rfm95_get_profile(rfm95_profile_t *profile);
+uint64_t rfm95_get_tx_done_us(void);
+void rfm95_get_stats(rfm95_stats_t *stats);
+void rfm95_reset_stats(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef SENSOR_DRIVER_H
+#define SENSOR_DRIVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/i2c.h"
+
+// Grandezas que um único sensor pode fornecer
+#define SENSOR_GRANDEZAS_MAX 4
+
+// Descrição de uma grandeza: rótulo e unidade da telemetria ("T=23.4C") e
+// casas decimais do valor inteiro (1 = décimos)
+typedef struct {
+    const char *rotulo;
+    const char *unidade;
+    uint8_t decimais;
+} sensor_grandeza_t;
+
+// Resultado da coleta de uma medição disparada
+typedef enum {
+    SENSOR_COLETA_OK,
+    SENSOR_COLETA_OCUPADO,  // Conversão ainda em andamento: tentar depois
+    SENSOR_COLETA_ERRO,     // Sem resposta no barramento
+    SENSOR_COLETA_CRC       // Dados lidos, mas a verificação falhou
+} sensor_coleta_t;
+
+// Driver de um sensor do barramento I2C dos sensores. A medição é sempre
+// em duas fases: 'disparar' só envia o comando (sem esperar) e 'coletar'
+// lê o resultado depois de 'conversao_ms', gravando um valor por grandeza.
+// O registro dos sensores agenda as fases de todos no mesmo barramento.
+typedef struct {
+    const char *nome;
+    uint8_t n_grandezas;
+    const sensor_grandeza_t *grandezas;
+    uint32_t conversao_ms;
+    bool (*iniciar)(i2c_inst_t *i2c);
+    bool (*disparar)(i2c_inst_t *i2c);
+    sensor_coleta_t (*coletar)(i2c_inst_t *i2c, int16_t *valores);
+    bool (*resetar)(i2c_inst_t *i2c);
+} sensor_driver_t;
+
+#endif
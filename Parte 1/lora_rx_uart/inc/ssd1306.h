@@ -1,9 +1,42 @@
+#ifndef SSD1306_H
+#define SSD1306_H
+
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "hardware/dma.h"
+
+// Geometria do painel fixada na compilação (128x64 ou 128x32, por
+// exemplo com -DSSD1306_HEIGHT=32): buffers estáticos e índices constantes
+#ifndef SSD1306_WIDTH
+#define SSD1306_WIDTH 128
+#endif
+#ifndef SSD1306_HEIGHT
+#define SSD1306_HEIGHT 64
+#endif
+
+#if SSD1306_HEIGHT != 64 && SSD1306_HEIGHT != 32
+#error "SSD1306_HEIGHT deve ser 64 ou 32"
+#endif
+
+#define WIDTH SSD1306_WIDTH
+#define HEIGHT SSD1306_HEIGHT
+
+// Páginas de 8 linhas por coluna no ram_buffer
+#define SSD1306_PAGES (SSD1306_HEIGHT / 8)
+
+// Framebuffer + byte de controle 0x40 em [0]
+#define SSD1306_BUFSIZE (SSD1306_WIDTH * SSD1306_PAGES + 1)
 
-#define WIDTH 128
-#define HEIGHT 64
+// Palavras data_cmd por janela além dos dados: controle 0x00 com os 6
+// comandos de endereçamento e o controle de dados 0x40
+#define SSD1306_DMA_WINDOW_WORDS 8
+
+// Palavras de um buffer de DMA: pior caso de uma janela por página
+#define SSD1306_DMA_WORDS (SSD1306_BUFSIZE + SSD1306_PAGES * SSD1306_DMA_WINDOW_WORDS)
+
+// Maior sequência de comandos enviada em uma única transação
+#define SSD1306_STREAM_MAX 32
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -26,18 +59,53 @@ typedef enum {
 } ssd1306_command_t;
 
 typedef struct {
-  uint8_t width, height, pages, address;
+  uint8_t address;
   i2c_inst_t *i2c_port;
   bool external_vcc;
-  uint8_t *ram_buffer;
-  size_t bufsize;
   uint8_t port_buffer[2];
+  // Faixa de colunas alterada em cada página desde o último envio
+  // (dirty_x0 > dirty_x1 indica página limpa)
+  uint8_t dirty_x0[SSD1306_PAGES];
+  uint8_t dirty_x1[SSD1306_PAGES];
+  uint32_t bytes_last_frame;    // Bytes I2C do último ssd1306_send_data
+  uint32_t bytes_total;
+  // Envio assíncrono por DMA (dma_chan < 0 quando desativado): um buffer
+  // em voo e outro montado pelo próximo quadro
+  int dma_chan;
+  uint16_t dma_len[2];
+  uint8_t dma_fill;             // Buffer livre para o próximo quadro
+  int8_t dma_pending;           // Buffer pronto aguardando o canal (-1: nenhum)
+  volatile bool frame_done;     // Último quadro entregue à FIFO do I2C
+  // Buffers estáticos: o ssd1306_t é declarado global pela aplicação
+  uint8_t ram_buffer[SSD1306_BUFSIZE];
+  uint8_t tx_buffer[SSD1306_BUFSIZE];     // Janela empacotada para envio parcial
+  uint16_t dma_words[2][SSD1306_DMA_WORDS];
 } ssd1306_t;
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
+// Modo de endereçamento vertical: cada coluna ocupa SSD1306_PAGES bytes
+// seguidos (uma página de 8 linhas por byte, bit 0 no topo)
+static inline uint16_t ssd1306_index(uint8_t x, uint8_t page) {
+  return x * SSD1306_PAGES + page + 1;
+}
+
+void ssd1306_init(ssd1306_t *ssd, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
 void ssd1306_config(ssd1306_t *ssd);
 void ssd1306_command(ssd1306_t *ssd, uint8_t command);
+void ssd1306_command_stream(ssd1306_t *ssd, const uint8_t *commands, size_t count);
+void ssd1306_set_contrast(ssd1306_t *ssd, uint8_t contrast);
+void ssd1306_set_invert(ssd1306_t *ssd, bool invert);
 void ssd1306_send_data(ssd1306_t *ssd);
+void ssd1306_invalidate(ssd1306_t *ssd);
+// Para quem escreve direto no ram_buffer (colunas x0..x1, páginas p0..p1)
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1);
+
+// Com o DMA o endereço fica fixo no TAR e os quadros seguem sem parar o
+// controlador; chamadas bloqueantes no mesmo barramento (comandos,
+// ssd1306_send_data) o param e devem vir depois de ssd1306_wait
+bool ssd1306_init_dma(ssd1306_t *ssd);
+bool ssd1306_send_data_async(ssd1306_t *ssd);
+bool ssd1306_busy(ssd1306_t *ssd);
+void ssd1306_wait(ssd1306_t *ssd);
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
@@ -46,4 +114,6 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value);
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value);
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y);
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
\ No newline at end of file
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
+
+#endif
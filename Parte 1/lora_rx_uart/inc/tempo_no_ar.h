@@ -0,0 +1,16 @@
+#ifndef TEMPO_NO_AR_H
+#define TEMPO_NO_AR_H
+
+#include <stdint.h>
+#include "rfm95.h"
+
+// Símbolos de preâmbulo programados por rfm95_config
+#define TEMPO_PREAMBULO_SIMBOLOS 8
+
+// Tempo no ar de um quadro LoRa de 'length' bytes (cabeçalho incluído) no
+// perfil de modem dado (fórmula da seção 4.1.1.7 do datasheet SX1276); 0
+// para um perfil inválido. Sem acesso ao rádio: o nó e o gateway usam a
+// mesma conta, inclusive nas ferramentas de host
+uint32_t tempo_no_ar_us(const rfm95_profile_t *perfil, uint8_t length);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef WIDGETS_H
+#define WIDGETS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+// Texto renderizado de um widget (prefixo + valor + unidade)
+#define WIDGET_TEXTO_MAX 48
+
+// Largura de um caractere da fonte em pixels
+#define WIDGET_CHAR_W 8
+
+typedef enum {
+    WIDGET_ROTULO,      // Texto fixo
+    WIDGET_CONTADOR,    // Prefixo + inteiro sem sinal
+    WIDGET_VALOR,       // Prefixo + inteiro com casas decimais + unidade
+    WIDGET_STATUS       // Prefixo + texto variável
+} widget_tipo_t;
+
+// Widget retido: guarda o que está desenhado e só é redesenhado (apenas a
+// sua região) quando o conteúdo muda. A região é colunas x linhas de
+// caracteres a partir de (x, y); o texto quebra de linha dentro dela.
+typedef struct {
+    widget_tipo_t tipo;
+    uint8_t x, y;
+    uint8_t colunas, linhas;
+    const char *prefixo;
+    const char *unidade;
+    uint8_t decimais;
+    bool visivel;
+    bool sujo;
+    int32_t valor;
+    char texto[WIDGET_TEXTO_MAX];
+} widget_t;
+
+void widget_rotulo(widget_t *w, uint8_t x, uint8_t y, uint8_t colunas, const char *texto);
+void widget_contador(widget_t *w, uint8_t x, uint8_t y, uint8_t colunas, const char *prefixo);
+void widget_valor(widget_t *w, uint8_t x, uint8_t y, uint8_t colunas, const char *prefixo,
+                  uint8_t decimais, const char *unidade);
+void widget_status(widget_t *w, uint8_t x, uint8_t y, uint8_t colunas, uint8_t linhas, const char *prefixo);
+
+// Setters: marcam o widget para redesenho só se o conteúdo mudou
+void widget_set_valor(widget_t *w, int32_t valor);
+void widget_set_texto(widget_t *w, const char *texto);
+void widget_set_visivel(widget_t *w, bool visivel);
+
+// Força o redesenho de todos (após limpar a tela, por exemplo)
+void widgets_invalidar(widget_t *widgets, uint8_t n);
+
+// Redesenha no framebuffer os widgets alterados; as regiões tocadas ficam
+// marcadas no ssd1306 para o envio parcial. Retorna quantos foram redesenhados
+uint8_t widgets_desenhar(ssd1306_t *ssd, widget_t *widgets, uint8_t n);
+
+#endif
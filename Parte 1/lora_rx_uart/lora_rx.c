@@ -1,16 +1,31 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
 #include "hardware/i2c.h"
 #include "inc/rfm95.h"
 #include "inc/ssd1306.h"
+#include "inc/tela.h"
+#include "inc/display_agendador.h"
+#include "inc/gateway.h"
+#include "inc/captura.h"
+#include "inc/config.h"
 
 
 #define PIN_RST   20
 #define PIN_CS    17
 #define PIN_IRQ   8
 
+// Rádio de fábrica, o mesmo do nó (lora_tx.c); o perfil em vigor fica na
+// flash (config.c) e muda pela USB ou acompanhando o nó
+#define FREQUENCIA_KHZ    915000
+#define POTENCIA_DBM      20
+
+// Endereçamento LoRa (cabeçalho filtrado no gateway)
+#define REDE_ID           0x2A
+#define ENDERECO_GATEWAY  0x01
+
 #define LED_TESTE     15
 #define LED_AZUL      12
 #define LED_VERDE     11
@@ -30,14 +45,33 @@
 #define SENSOR_I2C_SCL    1
 #define SENSOR_I2C_PORT i2c0
 
+// Intervalo entre os relatórios de métricas na USB
+#define METRICAS_PERIODO_US  (60 * 1000000ULL)
+
+// Tempo do LED verde aceso após um pacote aceito
+#define LED_RECEBIDO_US  (600 * 1000ULL)
+
+// Enlace seguido sem nenhum pacote aceito por esse tempo: volta ao
+// anterior, onde o nó também acaba depois de ENLACE_REVERSAO_FALHAS
+// tentativas sem ACK
+#define RADIO_REVERSAO_US  (10 * 60 * 1000000ULL)
+
 // Variáveis globais
 ssd1306_t display;
 
-static char last_message[64] = "Aguardando...";
 static char status_msg[32] = "PRONTO";
-static int16_t last_rssi = 0;
-static int8_t last_snr = 0;
-static uint32_t rx_count = 0;
+static bool captura_ativa = false;
+static uint64_t led_verde_ate = 0;    // 0: LED apagado
+
+// Perfil do rádio em vigor e o prazo do enlace provisório
+static config_t radio;
+static uint64_t radio_prazo_us;
+
+static const config_t padrao = {
+    .freq_khz = FREQUENCIA_KHZ, .potencia_dbm = POTENCIA_DBM,
+    .sf = 7, .largura_banda = 7, .codigo = 1,       // SF7, 125 kHz, 4/5
+    .rede_id = REDE_ID, .endereco = ENDERECO_GATEWAY,
+};
 
 void init_gpio(void) {
     gpio_init(LED_TESTE); gpio_set_dir(LED_TESTE, GPIO_OUT);
@@ -77,65 +111,208 @@ void init_sensor_i2c(void) {
     gpio_pull_up(SENSOR_I2C_SCL);
 }
 
+static bool desenhar_tela(ssd1306_t *ssd, const void *estado) {
+    return tela_atualizar(ssd, estado);
+}
+
 void init_display(void) {
-    ssd1306_init(&display, 128, 64, false, DISPLAY_ADDR, DISPLAY_I2C_PORT);
+    ssd1306_init(&display, false, DISPLAY_ADDR, DISPLAY_I2C_PORT);
     ssd1306_config(&display);
     ssd1306_fill(&display, false);
     
+    char linha[20];
     ssd1306_draw_string(&display, "LoRa BitDogLab", 0, 0);
-    ssd1306_draw_string(&display, "Freq: 915 MHz", 0, 8);
-    ssd1306_draw_string(&display, "Power: 20 dBm", 0, 16);
+    snprintf(linha, sizeof(linha), "Freq: %lu.%lu MHz", (unsigned long)(radio.freq_khz / 1000),
+             (unsigned long)(radio.freq_khz % 1000 / 100));
+    ssd1306_draw_string(&display, linha, 0, 8);
+    snprintf(linha, sizeof(linha), "Power: %d dBm", radio.potencia_dbm);
+    ssd1306_draw_string(&display, linha, 0, 16);
     ssd1306_draw_string(&display, "Status: INIT", 0, 24);
     ssd1306_send_data(&display);
     
     sleep_ms(2000);
+    tela_init(&display);
+    display_agendador_iniciar(&display, desenhar_tela, sizeof(tela_estado_t), DISPLAY_PERIODO_MS, true);
 }
 
 void update_display(void) {
-    char temp[64];
-    ssd1306_fill(&display, false);
+    // Só publica o estado: o core 1 desenha os widgets alterados a até
+    // 10 fps e envia por DMA, sem atrasar o tratamento dos pacotes
+    const gateway_estado_t *gw = gateway_estado();
+    tela_estado_t estado;
+    strncpy(estado.status, status_msg, sizeof(estado.status));
+    strncpy(estado.last_message, gw->last_message, sizeof(estado.last_message));
+    estado.rx_count = gw->rx_count;
+    estado.last_rssi = gw->last_rssi;
+    estado.last_snr = gw->last_snr;
+    estado.captura = captura_ativa;
+    display_agendador_publicar(&estado);
+}
 
-    ssd1306_draw_string(&display, "LoRa Transceiver", 0, 0);
-    ssd1306_hline(&display, 0, 127, 9, true);
-    snprintf(temp, sizeof(temp), "Status: %s", status_msg);
-    ssd1306_draw_string(&display, temp, 0, 12);
-    snprintf(temp, sizeof(temp), "RX:%lu", rx_count);
-    ssd1306_draw_string(&display, temp, 0, 20);
-    ssd1306_draw_string(&display, "Ultima msg:", 0, 28);
-    ssd1306_draw_string(&display, last_message, 0, 36);
-    if (last_rssi != 0) {
-        snprintf(temp, sizeof(temp), "RSSI:%ddBm SNR:%ddB", last_rssi, last_snr);
-        ssd1306_draw_string(&display, temp, 0, 44);
-    }
-    ssd1306_draw_string(&display, "Aguardando mensagem...", 0, 56);
-    ssd1306_send_data(&display);
+// Registra cada quadro recebido (inclusive os descartados) no formato .lcap
+void capturar_quadro(const rfm95_frame_t *frame) {
+    static captura_registro_t reg;
+    rfm95_profile_t profile;
+    rfm95_get_profile(&profile);
+
+    reg.t_us = frame->time_us;
+    reg.freq_hz = profile.freq_hz;
+    reg.rssi = frame->rssi;
+    reg.snr = frame->snr;
+    reg.modem_config1 = profile.modem_config1;
+    reg.modem_config2 = profile.modem_config2;
+    reg.flags = 0;
+    if (!(frame->irq_flags & RFM95_IRQ_PAYLOAD_CRC_ERROR)) reg.flags |= CAPTURA_CRC_OK;
+    if (frame->irq_flags & RFM95_IRQ_VALID_HEADER) reg.flags |= CAPTURA_HEADER_OK;
+    reg.length = frame->length;
+    memcpy(reg.payload, frame->data, frame->length);
+
+    captura_emitir(&reg);
+}
+
+void alternar_captura(void) {
+    captura_ativa = !captura_ativa;
+    rfm95_set_capture_callback(captura_ativa ? capturar_quadro : NULL);
+    printf("Captura %s\n", captura_ativa ? "ativada" : "desativada");
+    update_display();
+}
+
+// Leva o rádio para o perfil em vigor e o tempo no ar do gateway junto
+void aplicar_radio(void) {
+    uint8_t m1, m2, m3;
+    config_modem(&radio, &m1, &m2, &m3);
+    rfm95_config(radio.freq_khz / 1000.0f, radio.potencia_dbm);
+    rfm95_set_modem(m1, m2, m3);
+    rfm95_set_address(radio.rede_id, radio.endereco);
+    rfm95_set_mode_rx();
+
+    rfm95_profile_t profile;
+    rfm95_get_profile(&profile);
+    gateway_set_perfil(&profile);
+    printf("Radio: %lu kHz, %d dBm, SF%u, bw %u, 4/%u, rede 0x%02X, endereco %u%s\n",
+           (unsigned long)radio.freq_khz, radio.potencia_dbm, radio.sf, radio.largura_banda,
+           4 + radio.codigo, radio.rede_id, radio.endereco, radio.provisoria ? ", provisorio" : "");
+}
+
+// Grava e aplica 'novo'; provisório, ele volta ao anterior se nenhum
+// pacote chegar em RADIO_REVERSAO_US
+bool trocar_radio(config_t *novo, bool provisorio) {
+    novo->provisoria = provisorio;
+    if (!config_gravar(novo)) return false;
+    radio = *novo;
+    radio_prazo_us = time_us_64() + RADIO_REVERSAO_US;
+    aplicar_radio();
+    return true;
+}
+
+// O nó aceitou um comando: frequência, modem, rede e o endereço do gateway
+// mudam junto, depois da resposta, que ainda veio no perfil antigo
+void seguir_no(void) {
+    char campos[GATEWAY_COMANDO_MAX];
+    if (!gateway_comando_aceito(campos, sizeof(campos))) return;
+    config_t novo = radio;
+    if (!config_seguir(&novo, campos)) return;
+    if (!trocar_radio(&novo, true)) printf("Radio: falha na flash, enlace mantido\n");
+}
+
+// Primeiro pacote aceito no enlace seguido: ele passa a valer de vez
+void confirmar_radio(void) {
+    if (!radio.provisoria) return;
+    config_t novo = radio;
+    novo.provisoria = 0;
+    if (config_gravar(&novo)) radio = novo;
+}
+
+// Nada chegou no enlace seguido (a troca não pegou no nó, ou ele já
+// voltou): o gateway volta ao perfil do outro slot
+void reverter_radio(void) {
+    config_t anterior;
+    if (!radio.provisoria || time_us_64() < radio_prazo_us) return;
+    if (!config_anterior(&radio, &padrao, &anterior)) anterior = padrao;
+    // Gravado de novo com a geração seguinte, para valer depois de um reboot
+    anterior.geracao = radio.geracao;
+    if (!trocar_radio(&anterior, false)) return;
+    printf("Radio: nada recebido no enlace novo, de volta ao anterior\n");
+}
+
+// O nó espera a confirmação só por alguns centésimos de segundo: ela sai
+// antes de qualquer outra coisa
+void send_ack(void) {
+    uint8_t destino;
+    char ack[RFM95_MENSAGEM_MAX];
+    if (!gateway_confirmacao(&destino, ack, sizeof(ack))) return;
+    rfm95_send_to(destino, RFM95_FLAG_ACK, ack);
+    rfm95_set_mode_rx();
 }
 
 void check_received_messages(void) {
     rfm95_packet_t packet;
 
     if (rfm95_available()) {
-        if (rfm95_receive_message(&packet)) {
-            gpio_put(LED_VERDE, 1);
-            sleep_ms(100);
-
-            printf("Mensagem recebida: %s\n", packet.message);
-            printf("RSSI: %d dBm, SNR: %d dB\n", packet.rssi, packet.snr);
+        if (rfm95_receive_message(&packet) && gateway_processar(&packet, time_us_64())) {
+            send_ack();
+            confirmar_radio();
+            seguir_no();
 
-            strcpy(last_message, packet.message);
-            last_rssi = packet.rssi;
-            last_snr = packet.snr;
-            rx_count++;
+            // O LED e o status voltam ao normal pelo prazo no laço principal,
+            // sem bloquear a recepção do próximo pacote
+            gpio_put(LED_VERDE, 1);
+            led_verde_ate = time_us_64() + LED_RECEBIDO_US;
 
             strcpy(status_msg, "RECEBIDO");
             update_display();
-            sleep_ms(500);
-            gpio_put(LED_VERDE, 0);
-            strcpy(status_msg, "ESCUTANDO");
         }
     }
 }
 
+// "radio <chave=valor,...>" troca o rádio do gateway (f, p, sf, bw, cr,
+// rede e end, como em config_aplicar_texto) e grava na flash
+void comando_radio(const char *campos) {
+    char erro[8];
+    config_t novo = radio;
+    if (!config_aplicar_texto(&novo, campos, erro, sizeof(erro))) printf("Radio: chave recusada: %s\n", erro);
+    else if (!trocar_radio(&novo, false)) printf("Radio: falha na flash\n");
+}
+
+// Linhas "cfg <endereço> <chave=valor,...>" na USB põem um comando de
+// configuração na fila do gateway; ele segue com a próxima confirmação
+// para o nó, e uma troca de frequência, modem, rede ou gateway aceita pelo
+// nó leva o gateway junto (seguir_no). Lê só o que já chegou, sem
+// bloquear a recepção
+void ler_comandos_usb(void) {
+    static char linha[GATEWAY_COMANDO_MAX + 16];
+    static size_t n = 0;
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c != '\n' && c != '\r') {
+            if (n < sizeof(linha) - 1) linha[n++] = (char)c;
+            continue;
+        }
+        linha[n] = '\0';
+        n = 0;
+        if (strncmp(linha, "radio ", 6) == 0) {
+            comando_radio(linha + 6);
+            continue;
+        }
+        if (strncmp(linha, "cfg ", 4) != 0) continue;
+
+        char *campos;
+        unsigned long destino = strtoul(linha + 4, &campos, 10);
+        while (*campos == ' ') campos++;
+        uint16_t id = destino < RFM95_ADDR_BROADCAST && *campos ? gateway_comando((uint8_t)destino, campos) : 0;
+        if (id) printf("Comando %u para o no %lu na fila: %s\n", id, destino, campos);
+        else printf("Comando recusado: %s\n", linha);
+    }
+}
+
+void apagar_led_recebido(void) {
+    if (led_verde_ate == 0 || time_us_64() < led_verde_ate) return;
+    led_verde_ate = 0;
+    gpio_put(LED_VERDE, 0);
+    strcpy(status_msg, "ESCUTANDO");
+    update_display();
+}
+
 int main() {
     stdio_init_all();
     sleep_ms(2000);
@@ -143,17 +320,53 @@ int main() {
     init_gpio();
     init_spi();
     init_display_i2c();  // Inicializa I2C para display
+
+    // Perfil da flash (ou o de fábrica); um enlace ainda provisório tem o
+    // prazo contado a partir do boot
+    if (config_carregar(&radio, &padrao) < 0) printf("Radio: padrao do firmware\n");
+    radio_prazo_us = time_us_64() + RADIO_REVERSAO_US;
     init_display();
 
+    gateway_init();
     rfm95_init(spi0, PIN_CS, PIN_RST, PIN_IRQ);
-    rfm95_config(915.0, 20);
-    rfm95_set_mode_rx();
+    rfm95_set_address_filter(true);
+    aplicar_radio();
 
     strcpy(status_msg, "ESCUTANDO");
     update_display();
 
+    uint64_t ultimo_relatorio = time_us_64();
     while (true) {
         check_received_messages();
+        apagar_led_recebido();
+        reverter_radio();
+        ler_comandos_usb();
+
+        // Botão A liga/desliga a captura de quadros brutos
+        if (!gpio_get(BTN_A)) {
+            alternar_captura();
+            sleep_ms(300);
+        }
+
+        // Métricas periódicas, ou imediatas com o botão B
+        bool botao_b = !gpio_get(BTN_B);
+        if (botao_b || time_us_64() - ultimo_relatorio >= METRICAS_PERIODO_US) {
+            rfm95_stats_t stats;
+            rfm95_get_stats(&stats);
+            gateway_imprimir_metricas(&stats);
+            gateway_imprimir_latencias();
+
+            display_agendador_stats_t tela;
+            display_agendador_stats(&tela);
+            printf("MET display publicacoes=%lu quadros=%lu envios=%lu bytes=%lu\n",
+                   tela.publicacoes, tela.quadros, tela.envios, display.bytes_total);
+            const gateway_estado_t *gw = gateway_estado();
+            printf("MET lote amostras=%lu duplicadas=%lu\n",
+                   (unsigned long)gw->amostras_lote, (unsigned long)gw->duplicadas);
+            ultimo_relatorio = time_us_64();
+            if (botao_b) sleep_ms(300);
+        }
+
         sleep_ms(50);
     }
 
@@ -3,22 +3,30 @@
 #include "hardware/i2c.h"
 #include "../inc/aht20.h"
 
-#define AHT20_I2C_ADDR      0x38
-#define AHT20_CMD_INIT      0xBE
-#define AHT20_CMD_TRIGGER   0xAC
-#define AHT20_CMD_RESET     0xBA
 #define AHT20_STATUS_BUSY   0x80  // Bit de status ocupado
 #define AHT20_STATUS_CALIBRATED 0x08  // Bit de calibração
 
+// Limite de cada transação: 7 bytes a 400 kHz levam ~200 us; um barramento
+// preso devolve erro em vez de travar o laço principal
+#define AHT20_TIMEOUT_US    5000
+
+static int aht20_escrever(i2c_inst_t *i2c, const uint8_t *dados, size_t n) {
+    return i2c_write_timeout_us(i2c, AHT20_I2C_ADDR, dados, n, false, AHT20_TIMEOUT_US);
+}
+
+static int aht20_ler_bytes(i2c_inst_t *i2c, uint8_t *dados, size_t n) {
+    return i2c_read_timeout_us(i2c, AHT20_I2C_ADDR, dados, n, false, AHT20_TIMEOUT_US);
+}
+
 bool aht20_init(i2c_inst_t *i2c) {
     uint8_t init_cmd[3] = {AHT20_CMD_INIT, 0x08, 0x00};
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, init_cmd, 3, false);
+    if (aht20_escrever(i2c, init_cmd, 3) != 3) return false;
     sleep_ms(50);  // Aguarda o sensor inicializar
 
     // Verifica status até que o sensor esteja pronto
     uint8_t status;
     for (int i = 0; i < 10; i++) {
-        i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
+        if (aht20_ler_bytes(i2c, &status, 1) != 1) return false;
         if ((status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
             return true;  // Sensor calibrado e pronto
         }
@@ -28,52 +36,175 @@ bool aht20_init(i2c_inst_t *i2c) {
     return false;  // Falhou na calibração
 }
 
-bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
+// Estado da medição em andamento (um sensor por placa)
+static volatile bool conversao_pronta = false;
+static bool medindo = false;
+// Só o laço principal escreve 'alarme'; o callback apenas sinaliza o fim
+// da conversão. O id de um alarme que já disparou não é reaproveitado, e
+// cancel_alarm sobre ele não tem efeito
+static alarm_id_t alarme = 0;
+
+static int64_t aht20_fim_conversao(alarm_id_t id, void *user_data) {
+    conversao_pronta = true;
+    return 0;
+}
+
+static void aht20_cancelar_alarme(void) {
+    if (alarme > 0) cancel_alarm(alarme);
+    alarme = 0;
+}
+
+// n / 2^20 arredondado ao inteiro mais próximo, empate para o par
+static int32_t aht20_arredondar(int32_t n) {
+    bool negativo = n < 0;
+    uint32_t m = negativo ? -(uint32_t)n : (uint32_t)n;
+    uint32_t q = m >> 20;
+    uint32_t resto = m & 0xFFFFF;
+    if (resto > 0x80000 || (resto == 0x80000 && (q & 1))) q++;
+    return negativo ? -(int32_t)q : (int32_t)q;
+}
+
+// UR = raw * 100 / 2^20 -> décimos: raw * 1000 / 2^20 (cabe em 30 bits)
+int16_t aht20_humidity_x10(uint32_t raw) {
+    return (int16_t)aht20_arredondar((int32_t)(raw * 1000));
+}
+
+// T = raw * 200 / 2^20 - 50 -> décimos: (raw * 2000 - 500 * 2^20) / 2^20
+int16_t aht20_temperature_x10(uint32_t raw) {
+    return (int16_t)aht20_arredondar((int32_t)(raw * 2000) - (500 << 20));
+}
+
+bool aht20_trigger(i2c_inst_t *i2c) {
     uint8_t trigger_cmd[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
-    uint8_t buffer[6];
 
-    // Envia comando de medição
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false);
-    
-    // Aguarda até o sensor estar pronto
-    uint8_t status;
-    for (int i = 0; i < 10; i++) {
-        i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
-        if (!(status & AHT20_STATUS_BUSY)) {
-            break;
-        }
-        sleep_ms(10);
-    }
-    
-    // Se ainda estiver ocupado, falha na leitura
-    if (status & AHT20_STATUS_BUSY) {
-        return false;
-    }
+    aht20_cancelar_alarme();
+    conversao_pronta = false;
+    medindo = aht20_escrever(i2c, trigger_cmd, 3) == 3;
+    if (!medindo) return false;
+
+    alarme = add_alarm_in_ms(AHT20_CONVERSAO_MS, aht20_fim_conversao, NULL, true);
+    if (alarme <= 0) conversao_pronta = true;   // Sem alarme livre: o status decide
+    return true;
+}
 
-    // Lê os 6 bytes de dados
-    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, buffer, 6, false) != 6) {
-        return false;
+bool aht20_ready(void) {
+    return medindo && conversao_pronta;
+}
+
+bool aht20_busy(void) {
+    return medindo;
+}
+
+aht20_status_t aht20_collect(i2c_inst_t *i2c, AHT20_Data *data, bool disparar_proxima) {
+    uint8_t buffer[7];
+
+    if (!medindo) return AHT20_ERRO;
+    if (!conversao_pronta) return AHT20_OCUPADO;
+
+    // Status, 5 bytes de dados e o CRC-8. O status vem no primeiro byte:
+    // se ainda ocupado, espera mais 10 ms
+    if (aht20_ler_bytes(i2c, buffer, 7) != 7) {
+        medindo = false;
+        return AHT20_ERRO;
+    }
+    if (buffer[0] & AHT20_STATUS_BUSY) {
+        conversao_pronta = false;
+        alarme = add_alarm_in_ms(10, aht20_fim_conversao, NULL, true);
+        if (alarme <= 0) conversao_pronta = true;
+        return AHT20_OCUPADO;
     }
+    medindo = false;
+    if (aht20_crc8(buffer, 6) != buffer[6]) return AHT20_ERRO_CRC;
 
     // Processa os dados de umidade (20 bits)
     uint32_t raw_humidity = ((uint32_t)buffer[1] << 12) | ((uint32_t)buffer[2] << 4) | (buffer[3] >> 4);
-    data->humidity = (float)raw_humidity * 100.0 / 1048576.0;
+    data->humidity_x10 = aht20_humidity_x10(raw_humidity);
 
     // Processa os dados de temperatura (20 bits)
     uint32_t raw_temp = ((uint32_t)(buffer[3] & 0x0F) << 16) | ((uint32_t)buffer[4] << 8) | buffer[5];
-    data->temperature = ((float)raw_temp * 200.0 / 1048576.0) - 50.0;
+    data->temperature_x10 = aht20_temperature_x10(raw_temp);
 
-    return true;
+    if (disparar_proxima) aht20_trigger(i2c);
+    return AHT20_OK;
+}
+
+bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
+    if (!aht20_trigger(i2c)) return false;
+
+    // Até 100 ms além da conversão nominal, como antes
+    aht20_status_t st;
+    absolute_time_t limite = make_timeout_time_ms(AHT20_CONVERSAO_MS + 100);
+    while ((st = aht20_collect(i2c, data, false)) == AHT20_OCUPADO) {
+        if (time_reached(limite)) {
+            medindo = false;
+            return false;
+        }
+        sleep_ms(1);
+    }
+    return st == AHT20_OK;
 }
 
-void aht20_reset(i2c_inst_t *i2c) {
+bool aht20_reset(i2c_inst_t *i2c) {
     uint8_t reset_cmd = AHT20_CMD_RESET;
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, &reset_cmd, 1, false);
+
+    // Descarta a medição em andamento: o reset a invalida
+    aht20_cancelar_alarme();
+    medindo = false;
+
+    aht20_escrever(i2c, &reset_cmd, 1);
     sleep_ms(20);
-    aht20_init(i2c);
+    return aht20_init(i2c);
 }
 
 bool aht20_check(i2c_inst_t *i2c) {
     uint8_t status;
-    return i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false) == 1;
+    return aht20_ler_bytes(i2c, &status, 1) == 1;
 }
+
+uint8_t aht20_crc8(const uint8_t *dados, size_t n) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < n; ++i) {
+        crc ^= dados[i];
+        for (int b = 0; b < 8; ++b) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Adaptação ao registro de sensores (sensor_driver.h)
+static bool aht20_drv_disparar(i2c_inst_t *i2c) {
+    return aht20_trigger(i2c);
+}
+
+static sensor_coleta_t aht20_drv_coletar(i2c_inst_t *i2c, int16_t *valores) {
+    AHT20_Data dados;
+    switch (aht20_collect(i2c, &dados, false)) {
+    case AHT20_OK:
+        valores[0] = dados.temperature_x10;
+        valores[1] = dados.humidity_x10;
+        return SENSOR_COLETA_OK;
+    case AHT20_OCUPADO:
+        return SENSOR_COLETA_OCUPADO;
+    case AHT20_ERRO_CRC:
+        return SENSOR_COLETA_CRC;
+    default:
+        return SENSOR_COLETA_ERRO;
+    }
+}
+
+static const sensor_grandeza_t aht20_grandezas[] = {
+    { "T", "C", 1 },
+    { "U", "%", 1 },
+};
+
+const sensor_driver_t aht20_driver = {
+    .nome = "aht20",
+    .n_grandezas = 2,
+    .grandezas = aht20_grandezas,
+    .conversao_ms = AHT20_CONVERSAO_MS,
+    .iniciar = aht20_init,
+    .disparar = aht20_drv_disparar,
+    .coletar = aht20_drv_coletar,
+    .resetar = aht20_reset,
+};
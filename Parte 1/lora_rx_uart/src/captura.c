@@ -0,0 +1,58 @@
+#include "../inc/captura.h"
+#include <stdio.h>
+#include <string.h>
+
+size_t captura_serializar(const captura_registro_t *reg, uint8_t *buf, size_t len) {
+    size_t total = CAPTURA_CABECALHO + reg->length;
+    if (len < total) return 0;
+
+    uint8_t *p = buf;
+    *p++ = reg->length;
+    *p++ = reg->flags;
+    for (int i = 0; i < 8; ++i) *p++ = (uint8_t)(reg->t_us >> (8 * i));
+    *p++ = (uint8_t)reg->rssi;
+    *p++ = (uint8_t)((uint16_t)reg->rssi >> 8);
+    *p++ = (uint8_t)reg->snr;
+    *p++ = reg->modem_config1;
+    *p++ = reg->modem_config2;
+    for (int i = 0; i < 4; ++i) *p++ = (uint8_t)(reg->freq_hz >> (8 * i));
+    memcpy(p, reg->payload, reg->length);
+
+    return total;
+}
+
+size_t captura_desserializar(const uint8_t *buf, size_t len, captura_registro_t *reg) {
+    if (len < CAPTURA_CABECALHO) return 0;
+    size_t total = CAPTURA_CABECALHO + buf[0];
+    if (len < total) return 0;
+
+    const uint8_t *p = buf;
+    reg->length = *p++;
+    reg->flags = *p++;
+    reg->t_us = 0;
+    for (int i = 0; i < 8; ++i) reg->t_us |= (uint64_t)*p++ << (8 * i);
+    reg->rssi = (int16_t)(p[0] | (p[1] << 8));
+    p += 2;
+    reg->snr = (int8_t)*p++;
+    reg->modem_config1 = *p++;
+    reg->modem_config2 = *p++;
+    reg->freq_hz = 0;
+    for (int i = 0; i < 4; ++i) reg->freq_hz |= (uint32_t)*p++ << (8 * i);
+    memcpy(reg->payload, p, reg->length);
+
+    return total;
+}
+
+void captura_emitir(const captura_registro_t *reg) {
+    static const char hex[] = "0123456789abcdef";
+    uint8_t bin[CAPTURA_MAX_REGISTRO];
+    char linha[2 * CAPTURA_MAX_REGISTRO + 1];
+
+    size_t n = captura_serializar(reg, bin, sizeof(bin));
+    for (size_t i = 0; i < n; ++i) {
+        linha[2 * i] = hex[bin[i] >> 4];
+        linha[2 * i + 1] = hex[bin[i] & 0x0F];
+    }
+    linha[2 * n] = '\0';
+    printf(CAPTURA_PREFIXO "%s\n", linha);
+}
@@ -0,0 +1,305 @@
+#include "../inc/gateway.h"
+#include "../inc/lote.h"
+#include "../inc/tempo_no_ar.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static gateway_estado_t estado;
+static rfm95_profile_t perfil;
+
+// Último seq recebido de cada nó que pede confirmação
+typedef struct {
+    bool usado;
+    uint8_t endereco;
+    uint32_t ultimo;
+} gateway_no_t;
+
+static gateway_no_t nos[GATEWAY_NOS];
+static uint8_t proximo_no;
+
+static bool ack_pendente;
+static uint8_t ack_destino;
+static uint32_t ack_seq;
+
+// Comandos de configuração aguardando a resposta do nó
+typedef struct {
+    bool usado;
+    uint8_t destino;
+    uint16_t id;
+    char campos[GATEWAY_COMANDO_MAX];
+} gateway_comando_t;
+
+static gateway_comando_t comandos[GATEWAY_COMANDOS];
+static uint16_t ultimo_comando;
+
+// Campos do último comando aceito, até gateway_comando_aceito
+static bool aceito_pendente;
+static char aceito[GATEWAY_COMANDO_MAX];
+
+void gateway_init(void) {
+    memset(&estado, 0, sizeof(estado));
+    strcpy(estado.last_message, "Aguardando...");
+    memset(nos, 0, sizeof(nos));
+    proximo_no = 0;
+    ack_pendente = false;
+    memset(comandos, 0, sizeof(comandos));
+    ultimo_comando = 0;
+    aceito_pendente = false;
+}
+
+void gateway_set_perfil(const rfm95_profile_t *profile) {
+    perfil = *profile;
+}
+
+uint32_t gateway_tempo_no_ar_us(uint8_t length) {
+    return tempo_no_ar_us(&perfil, length);
+}
+
+static void registrar(gateway_histograma_t *h, uint32_t us) {
+    uint32_t faixa = 0;
+    while (faixa < GATEWAY_LAT_FAIXAS - 1 && (us >> (faixa + 1)) != 0) faixa++;
+    h->faixas[faixa]++;
+    h->amostras++;
+    if (us > h->max_us) h->max_us = us;
+}
+
+// Sufixo opcional " @<instante>+<espera>" acrescentado pelo nó, em us de
+// 64 bits; esperas além de 32 bits (71 min no diário) saturam
+static bool ler_timestamp(const char *msg, uint32_t *espera_us) {
+    const char *p = strrchr(msg, '@');
+    if (!p) return false;
+    char *fim;
+    strtoull(p + 1, &fim, 10);
+    if (*fim != '+') return false;
+    unsigned long long espera = strtoull(fim + 1, &fim, 10);
+    *espera_us = espera > UINT32_MAX ? UINT32_MAX : (uint32_t)espera;
+    return *fim == '\0';
+}
+
+static gateway_no_t *no_de(uint8_t endereco) {
+    for (uint8_t i = 0; i < GATEWAY_NOS; ++i) {
+        if (nos[i].usado && nos[i].endereco == endereco) return &nos[i];
+    }
+    gateway_no_t *no = &nos[proximo_no];
+    proximo_no = (proximo_no + 1) % GATEWAY_NOS;
+    no->usado = false;
+    no->endereco = endereco;
+    return no;
+}
+
+static bool repetida(const gateway_no_t *no, uint32_t seq) {
+    return no && no->usado && seq <= no->ultimo && no->ultimo - seq < GATEWAY_JANELA_DUP;
+}
+
+// "#<seq>" da telemetria de uma amostra
+static bool ler_seq(const char *msg, uint32_t *seq) {
+    const char *p = strrchr(msg, '#');
+    if (!p || p[1] < '0' || p[1] > '9') return false;
+    *seq = (uint32_t)strtoul(p + 1, NULL, 10);
+    return true;
+}
+
+static gateway_comando_t *comando_de(uint8_t destino) {
+    for (uint8_t i = 0; i < GATEWAY_COMANDOS; ++i) {
+        if (comandos[i].usado && comandos[i].destino == destino) return &comandos[i];
+    }
+    return NULL;
+}
+
+// "P<n>:CFG=<id> g=<geração>" ou "... erro=<chave>" de um nó: o comando
+// sai da fila, aceito ou recusado
+static bool ler_resposta_config(const rfm95_packet_t *packet) {
+    const char *p = strstr(packet->message, ":CFG=");
+    if (!p || !packet->addressed) return false;
+    char *fim;
+    unsigned long id = strtoul(p + 5, &fim, 10);
+    if (fim == p + 5) return false;
+
+    gateway_comando_t *c = comando_de(packet->header.src);
+    if (c && c->id == id) {
+        c->usado = false;
+        if (strstr(fim, " g=")) {
+            strcpy(aceito, c->campos);
+            aceito_pendente = true;
+        }
+    }
+    printf("Config no %u: %s\n", packet->header.src, p + 1);
+    estado.configuracoes++;
+    return true;
+}
+
+// Uma linha por amostra nova do lote, no formato da telemetria ao vivo
+static void imprimir_lote(lote_leitor_t *lote, const rfm95_packet_t *packet, gateway_no_t *no) {
+    uint32_t seq, idade_s;
+    char campos[RFM95_MENSAGEM_MAX];
+    while (lote_proxima(lote, &seq, &idade_s, campos, sizeof(campos))) {
+        if (repetida(no, seq)) {
+            estado.duplicadas++;
+            continue;
+        }
+        printf("Mensagem recebida: %s:%s #%lu ~%lu\n", lote->no, campos,
+               (unsigned long)seq, (unsigned long)idade_s);
+        printf("RSSI: %d dBm, SNR: %d dB\n", packet->rssi, packet->snr);
+        estado.amostras_lote++;
+    }
+}
+
+bool gateway_processar(const rfm95_packet_t *packet, uint64_t agora_us) {
+    if (!packet || !packet->valid) return false;
+
+    // Nós que pedem confirmação numeram as amostras pelo diário
+    bool pede_ack = packet->addressed && (packet->header.flags & RFM95_FLAG_PEDE_ACK);
+    gateway_no_t *no = pede_ack ? no_de(packet->header.src) : NULL;
+
+    lote_leitor_t lote;
+    uint32_t primeiro = 0, ultimo = 0;
+    bool tem_seq = false, nova = true;
+    if (ler_resposta_config(packet)) {
+        nova = false;
+    } else if (lote_abrir(&lote, packet->message)) {
+        primeiro = lote.seq;
+        imprimir_lote(&lote, packet, no);
+        ultimo = lote.seq - 1;
+        tem_seq = lote.seq != primeiro;
+        nova = false;
+    } else {
+        tem_seq = ler_seq(packet->message, &primeiro);
+        ultimo = primeiro;
+        nova = !(tem_seq && repetida(no, primeiro));
+        if (nova) {
+            printf("Mensagem recebida: %s\n", packet->message);
+            printf("RSSI: %d dBm, SNR: %d dB\n", packet->rssi, packet->snr);
+        } else {
+            estado.duplicadas++;
+        }
+    }
+
+    strncpy(estado.last_message, packet->message, sizeof(estado.last_message) - 1);
+    estado.last_message[sizeof(estado.last_message) - 1] = '\0';
+    estado.last_rssi = packet->rssi;
+    estado.last_snr = packet->snr;
+    estado.rx_count++;
+
+    ack_pendente = false;
+    if (no && tem_seq) {
+        no->usado = true;
+        no->ultimo = ultimo;
+        ack_pendente = true;
+        ack_destino = packet->header.src;
+        ack_seq = ultimo;
+    }
+
+    gateway_latencia_t *lat = &estado.latencia;
+    uint32_t fila_gw = agora_us > packet->timestamp_us ? (uint32_t)(agora_us - packet->timestamp_us) : 0;
+    registrar(&lat->fila_gateway, fila_gw);
+
+    // Reenvios repetiriam a amostra nos histogramas do nó
+    uint32_t fila_no;
+    if (nova && ler_timestamp(packet->message, &fila_no)) {
+        uint32_t no_ar = gateway_tempo_no_ar_us(packet->length + (packet->addressed ? RFM95_HEADER_LEN : 0));
+        registrar(&lat->fila_no, fila_no);
+        registrar(&lat->tempo_no_ar, no_ar);
+        registrar(&lat->fim_a_fim, fila_no + no_ar + fila_gw);
+    }
+
+    return true;
+}
+
+bool gateway_confirmacao(uint8_t *destino, char *out, size_t len) {
+    if (!ack_pendente) return false;
+    ack_pendente = false;
+    *destino = ack_destino;
+    int n = snprintf(out, len, "A:%lu", (unsigned long)ack_seq);
+
+    // O comando vai inteiro ou não vai
+    gateway_comando_t *c = comando_de(ack_destino);
+    if (c && n >= 0 && (size_t)n < len) {
+        int m = snprintf(out + n, len - n, ";C:%u:%s", c->id, c->campos);
+        if (m < 0 || (size_t)m >= len - n) out[n] = '\0';
+    }
+    return true;
+}
+
+uint16_t gateway_comando(uint8_t destino, const char *campos) {
+    if (strlen(campos) >= GATEWAY_COMANDO_MAX) return 0;
+    gateway_comando_t *c = comando_de(destino);
+    for (uint8_t i = 0; !c && i < GATEWAY_COMANDOS; ++i) {
+        if (!comandos[i].usado) c = &comandos[i];
+    }
+    if (!c) return 0;
+
+    if (++ultimo_comando == 0) ultimo_comando = 1;
+    c->usado = true;
+    c->destino = destino;
+    c->id = ultimo_comando;
+    strcpy(c->campos, campos);
+    return c->id;
+}
+
+bool gateway_comando_aceito(char *campos, size_t len) {
+    if (!aceito_pendente) return false;
+    aceito_pendente = false;
+    snprintf(campos, len, "%s", aceito);
+    return true;
+}
+
+const gateway_estado_t *gateway_estado(void) {
+    return &estado;
+}
+
+// Limite superior da faixa que contém o percentil p (em %)
+static uint32_t percentil(const gateway_histograma_t *h, uint32_t p) {
+    uint32_t alvo = (h->amostras * p + 99) / 100;
+    uint32_t acumulado = 0;
+    for (uint32_t i = 0; i < GATEWAY_LAT_FAIXAS - 1; ++i) {
+        acumulado += h->faixas[i];
+        if (acumulado >= alvo) {
+            uint32_t limite = (2u << i) - 1;
+            return limite < h->max_us ? limite : h->max_us;
+        }
+    }
+    return h->max_us;
+}
+
+static void imprimir(const char *nome, const gateway_histograma_t *h) {
+    if (h->amostras == 0) {
+        printf("LAT %s: sem amostras\n", nome);
+        return;
+    }
+    printf("LAT %s: n=%lu p50<=%lu p90<=%lu p99<=%lu max=%lu us\n", nome,
+           (unsigned long)h->amostras,
+           (unsigned long)percentil(h, 50),
+           (unsigned long)percentil(h, 90),
+           (unsigned long)percentil(h, 99),
+           (unsigned long)h->max_us);
+}
+
+void gateway_imprimir_latencias(void) {
+    imprimir("fila_no", &estado.latencia.fila_no);
+    imprimir("no_ar", &estado.latencia.tempo_no_ar);
+    imprimir("fila_gw", &estado.latencia.fila_gateway);
+    imprimir("fim_a_fim", &estado.latencia.fim_a_fim);
+}
+
+static void imprimir_faixas(const char *nome, const uint32_t *faixas, int n, int inicio, int passo) {
+    printf("MET %s", nome);
+    for (int i = 0; i < n; ++i) {
+        if (faixas[i]) printf(" %d:%lu", inicio + passo * i, (unsigned long)faixas[i]);
+    }
+    printf("\n");
+}
+
+void gateway_imprimir_metricas(const rfm95_stats_t *stats) {
+    printf("MET rx_ok=%lu crc=%lu header=%lu oversize=%lu foreign=%lu rx_timeout=%lu tx_ok=%lu tx_timeout=%lu\n",
+           (unsigned long)stats->rx_ok,
+           (unsigned long)stats->crc_errors,
+           (unsigned long)stats->header_errors,
+           (unsigned long)stats->oversize_drops,
+           (unsigned long)stats->foreign_drops,
+           (unsigned long)stats->rx_timeouts,
+           (unsigned long)stats->tx_ok,
+           (unsigned long)stats->tx_timeouts);
+    imprimir_faixas("rssi_dbm", stats->rssi_hist, RFM95_RSSI_BUCKETS, -140, 10);
+    imprimir_faixas("snr_db", stats->snr_hist, RFM95_SNR_BUCKETS, -20, 5);
+}
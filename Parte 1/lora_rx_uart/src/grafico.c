@@ -0,0 +1,126 @@
+#include "../inc/grafico.h"
+#include <string.h>
+
+void serie_init(serie_t *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+void serie_adicionar(serie_t *s, int16_t valor) {
+    s->valores[s->cabeca] = valor;
+    s->cabeca = (s->cabeca + 1) % SERIE_MAX;
+    if (s->total < SERIE_MAX) s->total++;
+    s->adicionadas++;
+}
+
+int16_t serie_obter(const serie_t *s, uint8_t i) {
+    uint16_t pos = s->cabeca + SERIE_MAX - s->total + i;
+    return s->valores[pos % SERIE_MAX];
+}
+
+bool serie_faixa(const serie_t *s, uint8_t n, int16_t *min, int16_t *max) {
+    if (s->total == 0) return false;
+    if (n > s->total) n = s->total;
+
+    *min = *max = serie_obter(s, s->total - n);
+    for (uint8_t i = s->total - n + 1; i < s->total; ++i) {
+        int16_t v = serie_obter(s, i);
+        if (v < *min) *min = v;
+        if (v > *max) *max = v;
+    }
+    return true;
+}
+
+bool sparkline_init(sparkline_t *g, const serie_t *serie, uint8_t x, uint8_t largura,
+                    uint8_t pagina, uint8_t paginas, int16_t escala_min, int16_t escala_max) {
+    memset(g, 0, sizeof(*g));
+    g->serie = serie;
+    if (largura == 0 || paginas == 0 ||
+        (uint16_t)x + largura > SSD1306_WIDTH || (uint16_t)pagina + paginas > SSD1306_PAGES)
+        return false;
+    g->x = x;
+    g->largura = largura;
+    g->pagina = pagina;
+    g->paginas = paginas;
+    g->escala_min = escala_min;
+    g->escala_max = escala_max;
+    g->sujo = true;
+    return true;
+}
+
+// Linha (a partir do topo da região) de um valor na escala atual
+static uint8_t sparkline_linha(const sparkline_t *g, int16_t v) {
+    int32_t altura = g->paginas * 8;
+    if (v <= g->min_desenho) return altura - 1;
+    if (v >= g->max_desenho) return 0;
+    int32_t nivel = (int32_t)(v - g->min_desenho) * (altura - 1) / (g->max_desenho - g->min_desenho);
+    return altura - 1 - nivel;
+}
+
+// Coluna i da região: segmento vertical entre a amostra anterior e a
+// atual, escrito página a página (sem passar por ssd1306_pixel)
+static void sparkline_coluna(ssd1306_t *ssd, const sparkline_t *g, uint8_t i) {
+    const serie_t *s = g->serie;
+    uint8_t *col = &ssd->ram_buffer[ssd1306_index(g->x + i, g->pagina)];
+    int16_t k = (int16_t)s->total - g->largura + i;
+
+    if (k < 0) {
+        memset(col, 0, g->paginas);
+        return;
+    }
+
+    uint8_t y1 = sparkline_linha(g, serie_obter(s, k));
+    uint8_t y0 = k > 0 ? sparkline_linha(g, serie_obter(s, k - 1)) : y1;
+    if (y0 > y1) {
+        uint8_t t = y0;
+        y0 = y1;
+        y1 = t;
+    }
+
+    for (uint8_t p = 0; p < g->paginas; ++p) {
+        uint8_t topo = p * 8, base = topo + 7;
+        if (y1 < topo || y0 > base) {
+            col[p] = 0;
+            continue;
+        }
+        uint8_t mask = 0xFF;
+        if (y0 > topo) mask &= 0xFF << (y0 - topo);
+        if (y1 < base) mask &= 0xFF >> (base - y1);
+        col[p] = mask;
+    }
+}
+
+bool sparkline_desenhar(ssd1306_t *ssd, sparkline_t *g) {
+    const serie_t *s = g->serie;
+    if (g->largura == 0) return false;
+    uint32_t novas = s->adicionadas - g->desenhadas;
+    if (!g->sujo && novas == 0) return false;
+
+    int16_t min = g->escala_min, max = g->escala_max;
+    if (min == max && !serie_faixa(s, g->largura, &min, &max)) min = max = 0;
+    if (max == min) max = min + 1;
+
+    uint8_t primeira = 0;
+    if (!g->sujo && novas < g->largura && min == g->min_desenho && max == g->max_desenho) {
+        // Mesma escala: desloca as colunas antigas e desenha só as novas
+        primeira = g->largura - novas;
+        if (g->paginas == SSD1306_PAGES) {
+            // Colunas inteiras são contíguas no ram_buffer
+            memmove(&ssd->ram_buffer[ssd1306_index(g->x, 0)],
+                    &ssd->ram_buffer[ssd1306_index(g->x + novas, 0)],
+                    (size_t)primeira * SSD1306_PAGES);
+        } else {
+            for (uint8_t i = 0; i < primeira; ++i)
+                memcpy(&ssd->ram_buffer[ssd1306_index(g->x + i, g->pagina)],
+                       &ssd->ram_buffer[ssd1306_index(g->x + i + novas, g->pagina)], g->paginas);
+        }
+    }
+
+    g->min_desenho = min;
+    g->max_desenho = max;
+    for (uint8_t i = primeira; i < g->largura; ++i) sparkline_coluna(ssd, g, i);
+
+    ssd1306_mark_dirty(ssd, g->x, g->x + g->largura - 1, g->pagina, g->pagina + g->paginas - 1);
+    g->desenhadas = s->adicionadas;
+    g->sujo = false;
+    return true;
+}
@@ -0,0 +1,59 @@
+#include "../inc/lote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void lote_iniciar(lote_t *l, char *buf, size_t cap, const char *no, uint32_t seq0) {
+    l->buf = buf;
+    l->cap = cap;
+    l->seq0 = seq0;
+    l->n = 0;
+    int n = snprintf(buf, cap, "%s:L#%lu", no, (unsigned long)seq0);
+    l->len = n < 0 ? 0 : (size_t)n < cap ? (size_t)n : cap - 1;
+}
+
+bool lote_adicionar(lote_t *l, uint32_t idade_s, const char *campos) {
+    if (l->n >= LOTE_MAX) return false;
+    size_t livre = l->cap - l->len;
+    int n = snprintf(l->buf + l->len, livre, "|%lu %s", (unsigned long)idade_s, campos);
+    if (n < 0 || (size_t)n >= livre) {
+        l->buf[l->len] = '\0';
+        return false;
+    }
+    l->len += n;
+    l->n++;
+    return true;
+}
+
+bool lote_abrir(lote_leitor_t *r, const char *msg) {
+    const char *dois_pontos = strchr(msg, ':');
+    if (!dois_pontos || (size_t)(dois_pontos - msg) >= sizeof(r->no)) return false;
+    if (dois_pontos[1] != 'L' || dois_pontos[2] != '#') return false;
+
+    char *fim;
+    unsigned long seq = strtoul(dois_pontos + 3, &fim, 10);
+    if (fim == dois_pontos + 3 || (*fim != '|' && *fim != '\0')) return false;
+
+    memcpy(r->no, msg, dois_pontos - msg);
+    r->no[dois_pontos - msg] = '\0';
+    r->seq = (uint32_t)seq;
+    r->p = fim;
+    return true;
+}
+
+bool lote_proxima(lote_leitor_t *r, uint32_t *seq, uint32_t *idade_s, char *campos, size_t len) {
+    if (*r->p != '|') return false;
+
+    char *fim;
+    *idade_s = (uint32_t)strtoul(r->p + 1, &fim, 10);
+    if (*fim == ' ') ++fim;
+    size_t n = strcspn(fim, "|");
+    if (len > 0) {
+        size_t copia = n < len - 1 ? n : len - 1;
+        memcpy(campos, fim, copia);
+        campos[copia] = '\0';
+    }
+    *seq = r->seq++;
+    r->p = fim + n;
+    return true;
+}
@@ -0,0 +1,91 @@
+#include "../inc/tela.h"
+#include "../inc/widgets.h"
+#include "../inc/grafico.h"
+#include "../inc/display_agendador.h"
+
+// O agendador copia o estado para buffers de DISPLAY_ESTADO_MAX bytes e
+// truncaria o que passar disso
+_Static_assert(sizeof(tela_estado_t) <= DISPLAY_ESTADO_MAX, "estado da tela nao cabe no agendador");
+
+enum {
+    W_TITULO,
+    W_STATUS,
+    W_RX,
+    W_CAPTURA,
+    W_MSG_ROTULO,
+    W_MSG,
+    W_RSSI,
+    W_SNR,
+    W_TOTAL
+};
+
+// No painel de 32 linhas ficam o status, o contador com a captura e o
+// gráfico do RSSI na última página; a mensagem, os valores e o SNR saem
+#if SSD1306_HEIGHT == 64
+#define TELA_WIDGETS W_TOTAL
+#else
+#define TELA_WIDGETS W_MSG_ROTULO
+#endif
+
+static widget_t widgets[W_TOTAL];
+
+// Histórico de RSSI e SNR dos pacotes aceitos na última página
+static serie_t serie_rssi, serie_snr;
+static sparkline_t graf_rssi;
+#if SSD1306_HEIGHT == 64
+static sparkline_t graf_snr;
+#endif
+static uint32_t ultimo_rx;
+
+void tela_init(ssd1306_t *ssd) {
+    widget_rotulo(&widgets[W_TITULO], 0, 0, 16, "LoRa Transceiver");
+    widget_status(&widgets[W_STATUS], 0, 12, 16, 1, "Status: ");
+    serie_init(&serie_rssi);
+    serie_init(&serie_snr);
+#if SSD1306_HEIGHT == 64
+    widget_contador(&widgets[W_RX], 0, 20, 12, "RX:");
+    widget_status(&widgets[W_CAPTURA], 104, 20, 3, 1, NULL);
+    widget_rotulo(&widgets[W_MSG_ROTULO], 0, 28, 16, "Ultima msg:");
+    widget_status(&widgets[W_MSG], 0, 36, 16, 1, NULL);
+    widget_valor(&widgets[W_RSSI], 0, 44, 9, "R:", 0, "dBm");
+    widget_valor(&widgets[W_SNR], 72, 44, 7, "S:", 0, "dB");
+    sparkline_init(&graf_rssi, &serie_rssi, 0, 62, SSD1306_PAGES - 1, 1, 0, 0);
+    sparkline_init(&graf_snr, &serie_snr, 66, 62, SSD1306_PAGES - 1, 1, 0, 0);
+#else
+    widget_contador(&widgets[W_RX], 0, 24, 8, "RX:");
+    widget_status(&widgets[W_CAPTURA], 64, 24, 3, 1, NULL);
+    sparkline_init(&graf_rssi, &serie_rssi, 90, 38, SSD1306_PAGES - 1, 1, 0, 0);
+#endif
+
+    // RSSI/SNR só aparecem depois do primeiro pacote
+    widget_set_visivel(&widgets[W_RSSI], false);
+    widget_set_visivel(&widgets[W_SNR], false);
+    ultimo_rx = 0;
+
+    ssd1306_fill(ssd, false);
+    ssd1306_hline(ssd, 0, 127, 9, true);
+}
+
+bool tela_atualizar(ssd1306_t *ssd, const tela_estado_t *estado) {
+    widget_set_texto(&widgets[W_STATUS], estado->status);
+    widget_set_valor(&widgets[W_RX], (int32_t)estado->rx_count);
+    widget_set_texto(&widgets[W_CAPTURA], estado->captura ? "CAP" : "");
+    widget_set_texto(&widgets[W_MSG], estado->last_message);
+    widget_set_visivel(&widgets[W_RSSI], estado->last_rssi != 0);
+    widget_set_visivel(&widgets[W_SNR], estado->last_rssi != 0);
+    widget_set_valor(&widgets[W_RSSI], estado->last_rssi);
+    widget_set_valor(&widgets[W_SNR], estado->last_snr);
+    bool mudou = widgets_desenhar(ssd, widgets, TELA_WIDGETS) > 0;
+
+    // Pacotes agrupados num mesmo quadro contribuem só com o último
+    if (estado->rx_count != ultimo_rx) {
+        ultimo_rx = estado->rx_count;
+        serie_adicionar(&serie_rssi, estado->last_rssi);
+        serie_adicionar(&serie_snr, estado->last_snr);
+    }
+    mudou |= sparkline_desenhar(ssd, &graf_rssi);
+#if SSD1306_HEIGHT == 64
+    mudou |= sparkline_desenhar(ssd, &graf_snr);
+#endif
+    return mudou;
+}
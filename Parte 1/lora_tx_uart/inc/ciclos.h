@@ -0,0 +1,23 @@
+#ifndef CICLOS_H
+#define CICLOS_H
+
+#include <stdint.h>
+#include "hardware/structs/systick.h"
+
+// Contagem de ciclos pelo SysTick, usada pelos benchmarks. O SysTick conta
+// para baixo a partir de 2^24 - 1 no clock do sistema.
+static inline void ciclos_iniciar(void) {
+  systick_hw->rvr = 0x00FFFFFF;
+  systick_hw->cvr = 0;
+  systick_hw->csr = 0x5;
+}
+
+static inline uint32_t ciclos_ler(void) {
+  return systick_hw->cvr;
+}
+
+static inline uint32_t ciclos_desde(uint32_t inicio) {
+  return (inicio - ciclos_ler()) & 0x00FFFFFF;
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Região da configuração: dois setores de 4 KB (slots A e B) logo antes do
+// histórico no nó e no fim da flash no gateway. Cada slot guarda um
+// registro no início da primeira página
+#define CONFIG_SLOTS            2
+#define CONFIG_SLOT_BYTES       4096
+#define CONFIG_PAGINA_BYTES     256
+
+#define CONFIG_MAGICA           0x31474643  // "CFG1"
+#define CONFIG_VERSAO           1
+
+// Registro da configuração do nó; o gateway usa só o rádio e o endereço.
+// Campos novos entram sempre no fim, antes do CRC, e 'tamanho' diz quantos
+// bytes o gravador conhecia: um registro de outra versão contribui com os
+// campos que as duas têm em comum e os demais ficam no padrão do firmware
+typedef struct {
+    uint32_t magica;
+    uint16_t versao;
+    uint16_t tamanho;           // Bytes do registro, CRC incluído
+    uint32_t geracao;           // Cresce a cada gravação; vale o slot com a maior
+
+    // Rádio
+    uint32_t freq_khz;
+    int8_t potencia_dbm;        // 5..23 (PA_BOOST)
+    uint8_t sf;                 // 7..12
+    uint8_t largura_banda;      // Índice de BANDWIDTH_* (0: 7,8 kHz .. 9: 500 kHz)
+    uint8_t codigo;             // Taxa de código 4/(4 + codigo), 1..4
+
+    // Endereçamento
+    uint8_t rede_id;
+    uint8_t endereco;
+    uint8_t endereco_gateway;
+
+    // Amostragem e relatório por exceção
+    uint8_t decimacao;
+    uint32_t periodo_ms;
+    int16_t banda_temp_x10;
+    int16_t banda_umid_x10;
+    uint32_t silencio_max_ms;
+    uint32_t intervalo_min_ms;
+
+    uint32_t comando;           // Id e CRC-16 dos campos do último comando aplicado
+    uint8_t provisoria;         // 1: enlace trocado pelo rádio, ainda sem ACK no perfil novo
+    uint8_t reservado;
+    uint16_t crc;               // CRC-16/CCITT dos bytes anteriores
+} config_t;
+
+// Carrega a configuração dos dois slots pela XIP, sem apagar nem programar
+// nada: vale o registro íntegro de maior geração, sobre 'padrao'. Retorna
+// o slot carregado ou -1 se nenhum é válido (cfg fica igual a 'padrao')
+int config_carregar(config_t *cfg, const config_t *padrao);
+
+// Configuração do outro slot, de geração anterior à de 'atual', sobre
+// 'padrao' como em config_carregar; false se ele não é válido. É a volta
+// de uma troca do enlace que não deu certo
+bool config_anterior(const config_t *atual, const config_t *padrao, config_t *anterior);
+
+// Grava cfg com a geração seguinte no slot que não está em vigor (apagar e
+// programar uma página). Uma gravação interrompida deixa esse slot
+// inválido e a configuração anterior continua valendo. false se a flash
+// não confirmou a gravação (cfg fica com a geração anterior)
+bool config_gravar(config_t *cfg);
+
+// Aplica "chave=valor,..." sobre cfg, tudo ou nada. Chaves: f (kHz),
+// p (dBm), sf, bw (Hz), cr (5..8, de 4/5 a 4/8), rede, end, gw, per (ms),
+// dec, bt e bu (bandas em décimos), sil e int (ms). Em erro, 'erro'
+// recebe a chave recusada e cfg fica como estava
+bool config_aplicar_texto(config_t *cfg, const char *texto, char *erro, size_t len);
+
+// true se a troca de a para b pode deixar o nó sem enlace: frequência,
+// modem, rede ou gateway, que o gateway precisa acompanhar, ou a potência,
+// que muda o alcance
+bool config_enlace_mudou(const config_t *a, const config_t *b);
+
+// Perfil do gateway depois de um comando que o nó aceitou ('campos' como
+// em config_aplicar_texto): frequência, modem e rede acompanham o nó e o
+// 'gw' dele vira o endereço do gateway; a potência e o resto ficam. false
+// (gateway intacto) se nada disso muda ou os campos não valem
+bool config_seguir(config_t *gateway, const char *campos);
+
+// Registradores RegModemConfig1..3 do perfil de cfg: cabeçalho explícito,
+// CRC ligado, AGC ligado e LowDataRateOptimize com símbolos de mais de
+// 16 ms
+void config_modem(const config_t *cfg, uint8_t *modem_config1, uint8_t *modem_config2, uint8_t *modem_config3);
+
+// Comando de configuração anexado pelo gateway à confirmação:
+// "A:<seq>;C:<id>:<campos>". Retorna false se a mensagem não traz comando;
+// 'campos' aponta para dentro de 'msg' e 'chave' identifica o comando
+// (id e CRC dos campos) para reconhecer as repetições
+bool config_ler_comando(const char *msg, uint16_t *id, const char **campos, uint32_t *chave);
+
+#endif
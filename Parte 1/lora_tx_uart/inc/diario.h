@@ -0,0 +1,96 @@
+#ifndef DIARIO_H
+#define DIARIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Região do diário: os últimos DIARIO_SETORES setores de 4 KB da flash
+#define DIARIO_SETORES          64
+#define DIARIO_SETOR_BYTES      4096
+#define DIARIO_PAGINA_BYTES     256
+#define DIARIO_REGISTRO_BYTES   32
+#define DIARIO_DADOS_MAX        24
+
+#define DIARIO_POR_PAGINA       (DIARIO_PAGINA_BYTES / DIARIO_REGISTRO_BYTES)
+#define DIARIO_POR_SETOR        (DIARIO_SETOR_BYTES / DIARIO_REGISTRO_BYTES)
+#define DIARIO_SLOTS            (DIARIO_SETORES * DIARIO_POR_SETOR)
+
+// Um setor fica sempre apagado à frente da cabeça
+#define DIARIO_CAPACIDADE       ((DIARIO_SETORES - 1) * DIARIO_POR_SETOR)
+
+// Página parcial vai para a flash depois deste tempo no buffer
+#define DIARIO_ATRASO_MS        5000
+
+// Na inicialização o seq pula pelo menos o que podia estar só nos buffers
+// de RAM (esses registros podem ter sido transmitidos) e a cabeça recomeça
+// em um setor novo, com um marco do salto já gravado na flash
+#define DIARIO_SALTO_BOOT       (2 * DIARIO_POR_PAGINA)
+
+// Registro na flash. 'pendente' fica fora do CRC: a confirmação só zera
+// esse byte, programando a página de novo sem apagar o setor
+typedef struct {
+    uint32_t seq;
+    uint8_t len;
+    uint8_t crc;            // CRC-8 de seq, len e dados
+    uint8_t pendente;       // 0xFF: sem confirmação; 0x00: confirmado
+    uint8_t reservado;
+    uint8_t dados[DIARIO_DADOS_MAX];
+} diario_registro_t;
+
+typedef struct {
+    uint32_t gravados;
+    uint32_t confirmados;
+    uint32_t perdidos;      // Apagados (ou corrompidos) antes da confirmação
+    uint32_t programacoes;  // Páginas programadas, inclusive as de confirmação
+    uint32_t apagamentos;   // Setores apagados
+    uint32_t esperas;       // Operações de flash feitas dentro de diario_gravar
+    uint32_t falhas;        // Operações recusadas (outro core não liberou a flash a tempo)
+} diario_stats_t;
+
+// Diário circular de registros na flash, só de acréscimo: a cabeça anda
+// slot a slot e cada setor é apagado uma vez por volta, o que distribui o
+// desgaste por toda a região. Os registros ainda não confirmados vão da
+// cauda à cabeça; quando a cabeça alcança a cauda os mais antigos são
+// perdidos. As gravações só vão para um buffer de página em RAM (dois, em
+// alternância); as operações de flash ficam para diario_servico, uma por
+// chamada, fora do caminho das amostras.
+typedef struct {
+    uint32_t base;              // Offset da região na flash
+    uint32_t proximo_seq;
+    uint32_t cabeca;            // Slot do próximo registro
+    uint32_t cauda_seq;         // Mais antigo sem confirmação
+    uint32_t marcar_seq;        // Confirmados em [marcar_seq, cauda_seq) ainda não marcados na flash
+    int32_t setor_pronto;       // Setor à frente já apagado (-1: nenhum)
+
+    uint8_t pagina[2][DIARIO_PAGINA_BYTES];
+    uint32_t pagina_slot[2];    // Primeiro slot da página em cada buffer
+    bool pagina_cheia[2];       // Aguardando programação
+    bool atual_sujo;            // Buffer atual tem registros fora da flash
+    uint8_t atual;
+    uint32_t sujo_desde_ms;
+
+    diario_stats_t stats;
+} diario_t;
+
+// Varre a região e retoma cabeça, seq e cauda do que está gravado
+void diario_init(diario_t *d);
+
+// Acrescenta um registro; retorna o seq atribuído (0 se 'len' não cabe)
+uint32_t diario_gravar(diario_t *d, const void *dados, uint8_t len, uint32_t agora_ms);
+
+// Confirma todos os registros até 'seq' (inclusive)
+void diario_confirmar(diario_t *d, uint32_t seq);
+
+// Lê o registro 'seq' da RAM ou da flash; false se não existe mais, está
+// corrompido ou é o marco sem dados que a inicialização grava
+bool diario_ler(const diario_t *d, uint32_t seq, diario_registro_t *r);
+
+// Uma operação de flash pendente (programar página, marcar confirmações,
+// apagar o setor à frente); retorna false se não havia nada a fazer. Se
+// a flash recusar a operação, ela fica para a próxima chamada
+bool diario_servico(diario_t *d, uint32_t agora_ms);
+
+static inline uint32_t diario_cauda(const diario_t *d) { return d->cauda_seq; }
+static inline uint32_t diario_pendentes(const diario_t *d) { return d->proximo_seq - d->cauda_seq; }
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef EXCECAO_H
+#define EXCECAO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Grandezas acompanhadas por um mesmo relatório
+#define EXCECAO_MAX 4
+
+// Por que uma amostra foi (ou não) enviada
+typedef enum {
+    EXCECAO_SUPRIMIDA,      // Dentro das bandas e do silêncio máximo
+    EXCECAO_LIMITADA,       // Mudou, mas antes do intervalo mínimo
+    EXCECAO_PRIMEIRA,       // Nada enviado ainda
+    EXCECAO_MUDANCA,        // Alguma grandeza saiu da banda (ou a validade mudou)
+    EXCECAO_SILENCIO        // Silêncio máximo atingido
+} excecao_motivo_t;
+
+// Relatório por exceção: uma amostra só é enviada quando alguma grandeza
+// se afasta do último valor enviado pelo menos a sua banda, ou quando
+// passa o silêncio máximo (heartbeat). Envios nunca ficam mais próximos
+// que o intervalo mínimo; uma mudança retida por ele sai na primeira
+// avaliação depois do intervalo, se ainda valer.
+typedef struct {
+    uint8_t n;
+    int32_t banda[EXCECAO_MAX];
+    uint32_t silencio_max_ms;
+    uint32_t intervalo_min_ms;
+
+    // Último envio
+    int32_t enviado[EXCECAO_MAX];
+    bool enviado_valido;
+    bool enviou;
+    uint32_t t_envio_ms;
+
+    // Estatísticas
+    uint32_t avaliadas;
+    uint32_t enviadas;
+    uint32_t por_mudanca;
+    uint32_t por_silencio;
+    uint32_t limitadas;
+} excecao_t;
+
+void excecao_init(excecao_t *e, uint8_t n, const int32_t *bandas,
+                  uint32_t silencio_max_ms, uint32_t intervalo_min_ms);
+
+// Esquece o último envio: a próxima avaliação envia
+void excecao_reiniciar(excecao_t *e);
+
+// Avalia uma amostra (n valores; 'valida' false para leitura com falha,
+// cujos valores são ignorados). Se o motivo for de envio (PRIMEIRA,
+// MUDANCA ou SILENCIO), a amostra passa a ser a referência: o chamador
+// deve enviá-la.
+excecao_motivo_t excecao_avaliar(excecao_t *e, const int32_t *valores, bool valida, uint32_t agora_ms);
+
+static inline bool excecao_enviar(excecao_motivo_t m) {
+    return m >= EXCECAO_PRIMEIRA;
+}
+
+// Registra um envio feito fora da avaliação (pedido manual)
+void excecao_registrar(excecao_t *e, const int32_t *valores, bool valida, uint32_t agora_ms);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef GRAFICO_H
+#define GRAFICO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+// Amostras guardadas por série: uma por coluna na largura máxima e mais
+// uma, ponto de partida do segmento da coluna mais à esquerda
+#define SERIE_MAX (SSD1306_WIDTH + 1)
+
+// Buffer circular das amostras mais recentes de uma grandeza
+typedef struct {
+    int16_t valores[SERIE_MAX];
+    uint8_t cabeca;         // Próxima posição a escrever
+    uint8_t total;          // Amostras válidas (até SERIE_MAX)
+    uint32_t adicionadas;   // Contador monotônico, usado no redesenho incremental
+} serie_t;
+
+void serie_init(serie_t *s);
+void serie_adicionar(serie_t *s, int16_t valor);
+// i = 0 é a amostra mais antiga ainda guardada
+int16_t serie_obter(const serie_t *s, uint8_t i);
+// Mínimo e máximo das últimas n amostras; false se não houver amostras
+bool serie_faixa(const serie_t *s, uint8_t n, int16_t *min, int16_t *max);
+
+// Sparkline desenhado coluna a coluna direto nos bytes de página do
+// framebuffer. A região é alinhada a páginas: colunas x..x+largura-1 das
+// páginas pagina..pagina+paginas-1. A amostra mais nova fica à direita.
+typedef struct {
+    const serie_t *serie;
+    uint8_t x, largura;
+    uint8_t pagina, paginas;
+    int16_t escala_min, escala_max;     // Iguais: escala automática
+    // Estado do que está no framebuffer
+    uint32_t desenhadas;
+    int16_t min_desenho, max_desenho;
+    bool sujo;
+} sparkline_t;
+
+// Região que não cabe no painel é recusada: retorna false e o gráfico
+// fica vazio, sem nunca escrever no framebuffer
+bool sparkline_init(sparkline_t *g, const serie_t *serie, uint8_t x, uint8_t largura,
+                    uint8_t pagina, uint8_t paginas, int16_t escala_min, int16_t escala_max);
+
+// Com a mesma escala, só as colunas das amostras novas são desenhadas e o
+// resto do gráfico é deslocado no framebuffer; retorna true se algo mudou
+bool sparkline_desenhar(ssd1306_t *ssd, sparkline_t *g);
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef HISTORICO_H
+#define HISTORICO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "serie.h"
+
+// Região do histórico: HISTORICO_SETORES setores de 4 KB logo antes do
+// diário. Com uma amostra por minuto do AHT20 um bloco guarda umas quatro
+// horas e a região, perto de um ano
+#define HISTORICO_SETORES           128
+#define HISTORICO_SETOR_BYTES       4096
+#define HISTORICO_POR_SETOR         (HISTORICO_SETOR_BYTES / SERIE_BLOCO_BYTES)
+#define HISTORICO_BLOCOS            (HISTORICO_SETORES * HISTORICO_POR_SETOR)
+
+// Setor sem nenhum bloco válido no índice
+#define HISTORICO_VAZIO             0xFFFFFFFF
+
+typedef struct {
+    uint32_t amostras;
+    uint32_t blocos;        // Blocos fechados
+    uint32_t programacoes;
+    uint32_t apagamentos;
+    uint32_t esperas;       // Operações de flash feitas dentro de historico_gravar
+    uint32_t falhas;        // Operações recusadas (outro core não liberou a flash a tempo)
+} historico_stats_t;
+
+// Histórico de longo prazo das amostras, em blocos comprimidos (serie.h)
+// gravados em volta na flash, um bloco por página. O bloco em montagem
+// fica em RAM e é perdido num reboot; as amostras recentes estão também no
+// diário até a confirmação. O instante é um relógio em segundos que
+// continua de um boot para o outro (o nó não tem hora do dia). O índice
+// esparso guarda o primeiro instante de cada setor: uma consulta por
+// instante olha o índice, os cabeçalhos de um setor e decodifica um bloco
+// só até a amostra pedida.
+typedef struct {
+    uint32_t base;                          // Offset da região na flash
+    uint32_t relogio_s;                     // Instante do histórico no boot
+    uint32_t indice[HISTORICO_SETORES];     // t0 do primeiro bloco válido de cada setor
+    uint32_t cabeca;                        // Bloco em montagem
+    uint32_t t_ultimo;                      // Instante da última amostra
+    int32_t setor_pronto;                   // Setor à frente já apagado (-1: nenhum)
+
+    uint8_t bloco[2][SERIE_BLOCO_BYTES];
+    uint32_t bloco_num[2];                  // Bloco da região em cada buffer
+    bool bloco_cheio[2];                    // Fechado, aguardando programação
+    uint8_t atual;
+    serie_codificador_t cod;
+
+    historico_stats_t stats;
+} historico_t;
+
+// Posição de uma consulta
+typedef struct {
+    uint32_t bloco;
+    uint32_t restantes;     // Blocos até a cabeça, inclusive
+    serie_leitor_t leitor;
+} historico_cursor_t;
+
+// Varre os cabeçalhos, monta o índice e retoma a cabeça e o relógio
+void historico_init(historico_t *h);
+
+// Instante do histórico para um instante em segundos desde o boot (em
+// segundos: os ms de 32 bits dão a volta em 49 dias)
+static inline uint32_t historico_instante(const historico_t *h, uint32_t s) {
+    return h->relogio_s + s;
+}
+
+// Adianta o relógio do boot para pelo menos 's'. Na inicialização: as
+// amostras do bloco que estava em RAM se perderam, mas os instantes delas
+// podem estar guardados em outro lugar (no diário do nó)
+void historico_avancar(historico_t *h, uint32_t s);
+
+// Acrescenta uma amostra de 'n' grandezas (SERIE_INVALIDO nas sem leitura)
+// tomada em 's' segundos desde o boot. Amostras fora de ordem são
+// descartadas
+bool historico_gravar(historico_t *h, uint32_t s, const int16_t *valores, uint8_t n);
+
+// Uma operação de flash pendente (programar bloco fechado, apagar o setor
+// à frente); retorna false se não havia nada a fazer. Se a flash recusar
+// a operação, ela fica para a próxima chamada
+bool historico_servico(historico_t *h);
+
+// Posiciona o cursor na primeira amostra com instante >= t (s); false se
+// não há nenhuma
+bool historico_buscar(const historico_t *h, uint32_t t, historico_cursor_t *c);
+
+// Próxima amostra da consulta; 'valores' recebe até SERIE_GRANDEZAS_MAX
+// valores e 'n' quantos vieram. false no fim do histórico
+bool historico_proxima(const historico_t *h, historico_cursor_t *c, uint32_t *t, int16_t *valores, uint8_t *n);
+
+// Consulta pelo rádio: a partir da primeira amostra com instante >= t,
+// tantas quantas couberem em 'len' no texto
+//
+//   "h=<t0>:<v>,<v> <dt>:<v>,<v> ..."
+//
+// com <dt> o intervalo para a amostra anterior (s), os valores em décimos
+// e "-" nos sem leitura. A próxima página começa em t0 + soma dos dt + 1.
+// Retorna quantas amostras foram escritas (0: nenhuma em t ou depois)
+uint8_t historico_formatar(const historico_t *h, uint32_t t, char *buf, size_t len);
+
+#endif
@@ -2,10 +2,95 @@
 #define SENSORES_H
 
 #include "hardware/i2c.h"
+#include "sensor_driver.h"
 
-// Inicializa os sensores (neste caso, apenas o AHT20)
-void sensores_init(i2c_inst_t *i2c);
-// Lê os sensores e grava a string formatada no buffer fornecido
-void sensores_ler(char *out_str, size_t len);
+// Intervalo padrão entre rodadas de medição (o datasheet do AHT20 pede no
+// máximo uma medição a cada 2 s para evitar autoaquecimento)
+#define SENSORES_PERIODO_MS 2000
+#define SENSORES_PERIODO_MIN_MS 100
+
+// Rodadas filtradas por amostra entregue ao rádio: com o período padrão,
+// uma amostra a cada 10 s (o relatório por exceção decide se ela sai)
+#define SENSORES_DECIMACAO 5
+
+// Constante do IIR (1/2^n da diferença por leitura)
+#define SENSORES_IIR_SHIFT 2
+
+// Amostras decimadas guardadas até o rádio consumir
+#define SENSORES_FILA 16
+
+// Falhas seguidas de um sensor (sem resposta ou CRC errado) antes de
+// recuperar o barramento e resetá-lo
+#define SENSORES_TENTATIVAS 3
+
+// Intervalo entre tentativas quando o sensor não responde nem ao reset
+#define SENSORES_AUSENTE_MS 20000
+
+// Sensores registrados e total de grandezas de todos eles
+#define SENSORES_MAX 4
+#define SENSORES_GRANDEZAS_MAX 8
+
+// Qualidade da última leitura de um sensor
+typedef enum {
+    SENSOR_OK,              // Leitura conferida
+    SENSOR_CRC,             // CRC errado em todas as tentativas
+    SENSOR_SEM_RESPOSTA,    // NACK ou timeout no I2C em todas as tentativas
+    SENSOR_AUSENTE          // Não inicializou nem após o reset
+} sensor_qualidade_t;
+
+// Valores filtrados de todas as grandezas, na ordem de registro dos
+// sensores, com o instante (time_us_32) e a qualidade de cada sensor
+typedef struct {
+    uint32_t t_us;
+    uint8_t n;
+    int16_t valores[SENSORES_GRANDEZAS_MAX];
+    sensor_qualidade_t qualidade[SENSORES_MAX];
+} sensores_amostra_t;
+
+// Prepara o barramento dos sensores. SDA e SCL são usados para liberar o
+// barramento quando um sensor trava.
+void sensores_init(i2c_inst_t *i2c, uint sda, uint scl);
+
+// Registra e inicializa um sensor. Retorna o índice da sua primeira
+// grandeza nas amostras (-1 se não couber)
+int sensores_registrar(const sensor_driver_t *driver);
+
+// Troca o período das rodadas e a decimação (0 = sem decimar) em execução
+void sensores_configurar(uint32_t periodo_ms, uint8_t decimacao);
+
+// Avança as medições sem bloquear. A cada período abre uma rodada: todos
+// os sensores são disparados em sequência (conversão mais longa primeiro)
+// e cada um é coletado quando a sua conversão termina, de modo que a
+// rodada dura perto do sensor mais lento, não da soma. Chamar a cada
+// volta do laço principal. Retorna true quando uma rodada terminou.
+bool sensores_servico(void);
+
+// Cada leitura válida passa pela mediana de 3 e pelo IIR; a cada
+// SENSORES_DECIMACAO rodadas os valores filtrados entram na fila do rádio.
+// Grava no buffer os últimos valores filtrados ("T=23.4C U=56.7%"), com só
+// o motivo ("E=crc") no lugar de um sensor sem leitura válida; retorna se
+// todos são válidos. Só espera se nenhuma rodada terminou ainda.
+bool sensores_ler(char *out_str, size_t len);
+// Valores filtrados atuais, como uma amostra da fila; true se todos válidos
+bool sensores_atual(sensores_amostra_t *a);
+// Formata uma amostra como o sensores_ler
+bool sensores_formatar_amostra(char *out_str, size_t len, const sensores_amostra_t *a);
+// Formata as grandezas de um sensor ("T=23.4C U=56.7%") só com inteiros
+// (mesmo texto que o %.1f dava)
+void sensores_formatar_valores(char *out_str, size_t len, const sensor_driver_t *driver, const int16_t *valores);
+// Retira a amostra decimada mais antiga da fila; false se vazia
+bool sensores_consumir(sensores_amostra_t *a);
+// Amostras descartadas por fila cheia
+uint32_t sensores_perdidas(void);
+
+// Total de grandezas registradas
+uint8_t sensores_grandezas(void);
+// Último valor filtrado de uma grandeza; false se ele não é válido
+bool sensores_valor(uint8_t grandeza, int16_t *valor);
+sensor_qualidade_t sensores_qualidade(uint8_t sensor);
+// Quantas vezes o barramento foi recuperado e um sensor resetado
+uint32_t sensores_recuperacoes(void);
+// Duração da última rodada, do primeiro disparo à última coleta
+uint32_t sensores_latencia_us(void);
 
 #endif
@@ -0,0 +1,10 @@
+#ifndef SENSORES_BENCH_H
+#define SENSORES_BENCH_H
+
+// Mede ciclos por amostra da conversão e formatação do AHT20 em ponto fixo
+// contra o caminho anterior em float com %.1f, e conta os textos que
+// divergem numa varredura dos valores brutos. Não acessa o sensor.
+// A referência precisa do %f no printf (PICO_PRINTF_SUPPORT_FLOAT=1).
+void sensores_bench(void);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef SERIE_H
+#define SERIE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bloco de série temporal comprimida, no tamanho de uma página da flash
+#define SERIE_BLOCO_BYTES       256
+#define SERIE_GRANDEZAS_MAX     8
+
+// Valor de uma grandeza sem leitura válida
+#define SERIE_INVALIDO          INT16_MIN
+
+// Cabeçalho no início do bloco. t0 em 0xFFFFFFFF: bloco apagado
+typedef struct {
+    uint32_t t0;            // Instante da primeira amostra (s)
+    uint32_t t_fim;         // Instante da última
+    uint16_t n;             // Amostras no bloco
+    uint8_t grandezas;      // Valores por amostra
+    uint8_t crc;            // CRC-8 do bloco, sem este byte
+} serie_cabecalho_t;
+
+#define SERIE_CORPO_BITS        ((SERIE_BLOCO_BYTES - sizeof(serie_cabecalho_t)) * 8)
+
+// Codificação no estilo do Gorilla (Pelkonen et al., VLDB 2015), com os
+// valores em ponto fixo (int16, décimos) no lugar de doubles:
+//
+// - instante: delta-of-delta em segundos, em faixas de prefixo
+//   '0' (igual), '10'+7, '110'+9, '1110'+12 e '1111'+32 bits;
+// - cada valor: delta do anterior da mesma grandeza, em faixas
+//   '0' (igual), '10'+4, '110'+8 e '111'+17 bits.
+//
+// Os números com sinal vão em zigzag. Com amostras periódicas e grandezas
+// que variam devagar a maioria das amostras custa poucos bits.
+typedef struct {
+    uint8_t *bloco;         // SERIE_BLOCO_BYTES, cabeçalho incluído
+    uint32_t bits;          // Bits usados no corpo
+    uint32_t t_ant;
+    int32_t delta_ant;
+    int16_t v_ant[SERIE_GRANDEZAS_MAX];
+} serie_codificador_t;
+
+// Começa um bloco vazio em 'bloco'
+void serie_iniciar(serie_codificador_t *c, uint8_t *bloco, uint8_t grandezas);
+
+// Acrescenta uma amostra; false se ela não cabe no bloco ou o instante
+// voltou (o bloco fica como estava)
+bool serie_adicionar(serie_codificador_t *c, uint32_t t, const int16_t *valores);
+
+// Calcula o CRC; depois disso o bloco pode ir para a flash
+void serie_fechar(serie_codificador_t *c);
+
+static inline const serie_cabecalho_t *serie_cabecalho(const uint8_t *bloco) {
+    return (const serie_cabecalho_t *)bloco;
+}
+
+// Bloco fechado com CRC correto
+bool serie_bloco_valido(const uint8_t *bloco);
+
+// Leitura sequencial de um bloco (fechado ou ainda em montagem)
+typedef struct {
+    const uint8_t *bloco;
+    uint32_t bit;
+    uint16_t restantes;
+    uint8_t grandezas;
+    uint32_t t;
+    int32_t delta;
+    int16_t v[SERIE_GRANDEZAS_MAX];
+} serie_leitor_t;
+
+void serie_abrir(serie_leitor_t *l, const uint8_t *bloco);
+
+// Próxima amostra do bloco; false no fim
+bool serie_proxima(serie_leitor_t *l, uint32_t *t, int16_t *valores);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef SSD1306_BENCH_H
+#define SSD1306_BENCH_H
+
+#include "ssd1306.h"
+
+// Mede ciclos por chamada das primitivas de desenho e imprime na USB,
+// comparando com as versões pixel a pixel. Sobrescreve o framebuffer.
+void ssd1306_bench(ssd1306_t *ssd);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef TELA_H
+#define TELA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+// Tela principal do nó, montada com widgets retidos: só os campos que
+// mudaram são redesenhados e enviados ao display
+
+// Campos exibidos, copiados pelo agendador do display
+typedef struct {
+    char status[32];
+    char last_message[64];
+    uint32_t tx_count;
+    // Leituras dos sensores: cada novo valor de 'amostras' entra no gráfico
+    uint32_t amostras;
+    int16_t temp_x10;
+    int16_t umid_x10;
+} tela_estado_t;
+
+// Limpa o framebuffer e desenha a parte fixa da tela
+void tela_init(ssd1306_t *ssd);
+
+// Atualiza os campos; retorna true se algo foi redesenhado
+bool tela_atualizar(ssd1306_t *ssd, const tela_estado_t *estado);
+
+#endif
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
@@ -6,12 +7,32 @@
 #include "inc/rfm95.h"
 #include "inc/ssd1306.h"
 #include "inc/sensores.h"
+#include "inc/aht20.h"
+#include "inc/ssd1306_bench.h"
+#include "inc/sensores_bench.h"
+#include "inc/tela.h"
+#include "inc/display_agendador.h"
+#include "inc/excecao.h"
+#include "inc/diario.h"
+#include "inc/historico.h"
+#include "inc/lote.h"
+#include "inc/config.h"
 
 
 #define PIN_RST   20
 #define PIN_CS    17
 #define PIN_IRQ   8
 
+// Configuração padrão do nó, usada enquanto a flash não tem uma gravada
+// (config.h); o gateway pode trocá-la pelo rádio
+#define FREQUENCIA_KHZ    915000
+#define POTENCIA_DBM      20
+
+// Endereçamento LoRa (cabeçalho filtrado no gateway)
+#define REDE_ID           0x2A
+#define ENDERECO_GATEWAY  0x01
+#define ENDERECO_NO       0x02
+
 #define LED_TESTE     15
 #define LED_AZUL      12
 #define LED_VERDE     11
@@ -31,13 +52,84 @@
 #define SENSOR_I2C_SCL    1
 #define SENSOR_I2C_PORT i2c0
 
+// Acrescenta " @<instante da amostra>+<espera no nó>" (us) à telemetria,
+// usado pelo gateway para medir latência fim a fim
+#define ENVIAR_TIMESTAMP  1
+
+// Envia sozinho as amostras filtradas e decimadas dos sensores (uma a cada
+// SENSORES_DECIMACAO leituras); com 0, só o botão A envia
+#define TELEMETRIA_PERIODICA  1
+
+// Relatório por exceção da telemetria periódica: só envia quando a
+// temperatura muda 0,2 °C ou a umidade 1 %, pelo menos a cada 10 min
+// (heartbeat) e no máximo uma vez por minuto
+#define BANDA_TEMP_X10        2
+#define BANDA_UMID_X10        10
+#define SILENCIO_MAX_MS       (10 * 60 * 1000)
+#define INTERVALO_MIN_MS      (60 * 1000)
+
+// Entrega confirmada: toda amostra a enviar vai antes para o diário na
+// flash e só sai dele com o ACK do gateway. Sem ACK em ENLACE_ACK_MS mais
+// o tempo no ar da maior confirmação no perfil atual, o enlace é dado
+// como fora e a próxima tentativa fica para depois de ENLACE_REENVIO_MS;
+// quando o ACK volta, as amostras acumuladas seguem em quadros de lote,
+// da mais antiga para a mais nova
+#define ENLACE_ACK_MS         400
+#define ENLACE_REENVIO_MS     (30 * 1000)
+
+// Enlace trocado pelo rádio (frequência, modem, rede...) sem nenhum ACK em
+// tantas tentativas seguidas: o nó volta à configuração anterior, que o
+// gateway ainda escuta
+#define ENLACE_REVERSAO_FALHAS  3
+
+// Mede as primitivas do display na inicialização (saída na USB)
+#define SSD1306_BENCH     0
+
+// Mede a conversão do AHT20 em ponto fixo contra a antiga em float; exige
+// PICO_PRINTF_SUPPORT_FLOAT=1 no CMakeLists.txt
+#define SENSORES_BENCH    0
+
 // Variáveis globais
 ssd1306_t display;
 
 static char last_message[64] = "Aguardando...";
 static char status_msg[32] = "PRONTO";
 static uint32_t tx_count = 0;
-static uint8_t contador = 0;
+static uint32_t leituras = 0;
+static excecao_t relatorio;
+static diario_t diario;
+
+// Configuração em vigor e o prefixo "P<endereço>" da telemetria
+static config_t cfg;
+static char prefixo[8];
+
+// Configuração de fábrica, com os padrões acima
+static const config_t padrao = {
+    .freq_khz = FREQUENCIA_KHZ, .potencia_dbm = POTENCIA_DBM,
+    .sf = 7, .largura_banda = 7, .codigo = 1,       // SF7, 125 kHz, 4/5
+    .rede_id = REDE_ID, .endereco = ENDERECO_NO, .endereco_gateway = ENDERECO_GATEWAY,
+    .decimacao = SENSORES_DECIMACAO, .periodo_ms = SENSORES_PERIODO_MS,
+    .banda_temp_x10 = BANDA_TEMP_X10, .banda_umid_x10 = BANDA_UMID_X10,
+    .silencio_max_ms = SILENCIO_MAX_MS, .intervalo_min_ms = INTERVALO_MIN_MS,
+};
+
+// Histórico comprimido de todas as amostras decimadas, antes do relatório
+// por exceção
+static historico_t historico;
+
+// Quadro aguardando confirmação
+static struct {
+    bool aguardando;
+    uint32_t primeiro, ultimo;      // seqs do diário no quadro
+    uint64_t prazo_us;              // Fim da janela do ACK
+    uint64_t proxima_us;            // Próxima tentativa depois de uma falha
+    uint32_t acks, falhas;
+    uint32_t seguidas;              // Falhas desde o último ACK
+} enlace;
+
+// Índices das grandezas do AHT20 nas amostras dos sensores
+static int grandeza_temp = -1;
+static int grandeza_umid = -1;
 
 void init_gpio(void) {
     gpio_init(LED_TESTE); gpio_set_dir(LED_TESTE, GPIO_OUT);
@@ -77,56 +169,399 @@ void init_sensor_i2c(void) {
     gpio_pull_up(SENSOR_I2C_SCL);
 }
 
+static bool desenhar_tela(ssd1306_t *ssd, const void *estado) {
+    return tela_atualizar(ssd, estado);
+}
+
 void init_display(void) {
-    ssd1306_init(&display, 128, 64, false, DISPLAY_ADDR, DISPLAY_I2C_PORT);
+    ssd1306_init(&display, false, DISPLAY_ADDR, DISPLAY_I2C_PORT);
     ssd1306_config(&display);
+#if SSD1306_BENCH
+    ssd1306_bench(&display);
+#endif
     ssd1306_fill(&display, false);
     
     ssd1306_draw_string(&display, "LoRa BitDogLab", 0, 0);
-    ssd1306_draw_string(&display, "Freq: 915 MHz", 0, 8);
-    ssd1306_draw_string(&display, "Power: 20 dBm", 0, 16);
+    char linha[24];
+    snprintf(linha, sizeof(linha), "Freq: %lu MHz", (unsigned long)(cfg.freq_khz / 1000));
+    ssd1306_draw_string(&display, linha, 0, 8);
+    snprintf(linha, sizeof(linha), "Power: %d dBm", cfg.potencia_dbm);
+    ssd1306_draw_string(&display, linha, 0, 16);
     ssd1306_draw_string(&display, "Status: INIT", 0, 24);
     ssd1306_send_data(&display);
     
     sleep_ms(2000);
+    tela_init(&display);
+    display_agendador_iniciar(&display, desenhar_tela, sizeof(tela_estado_t), DISPLAY_PERIODO_MS, true);
 }
 
 void update_display(void) {
-    char temp[64];
-    ssd1306_fill(&display, false);
+    // Só publica o estado: o core 1 desenha os widgets alterados a até 10 fps
+    tela_estado_t estado;
+    strncpy(estado.status, status_msg, sizeof(estado.status));
+    strncpy(estado.last_message, last_message, sizeof(estado.last_message));
+    estado.tx_count = tx_count;
+    estado.amostras = leituras;
+    estado.temp_x10 = estado.umid_x10 = 0;
+    sensores_valor(grandeza_temp, &estado.temp_x10);
+    sensores_valor(grandeza_umid, &estado.umid_x10);
+    display_agendador_publicar(&estado);
+}
 
-    ssd1306_draw_string(&display, "LoRa Transceiver", 0, 0);
-    ssd1306_hline(&display, 0, 127, 9, true);
-    snprintf(temp, sizeof(temp), "Status: %s", status_msg);
-    ssd1306_draw_string(&display, temp, 0, 12);
-    snprintf(temp, sizeof(temp), "TX:%lu", tx_count);
-    ssd1306_draw_string(&display, temp, 0, 20);
-    ssd1306_draw_string(&display, "Ultima msg:", 0, 28);
-    ssd1306_draw_string(&display, last_message, 0, 36);
-    ssd1306_draw_string(&display, "A: Sensores  B:Teste", 0, 56);
-    ssd1306_send_data(&display);
+// Relógio do nó em ms: o do histórico, que continua de um boot para o
+// outro, mais o tempo desde este boot. As amostras do diário são datadas
+// nele, então a idade de uma amostra de um boot anterior não dá a volta
+static uint64_t relogio_ms(void) {
+    return (uint64_t)historico.relogio_s * 1000 + time_us_64() / 1000;
 }
 
-void send_sensor_data(void) {
-    char dados[64];
-    sensores_ler(dados, sizeof(dados));
+// Idade de um instante do relógio do nó (0 se ainda no futuro)
+static uint64_t idade_ms(uint64_t t_ms) {
+    uint64_t agora = relogio_ms();
+    return agora > t_ms ? agora - t_ms : 0;
+}
 
-    char pacote[80];
-    snprintf(pacote, sizeof(pacote), "P2:%s #%d", dados, ++contador);
+// Amostra no diário: instante (s e ms do relógio do nó), qualidade (2 bits
+// por sensor), número de grandezas e os valores
+#define AMOSTRA_CABECALHO 8
+_Static_assert(AMOSTRA_CABECALHO + 2 * SENSORES_GRANDEZAS_MAX <= DIARIO_DADOS_MAX, "amostra nao cabe no diario");
+_Static_assert(2 * SENSORES_MAX <= 8, "qualidade nao cabe em um byte");
 
-    rfm95_send_message(pacote);
-    rfm95_set_mode_standby();
+static uint8_t empacotar_amostra(const sensores_amostra_t *a, uint64_t t_ms, uint8_t *buf) {
+    uint8_t qualidade = 0;
+    for (uint8_t i = 0; i < SENSORES_MAX; ++i) qualidade |= (a->qualidade[i] & 0x03) << (2 * i);
+    uint32_t t_s = (uint32_t)(t_ms / 1000);
+    uint16_t t_frac = (uint16_t)(t_ms % 1000);
+    memcpy(buf, &t_s, sizeof(t_s));
+    memcpy(buf + 4, &t_frac, sizeof(t_frac));
+    buf[6] = qualidade;
+    buf[7] = a->n;
+    memcpy(buf + AMOSTRA_CABECALHO, a->valores, a->n * sizeof(a->valores[0]));
+    return AMOSTRA_CABECALHO + a->n * sizeof(a->valores[0]);
+}
+
+static uint64_t instante_registro(const diario_registro_t *r) {
+    uint32_t t_s;
+    uint16_t t_frac;
+    memcpy(&t_s, r->dados, sizeof(t_s));
+    memcpy(&t_frac, r->dados + 4, sizeof(t_frac));
+    return (uint64_t)t_s * 1000 + t_frac;
+}
+
+// Texto da telemetria de um registro do diário
+static bool formatar_registro(const diario_registro_t *r, char *dados, size_t len, uint64_t *t_ms) {
+    sensores_amostra_t a;
+    memset(&a, 0, sizeof(a));
+    *t_ms = instante_registro(r);
+    for (uint8_t i = 0; i < SENSORES_MAX; ++i) a.qualidade[i] = (r->dados[6] >> (2 * i)) & 0x03;
+    a.n = r->dados[7] <= SENSORES_GRANDEZAS_MAX ? r->dados[7] : SENSORES_GRANDEZAS_MAX;
+    memcpy(a.valores, r->dados + AMOSTRA_CABECALHO, a.n * sizeof(a.valores[0]));
+    return sensores_formatar_amostra(dados, len, &a);
+}
+
+// O relógio do histórico retoma do último bloco na flash; as amostras do
+// bloco que estava em RAM podem ainda estar pendentes no diário, datadas
+// mais à frente. O relógio passa da mais nova delas
+static void retomar_relogio(void) {
+    diario_registro_t r;
+    for (uint32_t seq = diario.proximo_seq; seq != diario_cauda(&diario); --seq) {
+        if (!diario_ler(&diario, seq - 1, &r)) continue;
+        historico_avancar(&historico, (uint32_t)(instante_registro(&r) / 1000) + 1);
+        return;
+    }
+}
+
+// Guarda a amostra para envio; o enlace a transmite no próximo serviço.
+// O instante vai no relógio do nó, já descontado o tempo na fila
+static void registrar_amostra(const sensores_amostra_t *a) {
+    uint8_t buf[DIARIO_DADOS_MAX];
+    uint8_t len = empacotar_amostra(a, relogio_ms() - (time_us_32() - a->t_us) / 1000, buf);
+    diario_gravar(&diario, buf, len, to_ms_since_boot(get_absolute_time()));
+}
+
+static void transmitir(const char *pacote, const char *status) {
+    uint64_t inicio_tx = time_us_64();
+    rfm95_send_to(cfg.endereco_gateway, RFM95_FLAG_PEDE_ACK, pacote);
+    uint64_t fim_tx = rfm95_get_tx_done_us();
+    rfm95_set_mode_rx();
 
     tx_count++;
-    strcpy(last_message, pacote);
-    strcpy(status_msg, "ENVIADO");
-    printf("Mensagem enviada: %s\n", pacote);
+    strncpy(last_message, pacote, sizeof(last_message) - 1);
+    strcpy(status_msg, status);
+    printf("Mensagem enviada: %s (TX %llu us, %lu no diario)\n", pacote,
+           (unsigned long long)(fim_tx - inicio_tx), (unsigned long)diario_pendentes(&diario));
     update_display();
 }
 
+// Só a amostra mais recente pendente: telemetria no formato de sempre
+void send_sensor_packet(const char *dados, bool valida, uint32_t seq, uint64_t t_amostra_ms) {
+    char pacote[80];
+#if ENVIAR_TIMESTAMP
+    uint64_t espera_ms = idade_ms(t_amostra_ms);
+    // Em us de 64 bits: em 32 dariam a volta em 71 min, menos do que uma
+    // amostra pode esperar no diário
+    snprintf(pacote, sizeof(pacote), "%s:%s #%lu @%llu+%llu", prefixo, dados, (unsigned long)seq,
+             (unsigned long long)t_amostra_ms * 1000, (unsigned long long)espera_ms * 1000);
+#else
+    snprintf(pacote, sizeof(pacote), "%s:%s #%lu", prefixo, dados, (unsigned long)seq);
+#endif
+    transmitir(pacote, valida ? "ENVIADO" : "ERRO SENSOR");
+}
+
+// Várias pendentes: quadro de lote a partir da mais antiga
+static uint32_t send_batch(uint32_t seq, const diario_registro_t *primeiro) {
+    char pacote[RFM95_MENSAGEM_MAX];
+    char dados[64];
+    uint64_t t_ms;
+    uint32_t ultimo = seq;
+    diario_registro_t r = *primeiro;
+    lote_t lote;
+
+    lote_iniciar(&lote, pacote, sizeof(pacote), prefixo, seq);
+    for (uint32_t s = seq; s - seq < diario_pendentes(&diario); ++s) {
+        if (s != seq && !diario_ler(&diario, s, &r)) break;
+        formatar_registro(&r, dados, sizeof(dados), &t_ms);
+        if (!lote_adicionar(&lote, (uint32_t)(idade_ms(t_ms) / 1000), dados)) break;
+        ultimo = s;
+    }
+    transmitir(pacote, "REENVIO");
+    return ultimo;
+}
+
+// Transmite a partir da amostra pendente mais antiga
+static void send_pending(void) {
+    diario_registro_t r;
+    uint32_t seq = diario_cauda(&diario);
+    // Registros que não existem mais (setor reaproveitado, gravação
+    // interrompida, salto do boot) não têm o que reenviar
+    while (diario_pendentes(&diario) > 0 && !diario_ler(&diario, seq, &r)) {
+        diario_confirmar(&diario, seq++);
+    }
+    if (diario_pendentes(&diario) == 0) return;
+
+    uint32_t ultimo = seq;
+    if (diario_pendentes(&diario) == 1) {
+        char dados[64];
+        uint64_t t_ms;
+        bool valida = formatar_registro(&r, dados, sizeof(dados), &t_ms);
+        send_sensor_packet(dados, valida, seq, t_ms);
+    } else {
+        ultimo = send_batch(seq, &r);
+    }
+
+    enlace.aguardando = true;
+    enlace.primeiro = seq;
+    enlace.ultimo = ultimo;
+    // A confirmação pode trazer um comando: a janela cobre a maior
+    enlace.prazo_us = time_us_64() + ENLACE_ACK_MS * 1000ull +
+                      rfm95_tempo_no_ar_us(RFM95_HEADER_LEN + RFM95_MENSAGEM_MAX - 1);
+}
+
+// Leva o rádio, a amostragem e o relatório por exceção para cfg
+static void aplicar_config(void) {
+    uint8_t m1, m2, m3;
+    config_modem(&cfg, &m1, &m2, &m3);
+    rfm95_config(cfg.freq_khz / 1000.0f, cfg.potencia_dbm);
+    rfm95_set_modem(m1, m2, m3);
+    rfm95_set_address(cfg.rede_id, cfg.endereco);
+    snprintf(prefixo, sizeof(prefixo), "P%u", cfg.endereco);
+
+    sensores_configurar(cfg.periodo_ms, cfg.decimacao);
+    // Bandas na ordem das grandezas registradas
+    const int32_t bandas[EXCECAO_MAX] = { cfg.banda_temp_x10, cfg.banda_umid_x10 };
+    excecao_init(&relatorio, sensores_grandezas(), bandas, cfg.silencio_max_ms, cfg.intervalo_min_ms);
+}
+
+// Consulta ao histórico pelo canal de comandos ("h=<instante>"): responde
+// "P<n>:CFG=<id> h=<t0>:..." (historico_formatar) com as amostras que
+// couberem no quadro, "h=-" se não há nenhuma. Não grava nada, então uma
+// repetição só consulta de novo
+static void receive_history_query(uint16_t id, const char *instante) {
+    char resposta[RFM95_MENSAGEM_MAX];
+    char *fim;
+    unsigned long t = strtoul(instante, &fim, 10);
+    int n = snprintf(resposta, sizeof(resposta), "%s:CFG=%u ", prefixo, id);
+    if (fim == instante || *fim != '\0') {
+        snprintf(resposta + n, sizeof(resposta) - n, "erro=h");
+    } else if (historico_formatar(&historico, (uint32_t)t, resposta + n, sizeof(resposta) - n) == 0) {
+        snprintf(resposta + n, sizeof(resposta) - n, "h=-");
+    }
+    printf("Historico: consulta %u a partir de %lu s\n", id, t);
+    rfm95_send_to(cfg.endereco_gateway, 0, resposta);
+}
+
+// Comando de configuração que veio com a confirmação: aplica, grava e
+// responde "P<n>:CFG=<id> g=<geração>" (ou "erro=<chave>"). Um comando
+// repetido (a resposta se perdeu) só é respondido de novo. A troca do
+// rádio vale depois da resposta, que ainda sai no perfil antigo, e fica
+// provisória até o primeiro ACK no perfil novo
+static void receive_config(const char *msg) {
+    uint16_t id;
+    const char *campos;
+    uint32_t chave;
+    if (!config_ler_comando(msg, &id, &campos, &chave)) return;
+    if (strncmp(campos, "h=", 2) == 0) {
+        receive_history_query(id, campos + 2);
+        return;
+    }
+
+    char resposta[48];
+    char erro[8];
+    config_t novo = cfg;
+    bool repetido = chave == cfg.comando;
+    if (!repetido && !config_aplicar_texto(&novo, campos, erro, sizeof(erro))) {
+        snprintf(resposta, sizeof(resposta), "%s:CFG=%u erro=%s", prefixo, id, erro);
+    } else {
+        novo.comando = chave;
+        if (!repetido) novo.provisoria = config_enlace_mudou(&cfg, &novo);
+        if (!repetido && !config_gravar(&novo)) {
+            snprintf(resposta, sizeof(resposta), "%s:CFG=%u erro=flash", prefixo, id);
+        } else {
+            snprintf(resposta, sizeof(resposta), "%s:CFG=%u g=%lu", prefixo, id, (unsigned long)novo.geracao);
+        }
+    }
+    printf("Config: comando %u%s: %s\n", id, repetido ? " repetido" : "", campos);
+    rfm95_send_to(cfg.endereco_gateway, 0, resposta);
+
+    // Só com a nova geração na flash
+    if (novo.geracao != cfg.geracao) {
+        cfg = novo;
+        aplicar_config();
+    }
+}
+
+// Primeiro ACK no enlace trocado pelo rádio: ele passa a valer de vez
+static void confirmar_enlace(void) {
+    if (!cfg.provisoria) return;
+    config_t novo = cfg;
+    novo.provisoria = 0;
+    if (!config_gravar(&novo)) return;
+    cfg = novo;
+    printf("Config: enlace confirmado (geracao %lu)\n", (unsigned long)cfg.geracao);
+}
+
+// Enlace trocado pelo rádio sem nenhum ACK: volta à configuração do outro
+// slot, gravada de novo com a geração seguinte para valer também depois
+// de um reboot. O último comando continua reconhecido como aplicado
+static void reverter_enlace(void) {
+    config_t anterior;
+    if (!config_anterior(&cfg, &padrao, &anterior)) return;
+    anterior.geracao = cfg.geracao;
+    anterior.comando = cfg.comando;
+    anterior.provisoria = 0;
+    if (!config_gravar(&anterior)) return;
+    cfg = anterior;
+    aplicar_config();
+    enlace.seguidas = 0;
+    printf("Config: sem ACK no enlace novo, de volta ao anterior (geracao %lu)\n", (unsigned long)cfg.geracao);
+}
+
+// "A:<seq>" do gateway para o quadro em voo, às vezes com um comando de
+// configuração
+static bool receive_ack(void) {
+    rfm95_packet_t packet;
+    if (!rfm95_available() || !rfm95_receive_message(&packet)) return false;
+    if (!packet.addressed || packet.header.src != cfg.endereco_gateway || !(packet.header.flags & RFM95_FLAG_ACK)) return false;
+    if (strncmp(packet.message, "A:", 2) != 0) return false;
+
+    uint32_t seq = strtoul(packet.message + 2, NULL, 10);
+    if (seq < enlace.primeiro || seq > enlace.ultimo) return false;
+    diario_confirmar(&diario, seq);
+    confirmar_enlace();
+    receive_config(packet.message);
+    return true;
+}
+
+// Um passo da entrega: espera o ACK do quadro em voo ou transmite o
+// próximo, se há pendentes e o enlace não está em espera
+void enlace_servico(void) {
+    uint64_t agora = time_us_64();
+    if (enlace.aguardando) {
+        if (receive_ack()) {
+            enlace.aguardando = false;
+            enlace.acks++;
+            enlace.seguidas = 0;
+            enlace.proxima_us = 0;
+            rfm95_set_mode_standby();
+            strcpy(status_msg, "CONFIRMADO");
+            update_display();
+        } else if (agora >= enlace.prazo_us) {
+            enlace.aguardando = false;
+            enlace.falhas++;
+            enlace.seguidas++;
+            enlace.proxima_us = agora + ENLACE_REENVIO_MS * 1000ull;
+            rfm95_set_mode_standby();
+            snprintf(status_msg, sizeof(status_msg), "SEM ACK (%lu)", (unsigned long)diario_pendentes(&diario));
+            printf("Sem ACK: %lu amostras no diario, nova tentativa em %d s\n",
+                   (unsigned long)diario_pendentes(&diario), ENLACE_REENVIO_MS / 1000);
+            if (cfg.provisoria && enlace.seguidas >= ENLACE_REVERSAO_FALHAS) reverter_enlace();
+            update_display();
+        }
+        return;
+    }
+    if (diario_pendentes(&diario) > 0 && agora >= enlace.proxima_us) send_pending();
+}
+
+// Valores de uma amostra para o relatório por exceção
+static uint8_t valores_relatorio(const sensores_amostra_t *amostra, int32_t *valores) {
+    uint8_t n = amostra->n < EXCECAO_MAX ? amostra->n : EXCECAO_MAX;
+    for (uint8_t i = 0; i < n; ++i) valores[i] = amostra->valores[i];
+    return n;
+}
+
+// Botão A: envia já o último valor filtrado, fora do relatório por
+// exceção (mas ele passa a ser a referência das bandas), mesmo com o
+// enlace em espera
+void send_sensor_data(void) {
+    char dados[64];
+    // Amostra inválida segue só como "E=<motivo>": o gateway não a
+    // confunde com um valor e o pacote fica mais curto
+    bool valida = sensores_ler(dados, sizeof(dados));
+
+    sensores_amostra_t amostra;
+    int32_t valores[EXCECAO_MAX];
+    sensores_atual(&amostra);
+    valores_relatorio(&amostra, valores);
+    excecao_registrar(&relatorio, valores, valida, to_ms_since_boot(get_absolute_time()));
+
+    registrar_amostra(&amostra);
+    enlace.proxima_us = 0;
+    enlace_servico();
+}
+
+// Amostra no histórico; sem leitura válida todas as grandezas vão como
+// SERIE_INVALIDO
+static void arquivar_amostra(const sensores_amostra_t *a, bool valida) {
+    int16_t valores[SERIE_GRANDEZAS_MAX];
+    uint8_t n = a->n < SERIE_GRANDEZAS_MAX ? a->n : SERIE_GRANDEZAS_MAX;
+    for (uint8_t i = 0; i < n; ++i) valores[i] = valida ? a->valores[i] : SERIE_INVALIDO;
+    uint64_t t_us = time_us_64() - (time_us_32() - a->t_us);
+    historico_gravar(&historico, (uint32_t)(t_us / 1000000), valores, n);
+}
+
+// Amostras decimadas da fila dos sensores vão todas para o histórico e,
+// filtradas pelo relatório por exceção, para o diário; a espera informada
+// no timestamp inclui o tempo na fila do diário
+void send_queued_samples(void) {
+    sensores_amostra_t amostra;
+    while (sensores_consumir(&amostra)) {
+        char dados[64];
+        int32_t valores[EXCECAO_MAX];
+        bool valida = sensores_formatar_amostra(dados, sizeof(dados), &amostra);
+        valores_relatorio(&amostra, valores);
+        uint32_t agora_ms = to_ms_since_boot(get_absolute_time());
+        arquivar_amostra(&amostra, valida);
+        if (!excecao_enviar(excecao_avaliar(&relatorio, valores, valida, agora_ms))) continue;
+
+        registrar_amostra(&amostra);
+    }
+}
+
 void send_test_message(const char *msg) {
-    rfm95_send_message(msg);
-    rfm95_set_mode_standby();
+    rfm95_send_to(cfg.endereco_gateway, 0, msg);
+    // Não atrapalha a janela de um ACK pendente
+    if (enlace.aguardando) rfm95_set_mode_rx();
+    else rfm95_set_mode_standby();
 
     tx_count++;
     strcpy(last_message, msg);
@@ -139,20 +574,57 @@ int main() {
     stdio_init_all();
     sleep_ms(2000);
 
+    // Primeiro a configuração: dois registros lidos pela XIP, sem apagar
+    // nem programar nada
+    uint64_t inicio_config = time_us_64();
+    int slot = config_carregar(&cfg, &padrao);
+    uint32_t carga_us = (uint32_t)(time_us_64() - inicio_config);
+    if (slot < 0) printf("Config: padrao do firmware (%lu us)\n", (unsigned long)carga_us);
+    else printf("Config: geracao %lu do slot %d%s (%lu us)\n", (unsigned long)cfg.geracao, slot,
+                cfg.provisoria ? ", enlace provisorio" : "", (unsigned long)carga_us);
+
     init_gpio();
     init_spi();
     init_display_i2c();  // Inicializa I2C para display
     init_sensor_i2c();   // Inicializa I2C para sensores
+    // Antes do core 1 (display): a varredura e o apagamento do setor da
+    // cabeça rodam sem precisar parar o outro core
+    diario_init(&diario);
+    printf("Diario: proximo #%lu, %lu amostras pendentes\n",
+           (unsigned long)diario.proximo_seq, (unsigned long)diario_pendentes(&diario));
+    historico_init(&historico);
+    retomar_relogio();
+    printf("Historico: relogio em %lu s\n", (unsigned long)historico.relogio_s);
     init_display();
-    sensores_init(SENSOR_I2C_PORT);  // Usa o barramento I2C correto dos sensores
+    sensores_init(SENSOR_I2C_PORT, SENSOR_I2C_SDA, SENSOR_I2C_SCL);  // Usa o barramento I2C correto dos sensores
+    grandeza_temp = sensores_registrar(&aht20_driver);
+    grandeza_umid = grandeza_temp + 1;
+#if SENSORES_BENCH
+    sensores_bench();
+#endif
 
     rfm95_init(spi0, PIN_CS, PIN_RST, PIN_IRQ);
-    rfm95_config(915.0, 20);
+    aplicar_config();
+    rfm95_set_address_filter(true);     // Só os ACKs endereçados a este nó
 
     strcpy(status_msg, "PRONTO PARA TX");
     update_display();
 
     while (true) {
+        // Medição do AHT20 em segundo plano: o botão só formata a última
+        // amostra. Só leituras válidas entram no gráfico da tela
+        if (sensores_servico()) {
+            int16_t t_x10;
+            if (sensores_valor(grandeza_temp, &t_x10)) leituras++;
+            update_display();
+        }
+#if TELEMETRIA_PERIODICA
+        send_queued_samples();
+#endif
+        enlace_servico();
+        // Uma operação de flash por volta, o diário primeiro
+        if (!diario_servico(&diario, to_ms_since_boot(get_absolute_time()))) historico_servico(&historico);
+
         if (!gpio_get(BTN_A)) {
             gpio_put(LED_VERMELHO, 1);
             send_sensor_data();
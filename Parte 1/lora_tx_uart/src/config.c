@@ -0,0 +1,290 @@
+#include "../inc/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+// No nó, logo antes da região do histórico; o gateway, sem diário nem
+// histórico, define CONFIG_FIM_FLASH como o fim da flash
+#ifndef CONFIG_FIM_FLASH
+#include "../inc/diario.h"
+#include "../inc/historico.h"
+#define CONFIG_FIM_FLASH (PICO_FLASH_SIZE_BYTES - DIARIO_SETORES * DIARIO_SETOR_BYTES \
+                          - HISTORICO_SETORES * HISTORICO_SETOR_BYTES)
+#endif
+#define CONFIG_OFFSET (CONFIG_FIM_FLASH - CONFIG_SLOTS * CONFIG_SLOT_BYTES)
+
+// Espera máxima para o outro core sair da flash
+#define CONFIG_FLASH_TIMEOUT_MS 100
+
+// Cabeçalho e CRC: o menor registro que alguma versão pode ter gravado
+#define CONFIG_TAMANHO_MIN      (offsetof(config_t, freq_khz) + sizeof(uint16_t))
+
+_Static_assert(sizeof(config_t) == 48, "registro da configuracao deve ter 48 bytes");
+_Static_assert(offsetof(config_t, crc) == sizeof(config_t) - sizeof(uint16_t), "CRC deve fechar o registro");
+_Static_assert(CONFIG_SLOT_BYTES == FLASH_SECTOR_SIZE && CONFIG_PAGINA_BYTES == FLASH_PAGE_SIZE,
+               "geometria da configuracao difere da flash");
+
+static const uint32_t larguras_banda_hz[] = {
+    7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000
+};
+
+#define LARGURAS_BANDA (sizeof(larguras_banda_hz) / sizeof(larguras_banda_hz[0]))
+
+// CRC-16/CCITT (polinômio 0x1021, início 0xFFFF)
+static uint16_t crc16(const uint8_t *p, size_t n) {
+    uint16_t crc = 0xFFFF;
+    while (n--) {
+        crc ^= (uint16_t)*p++ << 8;
+        for (uint8_t b = 0; b < 8; ++b) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// ---------------------------------------------------------------------
+// Acesso à flash
+// ---------------------------------------------------------------------
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *dados;
+} config_op_t;
+
+// Roda com as interrupções desligadas e o outro core parado
+static void op_gravar(void *p) {
+    const config_op_t *op = p;
+    flash_range_erase(op->offset, CONFIG_SLOT_BYTES);
+    flash_range_program(op->offset, op->dados, CONFIG_PAGINA_BYTES);
+}
+
+static const uint8_t *slot_flash(uint8_t slot) {
+    return (const uint8_t *)(uintptr_t)(XIP_BASE + CONFIG_OFFSET + slot * CONFIG_SLOT_BYTES);
+}
+
+// Registro íntegro de qualquer versão; 'tamanho' recebe os bytes gravados
+static bool registro_valido(const uint8_t *p, uint16_t *tamanho) {
+    config_t cab;
+    memcpy(&cab, p, offsetof(config_t, freq_khz));
+    if (cab.magica != CONFIG_MAGICA) return false;
+    if (cab.tamanho < CONFIG_TAMANHO_MIN || cab.tamanho > CONFIG_PAGINA_BYTES || (cab.tamanho & 1)) return false;
+
+    uint16_t crc;
+    memcpy(&crc, p + cab.tamanho - sizeof(crc), sizeof(crc));
+    if (crc16(p, cab.tamanho - sizeof(crc)) != crc) return false;
+    *tamanho = cab.tamanho;
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------
+
+// Registro de 'tamanho' bytes do slot sobre 'padrao' (slot < 0: só o padrão)
+static void ler_slot(int slot, uint16_t tamanho, config_t *cfg, const config_t *padrao) {
+    *cfg = *padrao;
+    if (slot >= 0) {
+        // Só os campos que as duas versões conhecem; os do cabeçalho
+        // voltam para os desta versão
+        size_t comum = tamanho - sizeof(uint16_t);
+        if (comum > offsetof(config_t, crc)) comum = offsetof(config_t, crc);
+        memcpy(cfg, slot_flash((uint8_t)slot), comum);
+    }
+    cfg->magica = CONFIG_MAGICA;
+    cfg->versao = CONFIG_VERSAO;
+    cfg->tamanho = sizeof(config_t);
+    cfg->crc = crc16((const uint8_t *)cfg, offsetof(config_t, crc));
+}
+
+static uint32_t geracao_slot(uint8_t slot) {
+    uint32_t g;
+    memcpy(&g, slot_flash(slot) + offsetof(config_t, geracao), sizeof(g));
+    return g;
+}
+
+int config_carregar(config_t *cfg, const config_t *padrao) {
+    int escolhido = -1;
+    uint16_t tamanho = 0;
+    uint32_t geracao = 0;
+    for (uint8_t slot = 0; slot < CONFIG_SLOTS; ++slot) {
+        uint16_t t;
+        if (!registro_valido(slot_flash(slot), &t)) continue;
+        uint32_t g = geracao_slot(slot);
+        if (escolhido < 0 || (int32_t)(g - geracao) > 0) {
+            escolhido = slot;
+            geracao = g;
+            tamanho = t;
+        }
+    }
+    ler_slot(escolhido, tamanho, cfg, padrao);
+    return escolhido;
+}
+
+bool config_anterior(const config_t *atual, const config_t *padrao, config_t *anterior) {
+    for (uint8_t slot = 0; slot < CONFIG_SLOTS; ++slot) {
+        uint16_t t;
+        if (!registro_valido(slot_flash(slot), &t) || (int32_t)(geracao_slot(slot) - atual->geracao) >= 0) continue;
+        ler_slot(slot, t, anterior, padrao);
+        return true;
+    }
+    return false;
+}
+
+bool config_gravar(config_t *cfg) {
+    config_t novo = *cfg;
+    novo.magica = CONFIG_MAGICA;
+    novo.versao = CONFIG_VERSAO;
+    novo.tamanho = sizeof(config_t);
+    novo.geracao++;
+    novo.crc = crc16((const uint8_t *)&novo, offsetof(config_t, crc));
+
+    // A geração alterna os slots: a nova nunca cai sobre a que está em vigor
+    uint8_t slot = novo.geracao % CONFIG_SLOTS;
+    uint8_t pagina[CONFIG_PAGINA_BYTES];
+    memset(pagina, 0xFF, sizeof(pagina));
+    memcpy(pagina, &novo, sizeof(novo));
+
+    config_op_t op = { CONFIG_OFFSET + slot * CONFIG_SLOT_BYTES, pagina };
+    if (flash_safe_execute(op_gravar, &op, CONFIG_FLASH_TIMEOUT_MS) != PICO_OK) return false;
+    if (memcmp(slot_flash(slot), &novo, sizeof(novo)) != 0) return false;
+    *cfg = novo;
+    return true;
+}
+
+// Inteiro decimal com sinal em [min, max], sem sobras
+static bool ler_inteiro(const char *valor, long min, long max, long *v) {
+    char *fim;
+    *v = strtol(valor, &fim, 10);
+    return fim != valor && *fim == '\0' && *v >= min && *v <= max;
+}
+
+static bool aplicar_campo(config_t *c, const char *chave, const char *valor) {
+    long v;
+    if (strcmp(chave, "f") == 0) {
+        if (!ler_inteiro(valor, 862000, 1020000, &v)) return false;
+        c->freq_khz = (uint32_t)v;
+    } else if (strcmp(chave, "p") == 0) {
+        if (!ler_inteiro(valor, 5, 23, &v)) return false;
+        c->potencia_dbm = (int8_t)v;
+    } else if (strcmp(chave, "sf") == 0) {
+        // SF6 exige cabeçalho implícito
+        if (!ler_inteiro(valor, 7, 12, &v)) return false;
+        c->sf = (uint8_t)v;
+    } else if (strcmp(chave, "bw") == 0) {
+        if (!ler_inteiro(valor, 1, 500000, &v)) return false;
+        uint8_t i = 0;
+        while (i < LARGURAS_BANDA && larguras_banda_hz[i] != (uint32_t)v) i++;
+        if (i == LARGURAS_BANDA) return false;
+        c->largura_banda = i;
+    } else if (strcmp(chave, "cr") == 0) {
+        if (!ler_inteiro(valor, 5, 8, &v)) return false;
+        c->codigo = (uint8_t)(v - 4);
+    } else if (strcmp(chave, "rede") == 0) {
+        if (!ler_inteiro(valor, 0, 255, &v)) return false;
+        c->rede_id = (uint8_t)v;
+    } else if (strcmp(chave, "end") == 0 || strcmp(chave, "gw") == 0) {
+        // 0xFF é o broadcast do cabeçalho
+        if (!ler_inteiro(valor, 0, 254, &v)) return false;
+        if (chave[0] == 'e') c->endereco = (uint8_t)v;
+        else c->endereco_gateway = (uint8_t)v;
+    } else if (strcmp(chave, "per") == 0) {
+        if (!ler_inteiro(valor, 100, 3600000, &v)) return false;
+        c->periodo_ms = (uint32_t)v;
+    } else if (strcmp(chave, "dec") == 0) {
+        if (!ler_inteiro(valor, 1, 255, &v)) return false;
+        c->decimacao = (uint8_t)v;
+    } else if (strcmp(chave, "bt") == 0 || strcmp(chave, "bu") == 0) {
+        if (!ler_inteiro(valor, 0, 1000, &v)) return false;
+        if (chave[1] == 't') c->banda_temp_x10 = (int16_t)v;
+        else c->banda_umid_x10 = (int16_t)v;
+    } else if (strcmp(chave, "sil") == 0 || strcmp(chave, "int") == 0) {
+        if (!ler_inteiro(valor, 0, 24L * 3600 * 1000, &v)) return false;
+        if (chave[0] == 's') c->silencio_max_ms = (uint32_t)v;
+        else c->intervalo_min_ms = (uint32_t)v;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool config_aplicar_texto(config_t *cfg, const char *texto, char *erro, size_t len) {
+    config_t novo = *cfg;
+    char campo[32];
+    const char *p = texto;
+    while (*p) {
+        size_t n = strcspn(p, ",");
+        const char *igual = memchr(p, '=', n);
+        size_t n_chave = igual ? (size_t)(igual - p) : n;
+        bool ok = igual && n < sizeof(campo);
+        if (ok) {
+            memcpy(campo, p, n);
+            campo[n] = '\0';
+            campo[n_chave] = '\0';
+            ok = aplicar_campo(&novo, campo, campo + n_chave + 1);
+        }
+        if (!ok) {
+            if (len > 0) {
+                size_t m = n_chave < len - 1 ? n_chave : len - 1;
+                memcpy(erro, p, m);
+                erro[m] = '\0';
+            }
+            return false;
+        }
+        p += n;
+        if (*p == ',') p++;
+    }
+
+    // O nó não pode ter o endereço do gateway
+    if (novo.endereco == novo.endereco_gateway) {
+        if (len > 0) snprintf(erro, len, "end");
+        return false;
+    }
+    *cfg = novo;
+    return true;
+}
+
+bool config_enlace_mudou(const config_t *a, const config_t *b) {
+    return a->freq_khz != b->freq_khz || a->potencia_dbm != b->potencia_dbm || a->sf != b->sf ||
+           a->largura_banda != b->largura_banda || a->codigo != b->codigo || a->rede_id != b->rede_id ||
+           a->endereco_gateway != b->endereco_gateway;
+}
+
+bool config_seguir(config_t *gateway, const char *campos) {
+    // O nó visto do gateway: o endereço do gateway é o 'gw' dele
+    config_t no = *gateway;
+    no.endereco_gateway = gateway->endereco;
+    char erro[8];
+    if (!config_aplicar_texto(&no, campos, erro, sizeof(erro))) return false;
+
+    config_t novo = *gateway;
+    novo.freq_khz = no.freq_khz;
+    novo.sf = no.sf;
+    novo.largura_banda = no.largura_banda;
+    novo.codigo = no.codigo;
+    novo.rede_id = no.rede_id;
+    novo.endereco = no.endereco_gateway;
+    if (!config_enlace_mudou(gateway, &novo) && novo.endereco == gateway->endereco) return false;
+    *gateway = novo;
+    return true;
+}
+
+void config_modem(const config_t *cfg, uint8_t *modem_config1, uint8_t *modem_config2, uint8_t *modem_config3) {
+    uint8_t bw = cfg->largura_banda < LARGURAS_BANDA ? cfg->largura_banda : 7;
+    *modem_config1 = (uint8_t)(bw << 4) | (uint8_t)((cfg->codigo & 0x07) << 1);    // Cabeçalho explícito
+    *modem_config2 = (uint8_t)(cfg->sf << 4) | 0x04;                                // CRC ligado
+    // Símbolo de 2^SF / BW: acima de 16 ms o datasheet pede o LDRO
+    bool ldro = ((uint64_t)1000 << cfg->sf) > 16ull * larguras_banda_hz[bw];
+    *modem_config3 = 0x04 | (ldro ? 0x08 : 0x00);                                   // AGC ligado
+}
+
+bool config_ler_comando(const char *msg, uint16_t *id, const char **campos, uint32_t *chave) {
+    const char *p = strstr(msg, ";C:");
+    if (!p) return false;
+    char *fim;
+    unsigned long v = strtoul(p + 3, &fim, 10);
+    if (fim == p + 3 || *fim != ':' || v == 0 || v > UINT16_MAX) return false;
+    *id = (uint16_t)v;
+    *campos = fim + 1;
+    *chave = ((uint32_t)*id << 16) | crc16((const uint8_t *)*campos, strlen(*campos));
+    return true;
+}
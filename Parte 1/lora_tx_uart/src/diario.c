@@ -0,0 +1,337 @@
+#include "../inc/diario.h"
+#include <stddef.h>
+#include <string.h>
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+#define DIARIO_OFFSET           (PICO_FLASH_SIZE_BYTES - DIARIO_SETORES * DIARIO_SETOR_BYTES)
+
+// Espera máxima para o outro core sair da flash
+#define DIARIO_FLASH_TIMEOUT_MS 100
+
+_Static_assert(sizeof(diario_registro_t) == DIARIO_REGISTRO_BYTES, "registro do diario deve ter 32 bytes");
+_Static_assert(DIARIO_SETOR_BYTES == FLASH_SECTOR_SIZE && DIARIO_PAGINA_BYTES == FLASH_PAGE_SIZE,
+               "geometria do diario difere da flash");
+
+// ---------------------------------------------------------------------
+// Acesso à flash
+// ---------------------------------------------------------------------
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *dados;
+} diario_op_t;
+
+// Rodam com as interrupções desligadas e o outro core parado
+static void op_apagar(void *p) {
+    const diario_op_t *op = p;
+    flash_range_erase(op->offset, DIARIO_SETOR_BYTES);
+}
+
+static void op_programar(void *p) {
+    const diario_op_t *op = p;
+    flash_range_program(op->offset, op->dados, DIARIO_PAGINA_BYTES);
+}
+
+// false se o outro core não liberou a flash a tempo: nada foi feito
+static bool flash_apagar(diario_t *d, uint32_t setor) {
+    diario_op_t op = { d->base + setor * DIARIO_SETOR_BYTES, NULL };
+    if (flash_safe_execute(op_apagar, &op, DIARIO_FLASH_TIMEOUT_MS) != PICO_OK) {
+        d->stats.falhas++;
+        return false;
+    }
+    d->stats.apagamentos++;
+    return true;
+}
+
+// 'slot' é o primeiro slot da página
+static bool flash_programar(diario_t *d, uint32_t slot, const uint8_t *pagina) {
+    diario_op_t op = { d->base + slot * DIARIO_REGISTRO_BYTES, pagina };
+    if (flash_safe_execute(op_programar, &op, DIARIO_FLASH_TIMEOUT_MS) != PICO_OK) {
+        d->stats.falhas++;
+        return false;
+    }
+    d->stats.programacoes++;
+    return true;
+}
+
+static const diario_registro_t *registro_flash(const diario_t *d, uint32_t slot) {
+    return (const diario_registro_t *)(uintptr_t)(XIP_BASE + d->base + slot * DIARIO_REGISTRO_BYTES);
+}
+
+static bool setor_em_branco(const diario_t *d, uint32_t setor) {
+    const uint32_t *p = (const uint32_t *)(uintptr_t)(XIP_BASE + d->base + setor * DIARIO_SETOR_BYTES);
+    for (uint32_t i = 0; i < DIARIO_SETOR_BYTES / 4; ++i) {
+        if (p[i] != 0xFFFFFFFF) return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// Registros
+// ---------------------------------------------------------------------
+
+// CRC-8, polinômio 0x31 (o mesmo do AHT20)
+static uint8_t crc8(const uint8_t *p, size_t n, uint8_t crc) {
+    while (n--) {
+        crc ^= *p++;
+        for (uint8_t b = 0; b < 8; ++b) crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+static uint8_t registro_crc(const diario_registro_t *r) {
+    uint8_t crc = crc8((const uint8_t *)&r->seq, sizeof(r->seq), 0xFF);
+    crc = crc8(&r->len, 1, crc);
+    return crc8(r->dados, r->len, crc);
+}
+
+static bool registro_valido(const diario_registro_t *r) {
+    if (r->seq == 0xFFFFFFFF || r->len > DIARIO_DADOS_MAX) return false;
+    return registro_crc(r) == r->crc;
+}
+
+// Distância de um slot até a cabeça, para trás. O slot da própria cabeça
+// é o mais antigo (uma volta inteira)
+static uint32_t atras(const diario_t *d, uint32_t slot) {
+    uint32_t a = (d->cabeca + DIARIO_SLOTS - slot) % DIARIO_SLOTS;
+    return a ? a : DIARIO_SLOTS;
+}
+
+static uint32_t slot_de(const diario_t *d, uint32_t seq) {
+    return (d->cabeca + DIARIO_SLOTS - (d->proximo_seq - seq) % DIARIO_SLOTS) % DIARIO_SLOTS;
+}
+
+// Buffer de RAM que contém a página do slot, se houver
+static uint8_t *pagina_ram(diario_t *d, uint32_t slot) {
+    uint32_t inicio = slot - slot % DIARIO_POR_PAGINA;
+    if (d->pagina_slot[d->atual] == inicio) return d->pagina[d->atual];
+    uint8_t outra = d->atual ^ 1;
+    if (d->pagina_cheia[outra] && d->pagina_slot[outra] == inicio) return d->pagina[outra];
+    return NULL;
+}
+
+// ---------------------------------------------------------------------
+// Setores e páginas
+// ---------------------------------------------------------------------
+
+// O setor vai ser apagado: os registros dele ainda sem confirmação são
+// perdidos. O setor inteiro está atrás da cabeça (a cabeça, no máximo,
+// está no primeiro slot dele)
+static void descartar(diario_t *d, uint32_t setor) {
+    uint32_t a = atras(d, setor * DIARIO_POR_SETOR + DIARIO_POR_SETOR - 1);
+    if (a >= d->proximo_seq) return;
+    uint32_t seq_max = d->proximo_seq - a;
+    if (seq_max >= d->cauda_seq) {
+        d->stats.perdidos += seq_max + 1 - d->cauda_seq;
+        d->cauda_seq = seq_max + 1;
+    }
+    if (seq_max >= d->marcar_seq) d->marcar_seq = seq_max + 1;
+}
+
+static bool preparar_setor(diario_t *d, uint32_t setor) {
+    descartar(d, setor);
+    return setor_em_branco(d, setor) || flash_apagar(d, setor);
+}
+
+// Em falha o buffer continua sujo (ou cheio) e o serviço tenta de novo
+static bool programar_buffer(diario_t *d, uint8_t i) {
+    if (!flash_programar(d, d->pagina_slot[i], d->pagina[i])) {
+        if (i == d->atual) d->atual_sujo = true;
+        return false;
+    }
+    if (i == d->atual) d->atual_sujo = false;
+    else d->pagina_cheia[i] = false;
+    return true;
+}
+
+// A cabeça chegou ao fim da página do buffer atual
+static void virar_pagina(diario_t *d) {
+    uint8_t outra = d->atual ^ 1;
+    // O serviço ficou para trás: a página anterior vai para a flash agora.
+    // Se a flash recusar, o buffer é reaproveitado mesmo assim e os
+    // registros dele ficam ilegíveis (o reenvio os pula)
+    if (d->pagina_cheia[outra]) {
+        if (!programar_buffer(d, outra)) d->pagina_cheia[outra] = false;
+        d->stats.esperas++;
+    }
+    d->pagina_cheia[d->atual] = d->atual_sujo;
+    d->atual = outra;
+    memset(d->pagina[outra], 0xFF, DIARIO_PAGINA_BYTES);
+    d->pagina_slot[outra] = d->cabeca;
+    d->atual_sujo = false;
+
+    // Setor novo: normalmente o serviço já o apagou à frente. Sem o
+    // apagamento as páginas gravadas sobre os restos falham no CRC
+    if (d->cabeca % DIARIO_POR_SETOR == 0) {
+        uint32_t setor = d->cabeca / DIARIO_POR_SETOR;
+        if (d->setor_pronto != (int32_t)setor) {
+            preparar_setor(d, setor);
+            d->stats.esperas++;
+        }
+        d->setor_pronto = -1;
+    }
+}
+
+// Marca na flash as confirmações de uma página; false se não havia nenhuma
+static bool marcar_confirmacoes(diario_t *d) {
+    uint8_t imagem[DIARIO_PAGINA_BYTES];
+    while (d->marcar_seq < d->cauda_seq) {
+        uint32_t slot = slot_de(d, d->marcar_seq);
+        // Páginas em RAM levam a marca junto quando forem programadas
+        if (pagina_ram(d, slot)) {
+            d->marcar_seq++;
+            continue;
+        }
+
+        // Programar 0xFF não altera a flash: só os bytes 'pendente' mudam
+        uint32_t pagina = slot / DIARIO_POR_PAGINA, inicio = d->marcar_seq;
+        bool alguma = false;
+        memset(imagem, 0xFF, sizeof(imagem));
+        while (d->marcar_seq < d->cauda_seq && (slot = slot_de(d, d->marcar_seq)) / DIARIO_POR_PAGINA == pagina) {
+            const diario_registro_t *r = registro_flash(d, slot);
+            if (registro_valido(r) && r->pendente != 0) {
+                imagem[(slot % DIARIO_POR_PAGINA) * DIARIO_REGISTRO_BYTES + offsetof(diario_registro_t, pendente)] = 0;
+                alguma = true;
+            }
+            d->marcar_seq++;
+        }
+        if (alguma) {
+            // Em falha as marcas da página ficam para o próximo serviço
+            if (!flash_programar(d, pagina * DIARIO_POR_PAGINA, imagem)) d->marcar_seq = inicio;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------
+
+void diario_init(diario_t *d) {
+    memset(d, 0, sizeof(*d));
+    d->base = DIARIO_OFFSET;
+    d->setor_pronto = -1;
+
+    // Registro válido mais recente, o primeiro e o último com dados e a
+    // última confirmação
+    bool achou = false;
+    uint32_t max_seq = 0, max_slot = 0, min_dados = 0, max_dados = 0, confirmado = 0;
+    for (uint32_t slot = 0; slot < DIARIO_SLOTS; ++slot) {
+        const diario_registro_t *r = registro_flash(d, slot);
+        if (!registro_valido(r)) continue;
+        if (!achou || r->seq > max_seq) {
+            max_seq = r->seq;
+            max_slot = slot;
+        }
+        if (r->len > 0 && (min_dados == 0 || r->seq < min_dados)) min_dados = r->seq;
+        if (r->len > 0 && r->seq > max_dados) max_dados = r->seq;
+        if (r->pendente == 0 && r->seq > confirmado) confirmado = r->seq;
+        achou = true;
+    }
+
+    d->proximo_seq = achou ? max_seq + 1 : 1;
+    d->cabeca = achou ? (max_slot + 1) % DIARIO_SLOTS : 0;
+
+    // Recomeça depois dos dois buffers de página, no início de um setor:
+    // registros que estavam só na RAM podem ter sido transmitidos e o seq
+    // deles não se repete; restos de uma programação interrompida ficam
+    // para trás
+    uint32_t salto = d->cabeca + DIARIO_SALTO_BOOT;
+    salto += (DIARIO_POR_SETOR - salto % DIARIO_POR_SETOR) % DIARIO_POR_SETOR;
+    d->proximo_seq += salto - d->cabeca;
+    d->cabeca = salto % DIARIO_SLOTS;
+
+    // Confirmações são cumulativas; sem pendências a cauda pula o salto
+    d->cauda_seq = d->proximo_seq;
+    if (confirmado < max_dados) d->cauda_seq = confirmado + 1 > min_dados ? confirmado + 1 : min_dados;
+
+    memset(d->pagina, 0xFF, sizeof(d->pagina));
+    d->pagina_slot[0] = d->cabeca;
+    d->pagina_slot[1] = DIARIO_SLOTS;
+    preparar_setor(d, d->cabeca / DIARIO_POR_SETOR);
+
+    // Marco sem dados no início do salto, já na flash: sem ele um segundo
+    // reboot antes da primeira página programada voltaria ao mesmo seq
+    diario_registro_t marco;
+    memset(&marco, 0xFF, sizeof(marco));
+    marco.seq = d->proximo_seq++;
+    marco.len = 0;
+    marco.crc = registro_crc(&marco);
+    memcpy(d->pagina[0], &marco, sizeof(marco));
+    d->cabeca++;
+    programar_buffer(d, 0);
+    if (d->cauda_seq == marco.seq) d->cauda_seq++;
+    d->marcar_seq = d->cauda_seq;
+}
+
+uint32_t diario_gravar(diario_t *d, const void *dados, uint8_t len, uint32_t agora_ms) {
+    if (len > DIARIO_DADOS_MAX) return 0;
+
+    diario_registro_t r;
+    memset(&r, 0xFF, sizeof(r));
+    r.seq = d->proximo_seq++;
+    r.len = len;
+    memcpy(r.dados, dados, len);
+    r.crc = registro_crc(&r);
+
+    memcpy(d->pagina[d->atual] + (d->cabeca % DIARIO_POR_PAGINA) * DIARIO_REGISTRO_BYTES, &r, sizeof(r));
+    if (!d->atual_sujo) d->sujo_desde_ms = agora_ms;
+    d->atual_sujo = true;
+    d->stats.gravados++;
+
+    d->cabeca = (d->cabeca + 1) % DIARIO_SLOTS;
+    if (d->cabeca % DIARIO_POR_PAGINA == 0) virar_pagina(d);
+    return r.seq;
+}
+
+void diario_confirmar(diario_t *d, uint32_t seq) {
+    if (seq < d->cauda_seq || seq >= d->proximo_seq) return;
+
+    // Registros ainda em RAM: a marca vai junto com a página
+    for (uint32_t s = d->cauda_seq; s <= seq; ++s) {
+        uint32_t slot = slot_de(d, s);
+        uint8_t *pagina = pagina_ram(d, slot);
+        if (!pagina) continue;
+        pagina[(slot % DIARIO_POR_PAGINA) * DIARIO_REGISTRO_BYTES + offsetof(diario_registro_t, pendente)] = 0;
+        // Página atual já gravada: a marca vai para a flash no próximo serviço
+        if (pagina == d->pagina[d->atual] && !d->atual_sujo) {
+            d->atual_sujo = true;
+            d->sujo_desde_ms = 0;
+        }
+    }
+    d->stats.confirmados += seq + 1 - d->cauda_seq;
+    d->cauda_seq = seq + 1;
+}
+
+bool diario_ler(const diario_t *d, uint32_t seq, diario_registro_t *r) {
+    uint32_t distancia = d->proximo_seq - seq;
+    if (seq == 0 || distancia == 0 || distancia > DIARIO_SLOTS) return false;
+
+    uint32_t slot = slot_de(d, seq);
+    const uint8_t *pagina = pagina_ram((diario_t *)d, slot);
+    if (pagina) memcpy(r, pagina + (slot % DIARIO_POR_PAGINA) * DIARIO_REGISTRO_BYTES, sizeof(*r));
+    else memcpy(r, registro_flash(d, slot), sizeof(*r));
+    // Marcos de reboot não têm o que reenviar
+    return registro_valido(r) && r->seq == seq && r->len > 0;
+}
+
+bool diario_servico(diario_t *d, uint32_t agora_ms) {
+    uint8_t outra = d->atual ^ 1;
+    if (d->pagina_cheia[outra]) {
+        programar_buffer(d, outra);
+        return true;
+    }
+    if (d->setor_pronto < 0) {
+        uint32_t setor = (d->cabeca / DIARIO_POR_SETOR + 1) % DIARIO_SETORES;
+        if (preparar_setor(d, setor)) d->setor_pronto = setor;
+        return true;
+    }
+    if (marcar_confirmacoes(d)) return true;
+    if (d->atual_sujo && agora_ms - d->sujo_desde_ms >= DIARIO_ATRASO_MS) {
+        programar_buffer(d, d->atual);
+        return true;
+    }
+    return false;
+}
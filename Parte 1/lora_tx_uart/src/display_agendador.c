@@ -0,0 +1,87 @@
+#include "../inc/display_agendador.h"
+#include "pico/multicore.h"
+#include "pico/critical_section.h"
+#include "pico/flash.h"
+#include <string.h>
+
+static ssd1306_t *display;
+static display_render_fn render;
+static size_t tamanho;
+static uint32_t periodo_ms;
+static bool usar_dma;
+
+// Estado compartilhado entre os cores, protegido por 'trava'
+static critical_section_t trava;
+static uint8_t publicado[DISPLAY_ESTADO_MAX];
+static bool novo;
+static display_agendador_stats_t stats;
+
+static void display_core1(void) {
+    static uint8_t local[DISPLAY_ESTADO_MAX];
+    bool envio_pendente = false;
+
+    // Gravações do core 0 na flash (o diário do nó) param este core
+    // enquanto duram
+    flash_safe_execute_core_init();
+
+    if (usar_dma) ssd1306_init_dma(display);
+
+    absolute_time_t proximo = get_absolute_time();
+    while (true) {
+        critical_section_enter_blocking(&trava);
+        bool tem_novo = novo;
+        if (tem_novo) {
+            memcpy(local, publicado, tamanho);
+            novo = false;
+        }
+        critical_section_exit(&trava);
+
+        if (tem_novo && render(display, local)) {
+            stats.quadros++;
+            envio_pendente = true;
+        }
+
+        // Com os dois buffers de DMA ocupados o envio fica para o próximo quadro
+        if (envio_pendente) {
+            if (usar_dma) {
+                envio_pendente = !ssd1306_send_data_async(display);
+            } else {
+                ssd1306_send_data(display);
+                envio_pendente = false;
+            }
+            if (!envio_pendente) stats.envios++;
+        }
+
+        // Atrasado (envio bloqueante longo): retoma a cadência a partir de agora
+        proximo = delayed_by_ms(proximo, periodo_ms);
+        if (time_reached(proximo)) proximo = delayed_by_ms(get_absolute_time(), periodo_ms);
+        sleep_until(proximo);
+    }
+}
+
+void display_agendador_iniciar(ssd1306_t *ssd, display_render_fn fn, size_t tam,
+                               uint32_t periodo, bool dma) {
+    display = ssd;
+    render = fn;
+    tamanho = tam <= DISPLAY_ESTADO_MAX ? tam : DISPLAY_ESTADO_MAX;
+    periodo_ms = periodo;
+    usar_dma = dma;
+    novo = false;
+    memset(&stats, 0, sizeof(stats));
+    critical_section_init(&trava);
+    multicore_launch_core1(display_core1);
+}
+
+void display_agendador_publicar(const void *estado) {
+    critical_section_enter_blocking(&trava);
+    memcpy(publicado, estado, tamanho);
+    novo = true;
+    stats.publicacoes++;
+    critical_section_exit(&trava);
+}
+
+void display_agendador_stats(display_agendador_stats_t *s) {
+    critical_section_enter_blocking(&trava);
+    *s = stats;
+    critical_section_exit(&trava);
+}
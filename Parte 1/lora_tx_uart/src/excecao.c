@@ -0,0 +1,63 @@
+#include "../inc/excecao.h"
+#include <string.h>
+
+void excecao_init(excecao_t *e, uint8_t n, const int32_t *bandas,
+                  uint32_t silencio_max_ms, uint32_t intervalo_min_ms) {
+    memset(e, 0, sizeof(*e));
+    e->n = n > EXCECAO_MAX ? EXCECAO_MAX : n;
+    memcpy(e->banda, bandas, e->n * sizeof(int32_t));
+    e->silencio_max_ms = silencio_max_ms;
+    e->intervalo_min_ms = intervalo_min_ms;
+}
+
+void excecao_reiniciar(excecao_t *e) {
+    e->enviou = false;
+}
+
+void excecao_registrar(excecao_t *e, const int32_t *valores, bool valida, uint32_t agora_ms) {
+    if (valida) memcpy(e->enviado, valores, e->n * sizeof(int32_t));
+    e->enviado_valido = valida;
+    e->enviou = true;
+    e->t_envio_ms = agora_ms;
+}
+
+static bool excecao_mudou(const excecao_t *e, const int32_t *valores, bool valida) {
+    if (valida != e->enviado_valido) return true;
+    if (!valida) return false;
+    for (uint8_t i = 0; i < e->n; ++i) {
+        int32_t d = valores[i] - e->enviado[i];
+        if (d < 0) d = -d;
+        if (d >= e->banda[i]) return true;
+    }
+    return false;
+}
+
+excecao_motivo_t excecao_avaliar(excecao_t *e, const int32_t *valores, bool valida, uint32_t agora_ms) {
+    excecao_motivo_t motivo;
+    e->avaliadas++;
+
+    if (!e->enviou) {
+        motivo = EXCECAO_PRIMEIRA;
+    } else {
+        // Diferença sem sinal: continua certa na volta do contador
+        uint32_t desde = agora_ms - e->t_envio_ms;
+        bool mudou = excecao_mudou(e, valores, valida);
+
+        if (desde >= e->silencio_max_ms) {
+            motivo = mudou ? EXCECAO_MUDANCA : EXCECAO_SILENCIO;
+        } else if (!mudou) {
+            return EXCECAO_SUPRIMIDA;
+        } else if (desde < e->intervalo_min_ms) {
+            e->limitadas++;
+            return EXCECAO_LIMITADA;
+        } else {
+            motivo = EXCECAO_MUDANCA;
+        }
+    }
+
+    if (motivo == EXCECAO_MUDANCA) e->por_mudanca++;
+    else if (motivo == EXCECAO_SILENCIO) e->por_silencio++;
+    e->enviadas++;
+    excecao_registrar(e, valores, valida, agora_ms);
+    return motivo;
+}
@@ -0,0 +1,310 @@
+#include "../inc/historico.h"
+#include "../inc/diario.h"
+#include <stdio.h>
+#include <string.h>
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+// Logo antes da região do diário
+#define HISTORICO_OFFSET (PICO_FLASH_SIZE_BYTES - DIARIO_SETORES * DIARIO_SETOR_BYTES \
+                          - HISTORICO_SETORES * HISTORICO_SETOR_BYTES)
+
+// Espera máxima para o outro core sair da flash
+#define HISTORICO_FLASH_TIMEOUT_MS 100
+
+_Static_assert(HISTORICO_SETOR_BYTES == FLASH_SECTOR_SIZE && SERIE_BLOCO_BYTES == FLASH_PAGE_SIZE,
+               "geometria do historico difere da flash");
+
+// ---------------------------------------------------------------------
+// Acesso à flash
+// ---------------------------------------------------------------------
+
+typedef struct {
+    uint32_t offset;
+    const uint8_t *dados;
+} historico_op_t;
+
+// Rodam com as interrupções desligadas e o outro core parado
+static void op_apagar(void *p) {
+    const historico_op_t *op = p;
+    flash_range_erase(op->offset, HISTORICO_SETOR_BYTES);
+}
+
+static void op_programar(void *p) {
+    const historico_op_t *op = p;
+    flash_range_program(op->offset, op->dados, SERIE_BLOCO_BYTES);
+}
+
+// false se o outro core não liberou a flash a tempo: nada foi feito
+static bool flash_apagar(historico_t *h, uint32_t setor) {
+    historico_op_t op = { h->base + setor * HISTORICO_SETOR_BYTES, NULL };
+    if (flash_safe_execute(op_apagar, &op, HISTORICO_FLASH_TIMEOUT_MS) != PICO_OK) {
+        h->stats.falhas++;
+        return false;
+    }
+    h->stats.apagamentos++;
+    return true;
+}
+
+static bool flash_programar(historico_t *h, uint32_t bloco, const uint8_t *dados) {
+    historico_op_t op = { h->base + bloco * SERIE_BLOCO_BYTES, dados };
+    if (flash_safe_execute(op_programar, &op, HISTORICO_FLASH_TIMEOUT_MS) != PICO_OK) {
+        h->stats.falhas++;
+        return false;
+    }
+    h->stats.programacoes++;
+    return true;
+}
+
+static const uint8_t *bloco_flash(const historico_t *h, uint32_t bloco) {
+    return (const uint8_t *)(uintptr_t)(XIP_BASE + h->base + bloco * SERIE_BLOCO_BYTES);
+}
+
+static bool em_branco(const uint8_t *p, uint32_t bytes) {
+    const uint32_t *w = (const uint32_t *)p;
+    for (uint32_t i = 0; i < bytes / 4; ++i) {
+        if (w[i] != 0xFFFFFFFF) return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------
+// Blocos e setores
+// ---------------------------------------------------------------------
+
+// Buffer de RAM com o bloco, se houver; senão a flash
+static const uint8_t *bloco_dados(const historico_t *h, uint32_t bloco) {
+    if (h->bloco_num[h->atual] == bloco) return h->bloco[h->atual];
+    uint8_t outra = h->atual ^ 1;
+    if (h->bloco_cheio[outra] && h->bloco_num[outra] == bloco) return h->bloco[outra];
+    return bloco_flash(h, bloco);
+}
+
+// O bloco em montagem ainda não tem CRC
+static bool bloco_legivel(const historico_t *h, const uint8_t *p) {
+    if (p == h->bloco[h->atual]) return serie_cabecalho(p)->n > 0;
+    return serie_bloco_valido(p);
+}
+
+// O conteúdo antigo do setor sai do índice mesmo se o apagamento falhar
+static bool preparar_setor(historico_t *h, uint32_t setor) {
+    h->indice[setor] = HISTORICO_VAZIO;
+    return em_branco(bloco_flash(h, setor * HISTORICO_POR_SETOR), HISTORICO_SETOR_BYTES) || flash_apagar(h, setor);
+}
+
+// Em falha o bloco continua cheio e o serviço tenta de novo
+static bool programar_buffer(historico_t *h, uint8_t i) {
+    if (!flash_programar(h, h->bloco_num[i], h->bloco[i])) return false;
+    h->bloco_cheio[i] = false;
+    return true;
+}
+
+// Fecha o bloco atual e começa o próximo, com 'grandezas' valores por
+// amostra
+static void fechar_bloco(historico_t *h, uint8_t grandezas) {
+    serie_fechar(&h->cod);
+    h->stats.blocos++;
+
+    uint8_t outra = h->atual ^ 1;
+    // O serviço ficou para trás: o bloco anterior vai para a flash agora.
+    // Se a flash recusar, o buffer é reaproveitado e o bloco se perde (as
+    // consultas pulam o bloco em branco)
+    if (h->bloco_cheio[outra]) {
+        if (!programar_buffer(h, outra)) h->bloco_cheio[outra] = false;
+        h->stats.esperas++;
+    }
+    h->bloco_cheio[h->atual] = true;
+    h->atual = outra;
+    h->cabeca = (h->cabeca + 1) % HISTORICO_BLOCOS;
+
+    // Setor novo: normalmente o serviço já o apagou à frente
+    if (h->cabeca % HISTORICO_POR_SETOR == 0) {
+        uint32_t setor = h->cabeca / HISTORICO_POR_SETOR;
+        if (h->setor_pronto != (int32_t)setor) {
+            preparar_setor(h, setor);
+            h->stats.esperas++;
+        }
+        h->setor_pronto = -1;
+    }
+    h->bloco_num[outra] = h->cabeca;
+    serie_iniciar(&h->cod, h->bloco[outra], grandezas);
+}
+
+// ---------------------------------------------------------------------
+// API
+// ---------------------------------------------------------------------
+
+void historico_init(historico_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->base = HISTORICO_OFFSET;
+    h->setor_pronto = -1;
+
+    // Índice com o primeiro bloco válido de cada setor e o bloco mais
+    // recente, que dá a cabeça e o relógio
+    bool achou = false;
+    uint32_t t_max = 0, bloco_max = 0;
+    for (uint32_t setor = 0; setor < HISTORICO_SETORES; ++setor) {
+        h->indice[setor] = HISTORICO_VAZIO;
+        for (uint32_t b = setor * HISTORICO_POR_SETOR; b < (setor + 1) * HISTORICO_POR_SETOR; ++b) {
+            const uint8_t *p = bloco_flash(h, b);
+            if (!serie_bloco_valido(p)) continue;
+            const serie_cabecalho_t *cab = serie_cabecalho(p);
+            if (h->indice[setor] == HISTORICO_VAZIO) h->indice[setor] = cab->t0;
+            if (!achou || cab->t_fim >= t_max) {
+                t_max = cab->t_fim;
+                bloco_max = b;
+            }
+            achou = true;
+        }
+    }
+    h->relogio_s = achou ? t_max + 1 : 0;
+    h->t_ultimo = h->relogio_s;
+
+    // A cabeça segue o bloco mais recente; blocos que não estão em branco
+    // (programação interrompida) ficam para trás
+    h->cabeca = achou ? (bloco_max + 1) % HISTORICO_BLOCOS : 0;
+    while (h->cabeca % HISTORICO_POR_SETOR != 0 && !em_branco(bloco_flash(h, h->cabeca), SERIE_BLOCO_BYTES)) {
+        h->cabeca = (h->cabeca + 1) % HISTORICO_BLOCOS;
+    }
+    if (h->cabeca % HISTORICO_POR_SETOR == 0) preparar_setor(h, h->cabeca / HISTORICO_POR_SETOR);
+
+    h->bloco_num[0] = h->cabeca;
+    h->bloco_num[1] = HISTORICO_BLOCOS;
+    serie_iniciar(&h->cod, h->bloco[0], 0);
+}
+
+void historico_avancar(historico_t *h, uint32_t s) {
+    if (s <= h->relogio_s) return;
+    h->relogio_s = s;
+    if (h->t_ultimo < s) h->t_ultimo = s;
+}
+
+bool historico_gravar(historico_t *h, uint32_t s, const int16_t *valores, uint8_t n) {
+    uint32_t t = historico_instante(h, s);
+    if (n == 0 || t < h->t_ultimo) return false;
+    if (n > SERIE_GRANDEZAS_MAX) n = SERIE_GRANDEZAS_MAX;
+
+    const serie_cabecalho_t *cab = serie_cabecalho(h->bloco[h->atual]);
+    if (cab->grandezas != n) {
+        if (cab->n > 0) fechar_bloco(h, n);
+        else serie_iniciar(&h->cod, h->bloco[h->atual], n);
+    }
+    if (!serie_adicionar(&h->cod, t, valores)) {
+        fechar_bloco(h, n);
+        if (!serie_adicionar(&h->cod, t, valores)) return false;
+    }
+
+    uint32_t setor = h->cabeca / HISTORICO_POR_SETOR;
+    if (h->indice[setor] == HISTORICO_VAZIO) h->indice[setor] = t;
+    h->t_ultimo = t;
+    h->stats.amostras++;
+    return true;
+}
+
+bool historico_servico(historico_t *h) {
+    uint8_t outra = h->atual ^ 1;
+    if (h->bloco_cheio[outra]) {
+        programar_buffer(h, outra);
+        return true;
+    }
+    if (h->setor_pronto < 0) {
+        uint32_t setor = (h->cabeca / HISTORICO_POR_SETOR + 1) % HISTORICO_SETORES;
+        if (preparar_setor(h, setor)) h->setor_pronto = setor;
+        return true;
+    }
+    return false;
+}
+
+bool historico_buscar(const historico_t *h, uint32_t t, historico_cursor_t *c) {
+    // Setores do mais antigo (o seguinte ao da cabeça) ao da cabeça; o
+    // índice tem um valor por setor e crescente nessa ordem
+    uint32_t setor_cabeca = h->cabeca / HISTORICO_POR_SETOR;
+    int32_t primeiro = -1, escolhido = -1;
+    for (uint32_t i = 0; i < HISTORICO_SETORES; ++i) {
+        uint32_t setor = (setor_cabeca + 1 + i) % HISTORICO_SETORES;
+        if (h->indice[setor] == HISTORICO_VAZIO) continue;
+        if (primeiro < 0) primeiro = setor;
+        if (h->indice[setor] > t) break;
+        escolhido = setor;
+    }
+    if (primeiro < 0) return false;
+    if (escolhido < 0) escolhido = primeiro;
+
+    // Último bloco do setor que começa até t (ou o primeiro), só pelos
+    // cabeçalhos: o CRC é conferido ao abrir o bloco e um bloco ilegível
+    // é pulado pelo cursor
+    int32_t bloco = -1;
+    for (uint32_t b = escolhido * HISTORICO_POR_SETOR; b < (uint32_t)(escolhido + 1) * HISTORICO_POR_SETOR; ++b) {
+        uint32_t t0 = serie_cabecalho(bloco_dados(h, b))->t0;
+        if (t0 != 0xFFFFFFFF) {
+            if (bloco >= 0 && t0 > t) break;
+            bloco = b;
+        }
+        if (b == h->cabeca) break;
+    }
+    if (bloco < 0) return false;
+
+    c->bloco = bloco;
+    c->restantes = (h->cabeca + HISTORICO_BLOCOS - bloco) % HISTORICO_BLOCOS + 1;
+    const uint8_t *p = bloco_dados(h, bloco);
+    if (bloco_legivel(h, p)) serie_abrir(&c->leitor, p);
+    else c->leitor.restantes = 0;
+
+    // Decodifica até a primeira amostra em t ou depois, sem consumi-la
+    uint32_t ts;
+    int16_t valores[SERIE_GRANDEZAS_MAX];
+    uint8_t n;
+    for (;;) {
+        historico_cursor_t antes = *c;
+        bool ok = historico_proxima(h, c, &ts, valores, &n);
+        if (!ok || ts >= t) {
+            *c = antes;
+            return ok;
+        }
+    }
+}
+
+bool historico_proxima(const historico_t *h, historico_cursor_t *c, uint32_t *t, int16_t *valores, uint8_t *n) {
+    for (;;) {
+        if (serie_proxima(&c->leitor, t, valores)) {
+            *n = c->leitor.grandezas;
+            return true;
+        }
+        if (c->restantes <= 1) return false;
+
+        // Blocos ilegíveis (gravação interrompida, setor à frente) são pulados
+        c->restantes--;
+        c->bloco = (c->bloco + 1) % HISTORICO_BLOCOS;
+        const uint8_t *p = bloco_dados(h, c->bloco);
+        if (bloco_legivel(h, p)) serie_abrir(&c->leitor, p);
+        else c->leitor.restantes = 0;
+    }
+}
+
+uint8_t historico_formatar(const historico_t *h, uint32_t t, char *buf, size_t len) {
+    historico_cursor_t c;
+    uint32_t ts, anterior = 0;
+    int16_t valores[SERIE_GRANDEZAS_MAX];
+    uint8_t n, amostras = 0;
+    size_t usado = 0;
+    if (len > 0) buf[0] = '\0';
+    if (!historico_buscar(h, t, &c)) return 0;
+
+    // Cada amostra vai inteira ou não vai
+    while (amostras < UINT8_MAX && historico_proxima(h, &c, &ts, valores, &n)) {
+        char item[16 + SERIE_GRANDEZAS_MAX * 7];
+        int m = amostras ? snprintf(item, sizeof(item), " %lu", (unsigned long)(ts - anterior))
+                         : snprintf(item, sizeof(item), "h=%lu", (unsigned long)ts);
+        for (uint8_t i = 0; i < n; ++i) {
+            char sep = i ? ',' : ':';
+            if (valores[i] == SERIE_INVALIDO) m += snprintf(item + m, sizeof(item) - m, "%c-", sep);
+            else m += snprintf(item + m, sizeof(item) - m, "%c%d", sep, valores[i]);
+        }
+        if (usado + m >= len) break;
+        memcpy(buf + usado, item, m + 1);
+        usado += m;
+        anterior = ts;
+        amostras++;
+    }
+    return amostras;
+}
@@ -1,10 +1,18 @@
 #include "../inc/rfm95.h"
+#include "../inc/tempo_no_ar.h"
 #include "pico/stdlib.h"
 #include <string.h>
 
 static spi_inst_t *lora_spi;
 static uint cs_pin, rst_pin, irq_pin;
 static volatile bool message_received = false;
+static volatile uint64_t irq_time_us = 0;
+static uint64_t tx_done_us = 0;
+static rfm95_capture_cb_t capture_cb = NULL;
+static rfm95_profile_t profile;
+static rfm95_stats_t stats;
+static uint8_t own_net_id, own_addr;
+static bool address_filter = false;
 
 // Funções privadas
 static void rfm95_write_register(uint8_t reg, uint8_t val) {
@@ -39,10 +47,20 @@ static void rfm95_read_fifo(uint8_t *data, uint8_t length) {
 }
 
 // Callback de interrupção
+// DIO0 está mapeado para RxDone (RX) ou TxDone (TX); o instante é
+// registrado aqui para não depender do intervalo do laço de polling
 static void rfm95_irq_callback(uint gpio, uint32_t events) {
+    irq_time_us = time_us_64();
     message_received = true;
 }
 
+// Instante da última IRQ, ou o atual se ela não ocorreu
+static uint64_t rfm95_take_irq_time(void) {
+    uint64_t t = message_received ? irq_time_us : time_us_64();
+    message_received = false;
+    return t;
+}
+
 void rfm95_init(spi_inst_t *spi, uint cs, uint rst, uint irq) {
     lora_spi = spi;
     cs_pin = cs;
@@ -113,13 +131,15 @@ void rfm95_config(float freq, int tx_power) {
 
     // Configurar modem (BW=125kHz, CR=4/5, SF=7)
     // Usando as definições do novo rfm95.h
-    rfm95_write_register(REG_MODEM_CONFIG, BANDWIDTH_125K | ERROR_CODING_4_5 | EXPLICIT_MODE); 
-    rfm95_write_register(REG_MODEM_CONFIG2, SPREADING_7 | CRC_ON); 
-    rfm95_write_register(REG_MODEM_CONFIG3, 0x04); // LowDataRateOptimize=off, AGC=on
+    profile.freq_hz = (uint32_t)(freq * 1000000.0);
+    profile.tx_power = (int8_t)tx_power;
+    rfm95_set_modem(BANDWIDTH_125K | ERROR_CODING_4_5 | EXPLICIT_MODE,
+                    SPREADING_7 | CRC_ON,
+                    0x04); // LowDataRateOptimize=off, AGC=on
 
     // Configurar preâmbulo
     rfm95_write_register(REG_PREAMBLE_MSB, 0x00);
-    rfm95_write_register(REG_PREAMBLE_LSB, 0x08);
+    rfm95_write_register(REG_PREAMBLE_LSB, TEMPO_PREAMBULO_SIMBOLOS);
 
     // Configurar endereços base do FIFO
     rfm95_write_register(REG_FIFO_TX_BASE_AD, 0x00);
@@ -129,40 +149,65 @@ void rfm95_config(float freq, int tx_power) {
     rfm95_set_mode_standby();
 }
 
-void rfm95_send_message(const char *msg) {
+void rfm95_set_modem(uint8_t modem_config1, uint8_t modem_config2, uint8_t modem_config3) {
+    rfm95_set_mode_standby();
+    profile.modem_config1 = modem_config1;
+    profile.modem_config2 = modem_config2;
+    profile.modem_config3 = modem_config3;
+    rfm95_write_register(REG_MODEM_CONFIG, modem_config1);
+    rfm95_write_register(REG_MODEM_CONFIG2, modem_config2);
+    rfm95_write_register(REG_MODEM_CONFIG3, modem_config3);
+}
+
+uint32_t rfm95_tempo_no_ar_us(uint8_t length) {
+    return tempo_no_ar_us(&profile, length);
+}
+
+// Transmite cabeçalho (opcional) + dados e aguarda TxDone
+static void rfm95_transmit(const uint8_t *header, uint8_t header_len, const char *msg) {
     rfm95_set_mode_standby();
     
-    uint8_t length = strlen(msg);
-    if (length > PAYLOAD_LENGTH) length = PAYLOAD_LENGTH;
+    size_t length = strlen(msg);
+    if (length > (size_t)(PAYLOAD_LENGTH - header_len)) length = PAYLOAD_LENGTH - header_len;
     
     // Configurar ponteiro do FIFO para base TX
     rfm95_write_register(REG_FIFO_ADDR_PTR, 0x00);
     
-    // Escrever dados no FIFO
-    rfm95_write_fifo((const uint8_t*)msg, length);
+    // Escrever dados no FIFO (o ponteiro avança entre as escritas)
+    if (header_len) rfm95_write_fifo(header, header_len);
+    rfm95_write_fifo((const uint8_t*)msg, (uint8_t)length);
     
     // Configurar tamanho do payload
-    rfm95_write_register(REG_PAYLOAD_LENGTH, length);
+    rfm95_write_register(REG_PAYLOAD_LENGTH, (uint8_t)(header_len + length));
     
     // Configurar DIO0 para TxDone
     rfm95_write_register(REG_DIO_MAPPING_1, 0x40);
     
     // Limpar flags de interrupção
     rfm95_write_register(REG_IRQ_FLAGS, 0xFF);
+    message_received = false;
     
     // Modo TX
     rfm95_set_mode_tx();
     
-    // Aguardar transmissão (timeout de 1 segundo)
+    // Aguardar transmissão: o dobro do tempo no ar e mais 100 ms, de
+    // centenas de ms em SF7/125 kHz a minutos em SF12/7,8 kHz
+    bool done = false;
+    uint32_t limite_us = 2 * rfm95_tempo_no_ar_us((uint8_t)(header_len + length)) + 100000;
     uint32_t start = time_us_32();
-    while ((time_us_32() - start) < 1000000) {
+    while ((time_us_32() - start) < limite_us) {
         uint8_t irq_flags = rfm95_read_register(REG_IRQ_FLAGS);
         if (irq_flags & RFM95_IRQ_TX_DONE) {
+            done = true;
             break;
         }
         sleep_ms(1);
     }
     
+    tx_done_us = rfm95_take_irq_time();
+    if (done) stats.tx_ok++;
+    else stats.tx_timeouts++;
+
     // Limpar flag TxDone
     rfm95_write_register(REG_IRQ_FLAGS, RFM95_IRQ_TX_DONE);
     
@@ -170,42 +215,142 @@ void rfm95_send_message(const char *msg) {
     rfm95_set_mode_standby();
 }
 
+void rfm95_send_message(const char *msg) {
+    rfm95_transmit(NULL, 0, msg);
+}
+
+void rfm95_send_to(uint8_t dst, uint8_t flags, const char *msg) {
+    uint8_t header[RFM95_HEADER_LEN] = { own_net_id, dst, own_addr, flags };
+    rfm95_transmit(header, RFM95_HEADER_LEN, msg);
+}
+
+// Classifica o quadro sinalizado por RxDone e atualiza as estatísticas
+static bool rfm95_check_frame(uint8_t irq_flags, uint8_t length) {
+    if (irq_flags & RFM95_IRQ_PAYLOAD_CRC_ERROR) {
+        stats.crc_errors++;
+        return false;
+    }
+    // Sem cabeçalho válido, ou cabeçalho sem CRC com CRC_ON configurado
+    if (!(irq_flags & RFM95_IRQ_VALID_HEADER) ||
+        ((profile.modem_config2 & CRC_ON) && !(rfm95_read_register(REG_HOP_CHANNEL) & HOP_CHANNEL_CRC_ON_PAYLOAD))) {
+        stats.header_errors++;
+        return false;
+    }
+    // Com o filtro ativo o quadro precisa trazer o cabeçalho de endereçamento
+    uint8_t header_len = address_filter ? RFM95_HEADER_LEN : 0;
+    if (length < header_len) {
+        stats.header_errors++;
+        return false;
+    }
+    if (length == header_len || (size_t)(length - header_len) >= sizeof(((rfm95_packet_t *)0)->message)) {
+        stats.oversize_drops++;
+        return false;
+    }
+    return true;
+}
+
+static bool rfm95_address_match(const uint8_t *header) {
+    return header[0] == own_net_id &&
+           (header[1] == own_addr || header[1] == RFM95_ADDR_BROADCAST);
+}
+
+static void rfm95_count_link(int16_t rssi, int8_t snr) {
+    int rssi_bucket = (rssi + 140) / 10;
+    if (rssi_bucket < 0) rssi_bucket = 0;
+    if (rssi_bucket >= RFM95_RSSI_BUCKETS) rssi_bucket = RFM95_RSSI_BUCKETS - 1;
+    stats.rssi_hist[rssi_bucket]++;
+
+    int snr_bucket = (snr + 20) / 5;
+    if (snr_bucket < 0) snr_bucket = 0;
+    if (snr_bucket >= RFM95_SNR_BUCKETS) snr_bucket = RFM95_SNR_BUCKETS - 1;
+    stats.snr_hist[snr_bucket]++;
+}
+
 bool rfm95_receive_message(rfm95_packet_t *packet) {
     if (!packet) return false;
     
     uint8_t irq_flags = rfm95_read_register(REG_IRQ_FLAGS);
+
+    // RxTimeout só ocorre em RX single, mas é contado se aparecer
+    if (irq_flags & RFM95_IRQ_RX_TIMEOUT) {
+        stats.rx_timeouts++;
+        if (!(irq_flags & RFM95_IRQ_RX_DONE)) {
+            rfm95_write_register(REG_IRQ_FLAGS, RFM95_IRQ_RX_TIMEOUT);
+            return false;
+        }
+    }
     
     if (irq_flags & RFM95_IRQ_RX_DONE) {
         // Obter tamanho do payload recebido
         uint8_t length = rfm95_read_register(REG_RX_NB_BYTES);
-        
-        if (length > 0 && length < 64) {
+        uint8_t buffer[256];
+        uint8_t read = 0;
+        uint64_t rx_done_us = rfm95_take_irq_time();
+        int16_t rssi = rfm95_get_rssi();
+        int8_t snr = rfm95_get_snr();
+
+        bool accept = rfm95_check_frame(irq_flags, length);
+        uint8_t header_len = address_filter ? RFM95_HEADER_LEN : 0;
+
+        if ((capture_cb && length > 0) || accept) {
             // Obter endereço atual do FIFO RX
             uint8_t fifo_addr = rfm95_read_register(REG_FIFO_RX_CURRENT_ADDR);
             rfm95_write_register(REG_FIFO_ADDR_PTR, fifo_addr);
-            
-            // Ler dados do FIFO
-            uint8_t buffer[64];
-            rfm95_read_fifo(buffer, length);
-            
+        }
+
+        // Filtro: lê só o cabeçalho; quadros de outra rede/destino são
+        // descartados sem transferir o restante pelo SPI
+        if (accept && header_len) {
+            rfm95_read_fifo(buffer, header_len);
+            read = header_len;
+            if (!rfm95_address_match(buffer)) {
+                stats.foreign_drops++;
+                accept = false;
+            }
+        }
+
+        // Com captura ativa o quadro é lido inteiro, mesmo os descartados
+        if ((capture_cb && length > 0) || accept) {
+            rfm95_read_fifo(buffer + read, length - read);
+        }
+
+        if (capture_cb && length > 0) {
+            rfm95_frame_t frame = {
+                .data = buffer,
+                .time_us = rx_done_us,
+                .rssi = rssi,
+                .snr = snr,
+                .length = length,
+                .irq_flags = irq_flags,
+            };
+            capture_cb(&frame);
+        }
+        
+        // Limpar flags (o modem segue em RX contínuo)
+        rfm95_write_register(REG_IRQ_FLAGS, 0xFF);
+
+        if (accept) {
             // Copiar para estrutura
-            memcpy(packet->message, buffer, length);
-            packet->message[length] = '\0';
-            packet->length = length;
-            
-            // Obter RSSI e SNR
-            packet->rssi = rfm95_get_rssi();
-            packet->snr = rfm95_get_snr();
+            uint8_t payload_len = length - header_len;
+            memcpy(packet->message, buffer + header_len, payload_len);
+            packet->message[payload_len] = '\0';
+            packet->length = payload_len;
+            packet->addressed = header_len != 0;
+            if (packet->addressed) {
+                packet->header.net_id = buffer[0];
+                packet->header.dst = buffer[1];
+                packet->header.src = buffer[2];
+                packet->header.flags = buffer[3];
+            }
+            packet->timestamp_us = rx_done_us;
+            packet->rssi = rssi;
+            packet->snr = snr;
             packet->valid = true;
-            
-            // Limpar flags
-            rfm95_write_register(REG_IRQ_FLAGS, 0xFF);
-            
+
+            stats.rx_ok++;
+            rfm95_count_link(rssi, snr);
             return true;
         }
-        
-        // Limpar flags se erro
-        rfm95_write_register(REG_IRQ_FLAGS, 0xFF);
     }
     
     return false;
@@ -240,17 +385,47 @@ bool rfm95_available(void) {
 
 int16_t rfm95_get_rssi(void) {
     int16_t rssi = rfm95_read_register(REG_PKT_RSSI_VALUE);
-    
-    // Ajustar para frequência
-    if (915000000 >= 779000000) {
+
+    // Offset da porta usada (datasheet 5.5.5): HF acima de 779 MHz, LF abaixo
+    if (profile.freq_hz >= 779000000) {
         rssi = rssi - 157;
     } else {
         rssi = rssi - 164;
     }
-    
+
     return rssi;
 }
 
 int8_t rfm95_get_snr(void) {
     return (int8_t)rfm95_read_register(REG_PKT_SNR_VALUE) / 4;
 }
+
+void rfm95_set_capture_callback(rfm95_capture_cb_t cb) {
+    capture_cb = cb;
+}
+
+void rfm95_get_profile(rfm95_profile_t *out) {
+    if (out) *out = profile;
+}
+
+uint64_t rfm95_get_tx_done_us(void) {
+    return tx_done_us;
+}
+
+// Chamada do mesmo contexto que envia/recebe; não há acesso concorrente
+void rfm95_get_stats(rfm95_stats_t *out) {
+    if (out) *out = stats;
+}
+
+void rfm95_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void rfm95_set_address(uint8_t net_id, uint8_t addr) {
+    own_net_id = net_id;
+    own_addr = addr;
+}
+
+void rfm95_set_address_filter(bool enabled) {
+    address_filter = enabled;
+}
@@ -1,34 +1,415 @@
-#include "../inc/aht20.h"
+#include "../inc/sensores.h"
+#include "pico/stdlib.h"
 #include <stdio.h>
+#include <string.h>
+
+// Nova consulta de um sensor que ainda estava convertendo
+#define SENSORES_REPOLL_MS 10
+
+// Espera máxima do sensores_ler pela primeira rodada
+#define SENSORES_PRIMEIRA_MS 1000
+
+// Filtro de cada grandeza: mediana das 3 últimas leituras válidas (tira
+// picos isolados) seguida de um IIR de 1a ordem. O estado do IIR guarda
+// o valor com SENSORES_IIR_FRAC bits de fração para não perder resolução.
+#define SENSORES_IIR_FRAC 4
+
+typedef struct {
+    int16_t janela[3];
+    int32_t estado;
+} filtro_t;
+
+// Estado de cada sensor registrado
+typedef struct {
+    const sensor_driver_t *driver;
+    uint8_t primeira;               // Índice da primeira grandeza na amostra
+    bool ativo;                     // Inicializado (ou de volta após reset)
+    bool medindo;                   // Disparado, esperando a coleta
+    bool concluido;                 // Coletado (ou desistido) nesta rodada
+    absolute_time_t prazo;          // Fim previsto da conversão
+    absolute_time_t ausente_ate;    // Próxima tentativa de um sensor ausente
+    uint8_t falhas;                 // Falhas seguidas nesta rodada
+    sensor_qualidade_t qualidade;
+    bool filtro_iniciado;
+    bool janela_valida;             // Alguma leitura válida na janela de decimação
+} sensor_estado_t;
 
 static i2c_inst_t *i2c_usado_sensores = NULL;
-static bool aht20_ok = false;
+static uint sda_sensores, scl_sensores;
+
+static sensor_estado_t sensores[SENSORES_MAX];
+static uint8_t n_sensores = 0;
+static uint8_t ordem[SENSORES_MAX];         // Ordem de disparo
+static uint8_t n_grandezas = 0;
+static filtro_t filtros[SENSORES_GRANDEZAS_MAX];
+static int16_t valores[SENSORES_GRANDEZAS_MAX];
+
+static uint32_t periodo_ms = SENSORES_PERIODO_MS;
+static uint8_t decimacao = SENSORES_DECIMACAO;
+static absolute_time_t proxima_rodada;
+static bool rodada_aberta = false;
+static bool tem_amostra = false;
+static uint32_t rodada_inicio_us = 0;
+static uint32_t latencia_us = 0;
+static uint32_t recuperacoes = 0;
 
-void sensores_init(i2c_inst_t *i2c) {
+// Janela de decimação: rodadas vistas
+static uint8_t na_janela = 0;
+
+// Buffer circular das amostras decimadas, consumidas pelo rádio
+static sensores_amostra_t fila[SENSORES_FILA];
+static uint8_t fila_cabeca = 0;     // Próxima posição a escrever
+static uint8_t fila_total = 0;
+static uint32_t fila_perdidas = 0;
+
+// Texto do campo E= da telemetria para cada qualidade
+static const char *const nome_qualidade[] = {
+    [SENSOR_OK] = "ok",
+    [SENSOR_CRC] = "crc",
+    [SENSOR_SEM_RESPOSTA] = "i2c",
+    [SENSOR_AUSENTE] = "ausente",
+};
+
+void sensores_init(i2c_inst_t *i2c, uint sda, uint scl) {
     i2c_usado_sensores = i2c;
+    sda_sensores = sda;
+    scl_sensores = scl;
+    proxima_rodada = get_absolute_time();
+}
+
+int sensores_registrar(const sensor_driver_t *driver) {
+    if (n_sensores == SENSORES_MAX || n_grandezas + driver->n_grandezas > SENSORES_GRANDEZAS_MAX) {
+        printf("Sem espaço para o sensor %s\n", driver->nome);
+        return -1;
+    }
 
-    // Inicializa o sensor AHT20 e verifica se foi bem-sucedido
-    aht20_ok = aht20_init(i2c_usado_sensores);
-    if (!aht20_ok) {
-        printf("Erro na inicialização do AHT20!\n");
+    uint8_t indice = n_sensores++;
+    sensor_estado_t *s = &sensores[indice];
+    memset(s, 0, sizeof(*s));
+    s->driver = driver;
+    s->primeira = n_grandezas;
+    n_grandezas += driver->n_grandezas;
+
+    // Disparo da conversão mais longa para a mais curta
+    uint8_t i = indice;
+    while (i > 0 && sensores[ordem[i - 1]].driver->conversao_ms < driver->conversao_ms) {
+        ordem[i] = ordem[i - 1];
+        i--;
+    }
+    ordem[i] = indice;
+
+    // Inicializa o sensor e verifica se foi bem-sucedido
+    s->ativo = driver->iniciar(i2c_usado_sensores);
+    s->qualidade = s->ativo ? SENSOR_SEM_RESPOSTA : SENSOR_AUSENTE;
+    if (!s->ativo) {
+        printf("Erro na inicialização do %s!\n", driver->nome);
+        s->ausente_ate = make_timeout_time_ms(SENSORES_AUSENTE_MS);
     }
+    return s->primeira;
 }
 
-void sensores_ler(char *out_str, size_t len) {
-    AHT20_Data dados_aht;
-    
-    // Leitura do AHT20
-    if (aht20_ok) {
-        if (!aht20_read(i2c_usado_sensores, &dados_aht)) {
-            dados_aht.temperature = -1.0f;
-            dados_aht.humidity = -1.0f;
-        }
+void sensores_configurar(uint32_t periodo, uint8_t decimar) {
+    periodo_ms = periodo < SENSORES_PERIODO_MIN_MS ? SENSORES_PERIODO_MIN_MS : periodo;
+    decimacao = decimar ? decimar : 1;
+    na_janela = 0;
+    for (uint8_t i = 0; i < n_sensores; ++i) sensores[i].janela_valida = false;
+}
+
+static void filtro_iniciar(filtro_t *f, int16_t x) {
+    f->janela[0] = f->janela[1] = f->janela[2] = x;
+    f->estado = (int32_t)x << SENSORES_IIR_FRAC;
+}
+
+static int16_t mediana3(int16_t a, int16_t b, int16_t c) {
+    if (a > b) { int16_t t = a; a = b; b = t; }
+    if (b > c) b = c;
+    return a > b ? a : b;
+}
+
+static int16_t filtro_aplicar(filtro_t *f, int16_t x) {
+    f->janela[0] = f->janela[1];
+    f->janela[1] = f->janela[2];
+    f->janela[2] = x;
+    int32_t m = (int32_t)mediana3(f->janela[0], f->janela[1], f->janela[2]) << SENSORES_IIR_FRAC;
+
+    // estado += (m - estado) / 2^SENSORES_IIR_SHIFT
+    f->estado += (m - f->estado) >> SENSORES_IIR_SHIFT;
+    return (int16_t)((f->estado + (1 << (SENSORES_IIR_FRAC - 1))) >> SENSORES_IIR_FRAC);
+}
+
+static void sensores_guardar(sensor_estado_t *s, const int16_t *lidos) {
+    for (uint8_t g = 0; g < s->driver->n_grandezas; ++g) {
+        filtro_t *f = &filtros[s->primeira + g];
+        if (!s->filtro_iniciado) filtro_iniciar(f, lidos[g]);
+        valores[s->primeira + g] = filtro_aplicar(f, lidos[g]);
+    }
+    s->filtro_iniciado = true;
+    s->qualidade = SENSOR_OK;
+    s->janela_valida = true;
+    s->concluido = true;
+}
+
+// Pinos em dreno aberto pelo SIO: saída em 0 puxa a linha, entrada a solta
+static void sensores_linha(uint pino, bool solta) {
+    gpio_set_dir(pino, solta ? GPIO_IN : GPIO_OUT);
+    sleep_us(5);
+}
+
+// Libera o barramento quando um sensor ficou segurando SDA (leitura
+// interrompida no meio): pulsa SCL por GPIO, gera um STOP e devolve os
+// pinos ao I2C
+static void sensores_recuperar_barramento(void) {
+    uint sda = sda_sensores, scl = scl_sensores;
+
+    gpio_init(sda);
+    gpio_init(scl);
+    gpio_pull_up(sda);
+    gpio_pull_up(scl);
+    gpio_put(sda, 0);
+    gpio_put(scl, 0);
+    sleep_us(5);
+
+    // Um escravo interrompido no meio de um byte segura SDA em 0: até 9
+    // pulsos de clock o levam ao fim do byte e ele solta a linha
+    for (int i = 0; i < 9 && !gpio_get(sda); ++i) {
+        sensores_linha(scl, false);
+        sensores_linha(scl, true);
+    }
+
+    // STOP manual: SDA sobe com SCL em 1
+    sensores_linha(scl, false);
+    sensores_linha(sda, false);
+    sensores_linha(scl, true);
+    sensores_linha(sda, true);
+
+    gpio_set_function(sda, GPIO_FUNC_I2C);
+    gpio_set_function(scl, GPIO_FUNC_I2C);
+}
+
+// Registra uma falha do sensor. Até SENSORES_TENTATIVAS a medição é
+// repetida na próxima passada; esgotadas, o barramento é liberado, o
+// sensor é resetado e fica com a qualidade da falha nesta rodada (os
+// valores anteriores ficam, mas não valem)
+static void sensores_falha(sensor_estado_t *s, sensor_qualidade_t qualidade) {
+    s->medindo = false;
+    if (++s->falhas < SENSORES_TENTATIVAS) return;
+
+    recuperacoes++;
+    sensores_recuperar_barramento();
+    s->ativo = s->driver->resetar(i2c_usado_sensores);
+    printf("%s: %d falhas (%s), barramento recuperado, reset %s\n", s->driver->nome,
+           SENSORES_TENTATIVAS, nome_qualidade[qualidade], s->ativo ? "ok" : "falhou");
+
+    s->qualidade = s->ativo ? qualidade : SENSOR_AUSENTE;
+    // Sensor que não volta do reset é procurado com menos frequência
+    if (!s->ativo) s->ausente_ate = make_timeout_time_ms(SENSORES_AUSENTE_MS);
+    // Depois de uma falha o filtro recomeça da próxima leitura válida
+    s->filtro_iniciado = false;
+    s->concluido = true;
+}
+
+static void sensores_disparar(sensor_estado_t *s) {
+    if (s->driver->disparar(i2c_usado_sensores)) {
+        s->medindo = true;
+        s->prazo = make_timeout_time_ms(s->driver->conversao_ms);
     } else {
-        // Se a inicialização falhou, preenche com valores de erro
-        dados_aht.temperature = -1.0f;
-        dados_aht.humidity = -1.0f;
+        sensores_falha(s, s->ativo ? SENSOR_SEM_RESPOSTA : SENSOR_AUSENTE);
+    }
+}
+
+static void sensores_coletar(sensor_estado_t *s) {
+    int16_t lidos[SENSOR_GRANDEZAS_MAX];
+
+    switch (s->driver->coletar(i2c_usado_sensores, lidos)) {
+    case SENSOR_COLETA_OK:
+        s->medindo = false;
+        sensores_guardar(s, lidos);
+        break;
+    case SENSOR_COLETA_OCUPADO:
+        s->prazo = make_timeout_time_ms(SENSORES_REPOLL_MS);
+        break;
+    case SENSOR_COLETA_CRC:
+        sensores_falha(s, SENSOR_CRC);
+        break;
+    default:
+        sensores_falha(s, SENSOR_SEM_RESPOSTA);
+        break;
+    }
+}
+
+// Todos os disparos de uma vez: as conversões correm em paralelo e o
+// barramento só é usado de novo nas coletas
+static void sensores_abrir_rodada(void) {
+    rodada_aberta = true;
+    rodada_inicio_us = time_us_32();
+    proxima_rodada = make_timeout_time_ms(periodo_ms);
+
+    for (uint8_t i = 0; i < n_sensores; ++i) {
+        sensor_estado_t *s = &sensores[ordem[i]];
+        s->concluido = false;
+        s->falhas = 0;
+        if (!s->ativo && !time_reached(s->ausente_ate)) {
+            s->qualidade = SENSOR_AUSENTE;
+            s->concluido = true;
+            continue;
+        }
+        sensores_disparar(s);
     }
-    
-    // Formata a mensagem com os dados de temperatura e umidade
-    snprintf(out_str, len, "T=%.1fC U=%.1f%%", dados_aht.temperature, dados_aht.humidity);
+}
+
+// Fecha a janela de decimação a cada 'decimacao' rodadas e enfileira os
+// valores filtrados com o instante do fim da rodada
+static void sensores_fechar_rodada(void) {
+    rodada_aberta = false;
+    tem_amostra = true;
+    latencia_us = time_us_32() - rodada_inicio_us;
+
+    if (++na_janela < decimacao) return;
+
+    sensores_amostra_t *a = &fila[fila_cabeca];
+    sensores_atual(a);
+    for (uint8_t i = 0; i < n_sensores; ++i) {
+        if (sensores[i].janela_valida) a->qualidade[i] = SENSOR_OK;
+        sensores[i].janela_valida = false;
+    }
+
+    fila_cabeca = (fila_cabeca + 1) % SENSORES_FILA;
+    if (fila_total < SENSORES_FILA) fila_total++;
+    else fila_perdidas++;   // Rádio atrasado: sobrescreve a mais antiga
+
+    na_janela = 0;
+}
+
+bool sensores_servico(void) {
+    if (n_sensores == 0) return false;
+
+    if (!rodada_aberta) {
+        if (!time_reached(proxima_rodada)) return false;
+        sensores_abrir_rodada();
+    }
+
+    // Coleta quem terminou a conversão e dispara de novo quem falhou
+    bool pendente = false;
+    for (uint8_t i = 0; i < n_sensores; ++i) {
+        sensor_estado_t *s = &sensores[ordem[i]];
+        if (s->concluido) continue;
+        if (!s->medindo) sensores_disparar(s);
+        else if (time_reached(s->prazo)) sensores_coletar(s);
+        if (!s->concluido) pendente = true;
+    }
+    if (pendente) return false;
+
+    sensores_fechar_rodada();
+    return true;
+}
+
+// Valor inteiro com 'decimais' casas ("-12.3"), sem o printf de ponto
+// flutuante
+static int sensores_valor_texto(char *dst, size_t len, int16_t valor, uint8_t decimais) {
+    unsigned v = valor < 0 ? -valor : valor;
+    unsigned divisor = 1;
+    for (uint8_t d = 0; d < decimais; ++d) divisor *= 10;
+
+    if (decimais == 0) return snprintf(dst, len, "%s%u", valor < 0 ? "-" : "", v);
+    return snprintf(dst, len, "%s%u.%0*u", valor < 0 ? "-" : "", v / divisor, decimais, v % divisor);
+}
+
+void sensores_formatar_valores(char *out_str, size_t len, const sensor_driver_t *driver, const int16_t *v) {
+    size_t usado = 0;
+    if (len > 0) out_str[0] = '\0';
+
+    for (uint8_t g = 0; g < driver->n_grandezas && usado < len; ++g) {
+        const sensor_grandeza_t *grandeza = &driver->grandezas[g];
+        char numero[12];
+        sensores_valor_texto(numero, sizeof(numero), v[g], grandeza->decimais);
+        int n = snprintf(out_str + usado, len - usado, "%s%s=%s%s", g ? " " : "",
+                         grandeza->rotulo, numero, grandeza->unidade);
+        if (n < 0) break;
+        usado += (size_t)n;
+    }
+}
+
+bool sensores_formatar_amostra(char *out_str, size_t len, const sensores_amostra_t *a) {
+    bool validas = true;
+    size_t usado = 0;
+    if (len > 0) out_str[0] = '\0';
+
+    for (uint8_t i = 0; i < n_sensores && usado + 1 < len; ++i) {
+        const sensor_estado_t *s = &sensores[i];
+        if (i > 0) out_str[usado++] = ' ';
+
+        if (a->qualidade[i] == SENSOR_OK) {
+            sensores_formatar_valores(out_str + usado, len - usado, s->driver, &a->valores[s->primeira]);
+        } else {
+            // Leitura inválida não vira número: só o motivo segue na telemetria
+            snprintf(out_str + usado, len - usado, "E=%s", nome_qualidade[a->qualidade[i]]);
+            validas = false;
+        }
+        usado += strlen(out_str + usado);
+    }
+    return validas;
+}
+
+bool sensores_atual(sensores_amostra_t *a) {
+    bool validas = true;
+    a->t_us = time_us_32();
+    a->n = n_grandezas;
+    memcpy(a->valores, valores, sizeof(a->valores));
+    for (uint8_t i = 0; i < n_sensores; ++i) {
+        a->qualidade[i] = sensores[i].qualidade;
+        if (sensores[i].qualidade != SENSOR_OK) validas = false;
+    }
+    return validas;
+}
+
+bool sensores_ler(char *out_str, size_t len) {
+    // Nenhuma rodada terminou ainda (logo após o boot): espera a primeira
+    absolute_time_t limite = make_timeout_time_ms(SENSORES_PRIMEIRA_MS);
+    while (!tem_amostra && n_sensores > 0 && !time_reached(limite)) {
+        sensores_servico();
+        sleep_ms(1);
+    }
+
+    sensores_amostra_t a;
+    sensores_atual(&a);
+    return sensores_formatar_amostra(out_str, len, &a);
+}
+
+bool sensores_consumir(sensores_amostra_t *a) {
+    if (fila_total == 0) return false;
+    uint8_t i = (fila_cabeca + SENSORES_FILA - fila_total) % SENSORES_FILA;
+    *a = fila[i];
+    fila_total--;
+    return true;
+}
+
+uint32_t sensores_perdidas(void) {
+    return fila_perdidas;
+}
+
+uint8_t sensores_grandezas(void) {
+    return n_grandezas;
+}
+
+bool sensores_valor(uint8_t grandeza, int16_t *valor) {
+    for (uint8_t i = 0; i < n_sensores; ++i) {
+        const sensor_estado_t *s = &sensores[i];
+        if (grandeza >= s->primeira && grandeza < s->primeira + s->driver->n_grandezas) {
+            *valor = valores[grandeza];
+            return s->qualidade == SENSOR_OK;
+        }
+    }
+    return false;
+}
+
+sensor_qualidade_t sensores_qualidade(uint8_t sensor) {
+    return sensor < n_sensores ? sensores[sensor].qualidade : SENSOR_AUSENTE;
+}
+
+uint32_t sensores_recuperacoes(void) {
+    return recuperacoes;
+}
+
+uint32_t sensores_latencia_us(void) {
+    return latencia_us;
 }
@@ -0,0 +1,76 @@
+#include "../inc/sensores_bench.h"
+#include "../inc/aht20.h"
+#include "../inc/sensores.h"
+#include "../inc/ciclos.h"
+#include <stdio.h>
+#include <string.h>
+
+// Passo da varredura dos 2^20 valores brutos (cerca de 10,8 mil amostras)
+#define BENCH_PASSO 97
+
+// A referência em float só entra com o %f do printf ligado; sem ele a
+// medição fica só com o ponto fixo. A equivalência com o %.1f em todos os
+// valores brutos é conferida no host (lora_host/lora_sensores)
+#if !defined(PICO_PRINTF_SUPPORT_FLOAT) || PICO_PRINTF_SUPPORT_FLOAT
+#define BENCH_REF_FLOAT 1
+#else
+#define BENCH_REF_FLOAT 0
+#endif
+
+#if BENCH_REF_FLOAT
+// Caminho anterior em float, mantido como referência
+static void ref_amostra(char *out, size_t len, uint32_t raw_t, uint32_t raw_h) {
+    float humidity = (float)raw_h * 100.0 / 1048576.0;
+    float temperature = ((float)raw_t * 200.0 / 1048576.0) - 50.0;
+    snprintf(out, len, "T=%.1fC U=%.1f%%", temperature, humidity);
+}
+#endif
+
+static void int_amostra(char *out, size_t len, uint32_t raw_t, uint32_t raw_h) {
+    int16_t valores[2] = { aht20_temperature_x10(raw_t), aht20_humidity_x10(raw_h) };
+    sensores_formatar_valores(out, len, &aht20_driver, valores);
+}
+
+void sensores_bench(void) {
+    char novo[32];
+    uint64_t ciclos_int = 0;
+    uint32_t amostras = 0;
+#if BENCH_REF_FLOAT
+    char ref[32];
+    uint64_t ciclos_ref = 0;
+    uint32_t divergentes = 0;
+#endif
+
+    ciclos_iniciar();
+
+    for (uint32_t raw = 0; raw < (1u << 20); raw += BENCH_PASSO) {
+        // Umidade percorre a faixa ao contrário da temperatura
+        uint32_t raw_h = (1u << 20) - 1 - raw;
+
+        uint32_t t0 = ciclos_ler();
+        int_amostra(novo, sizeof(novo), raw, raw_h);
+        ciclos_int += ciclos_desde(t0);
+        amostras++;
+
+#if BENCH_REF_FLOAT
+        t0 = ciclos_ler();
+        ref_amostra(ref, sizeof(ref), raw, raw_h);
+        ciclos_ref += ciclos_desde(t0);
+
+        if (strcmp(ref, novo) != 0) {
+            // Esperado: "-0.0" e empates que o arredondamento para float desloca
+            if (divergentes < 8) printf("  raw %lu: %s | %s\n", (unsigned long)raw, ref, novo);
+            divergentes++;
+        }
+#endif
+    }
+
+    printf("sensores_bench: ciclos por amostra (media de %lu)\n", (unsigned long)amostras);
+#if BENCH_REF_FLOAT
+    printf("  float + %%.1f   %8lu ciclos\n", (unsigned long)(ciclos_ref / amostras));
+#endif
+    printf("  ponto fixo     %8lu ciclos\n", (unsigned long)(ciclos_int / amostras));
+#if BENCH_REF_FLOAT
+    printf("  divergentes    %8lu\n", (unsigned long)divergentes);
+#endif
+}
@@ -0,0 +1,189 @@
+#include "../inc/serie.h"
+#include <stddef.h>
+#include <string.h>
+
+_Static_assert(sizeof(serie_cabecalho_t) == 12, "cabecalho da serie deve ter 12 bytes");
+
+#define CORPO(bloco) ((bloco) + sizeof(serie_cabecalho_t))
+
+// ---------------------------------------------------------------------
+// Bits
+// ---------------------------------------------------------------------
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t dezigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Bits mais significativos primeiro; o corpo começa zerado
+static void escrever(uint8_t *corpo, uint32_t *bit, uint32_t valor, uint8_t k) {
+    while (k > 0) {
+        uint8_t livres = 8 - (*bit & 7);
+        uint8_t n = k < livres ? k : livres;
+        uint8_t pedaco = (valor >> (k - n)) & ((1u << n) - 1);
+        corpo[*bit >> 3] |= pedaco << (livres - n);
+        *bit += n;
+        k -= n;
+    }
+}
+
+static uint32_t ler(serie_leitor_t *l, uint8_t k) {
+    const uint8_t *corpo = CORPO(l->bloco);
+    uint32_t v = 0;
+    while (k > 0) {
+        uint8_t disponiveis = 8 - (l->bit & 7);
+        uint8_t n = k < disponiveis ? k : disponiveis;
+        v = (v << n) | ((corpo[l->bit >> 3] >> (disponiveis - n)) & ((1u << n) - 1));
+        l->bit += n;
+        k -= n;
+    }
+    return v;
+}
+
+// Uns do prefixo da faixa, até 'max'
+static uint8_t prefixo(serie_leitor_t *l, uint8_t max) {
+    uint8_t n = 0;
+    while (n < max && ler(l, 1)) n++;
+    return n;
+}
+
+// ---------------------------------------------------------------------
+// Faixas
+// ---------------------------------------------------------------------
+
+static const uint8_t tempo_bits[] = { 0, 7, 9, 12, 32 };
+static const uint8_t valor_bits[] = { 0, 4, 8, 17 };
+
+// Faixa (comprimento do prefixo) de um número em zigzag
+static uint8_t faixa(uint32_t zz, const uint8_t *bits, uint8_t faixas) {
+    if (zz == 0) return 0;
+    for (uint8_t f = 1; f < faixas - 1; ++f) {
+        if (zz < (1u << bits[f])) return f;
+    }
+    return faixas - 1;
+}
+
+// Prefixo de f uns (terminado em zero, salvo na última faixa) e o número
+static uint8_t custo(uint8_t f, const uint8_t *bits, uint8_t faixas) {
+    return (f < faixas - 1 ? f + 1 : f) + bits[f];
+}
+
+static void escrever_faixa(uint8_t *corpo, uint32_t *bit, uint32_t zz, uint8_t f, const uint8_t *bits, uint8_t faixas) {
+    uint8_t k = f < faixas - 1 ? f + 1 : f;
+    escrever(corpo, bit, (((1u << k) - 1) & ~1u) | (f == faixas - 1), k);
+    if (bits[f]) escrever(corpo, bit, zz, bits[f]);
+}
+
+static uint32_t ler_faixa(serie_leitor_t *l, const uint8_t *bits, uint8_t faixas) {
+    uint8_t f = prefixo(l, faixas - 1);
+    return bits[f] ? ler(l, bits[f]) : 0;
+}
+
+#define TEMPO_FAIXAS (sizeof(tempo_bits) / sizeof(tempo_bits[0]))
+#define VALOR_FAIXAS (sizeof(valor_bits) / sizeof(valor_bits[0]))
+
+// CRC-8, polinômio 0x31 (o mesmo do AHT20 e do diário)
+static uint8_t crc8(const uint8_t *p, size_t n, uint8_t crc) {
+    while (n--) {
+        crc ^= *p++;
+        for (uint8_t b = 0; b < 8; ++b) crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+static uint8_t bloco_crc(const uint8_t *bloco) {
+    uint8_t crc = crc8(bloco, offsetof(serie_cabecalho_t, crc), 0xFF);
+    return crc8(CORPO(bloco), SERIE_BLOCO_BYTES - sizeof(serie_cabecalho_t), crc);
+}
+
+// ---------------------------------------------------------------------
+// Codificador
+// ---------------------------------------------------------------------
+
+void serie_iniciar(serie_codificador_t *c, uint8_t *bloco, uint8_t grandezas) {
+    memset(c, 0, sizeof(*c));
+    c->bloco = bloco;
+    memset(bloco, 0, SERIE_BLOCO_BYTES);
+    serie_cabecalho_t *cab = (serie_cabecalho_t *)bloco;
+    cab->t0 = 0xFFFFFFFF;
+    cab->grandezas = grandezas > SERIE_GRANDEZAS_MAX ? SERIE_GRANDEZAS_MAX : grandezas;
+    cab->crc = 0xFF;
+}
+
+bool serie_adicionar(serie_codificador_t *c, uint32_t t, const int16_t *valores) {
+    serie_cabecalho_t *cab = (serie_cabecalho_t *)c->bloco;
+    bool primeira = cab->n == 0;
+    if (!primeira && t < c->t_ant) return false;
+
+    // Custo da amostra antes de escrever: o bloco só recebe amostras inteiras
+    int32_t delta = primeira ? 0 : (int32_t)(t - c->t_ant);
+    uint32_t zz_t = zigzag(delta - c->delta_ant);
+    uint8_t f_t = faixa(zz_t, tempo_bits, TEMPO_FAIXAS);
+    uint32_t bits = primeira ? 0 : custo(f_t, tempo_bits, TEMPO_FAIXAS);
+    uint32_t zz_v[SERIE_GRANDEZAS_MAX];
+    uint8_t f_v[SERIE_GRANDEZAS_MAX];
+    for (uint8_t i = 0; i < cab->grandezas; ++i) {
+        zz_v[i] = zigzag((int32_t)valores[i] - c->v_ant[i]);
+        f_v[i] = faixa(zz_v[i], valor_bits, VALOR_FAIXAS);
+        bits += custo(f_v[i], valor_bits, VALOR_FAIXAS);
+    }
+    if (c->bits + bits > SERIE_CORPO_BITS || cab->n == UINT16_MAX) return false;
+
+    uint8_t *corpo = CORPO(c->bloco);
+    if (primeira) cab->t0 = t;
+    else escrever_faixa(corpo, &c->bits, zz_t, f_t, tempo_bits, TEMPO_FAIXAS);
+    for (uint8_t i = 0; i < cab->grandezas; ++i) {
+        escrever_faixa(corpo, &c->bits, zz_v[i], f_v[i], valor_bits, VALOR_FAIXAS);
+        c->v_ant[i] = valores[i];
+    }
+    c->delta_ant = delta;
+    c->t_ant = t;
+    cab->t_fim = t;
+    cab->n++;
+    return true;
+}
+
+void serie_fechar(serie_codificador_t *c) {
+    ((serie_cabecalho_t *)c->bloco)->crc = bloco_crc(c->bloco);
+}
+
+bool serie_bloco_valido(const uint8_t *bloco) {
+    const serie_cabecalho_t *cab = serie_cabecalho(bloco);
+    if (cab->t0 == 0xFFFFFFFF || cab->n == 0) return false;
+    if (cab->grandezas == 0 || cab->grandezas > SERIE_GRANDEZAS_MAX) return false;
+    return bloco_crc(bloco) == cab->crc;
+}
+
+// ---------------------------------------------------------------------
+// Leitor
+// ---------------------------------------------------------------------
+
+void serie_abrir(serie_leitor_t *l, const uint8_t *bloco) {
+    const serie_cabecalho_t *cab = serie_cabecalho(bloco);
+    memset(l, 0, sizeof(*l));
+    l->bloco = bloco;
+    l->restantes = cab->t0 == 0xFFFFFFFF ? 0 : cab->n;
+    l->grandezas = cab->grandezas > SERIE_GRANDEZAS_MAX ? SERIE_GRANDEZAS_MAX : cab->grandezas;
+    l->t = cab->t0;
+}
+
+bool serie_proxima(serie_leitor_t *l, uint32_t *t, int16_t *valores) {
+    if (l->restantes == 0) return false;
+
+    // A primeira amostra não tem bits de instante (é o t0) e todo valor
+    // custa ao menos um bit: só ela começa no bit 0
+    if (l->bit > 0) {
+        l->delta += dezigzag(ler_faixa(l, tempo_bits, TEMPO_FAIXAS));
+        l->t += l->delta;
+    }
+    for (uint8_t i = 0; i < l->grandezas; ++i) {
+        l->v[i] = (int16_t)(l->v[i] + dezigzag(ler_faixa(l, valor_bits, VALOR_FAIXAS)));
+        valores[i] = l->v[i];
+    }
+    *t = l->t;
+    l->restantes--;
+    return true;
+}
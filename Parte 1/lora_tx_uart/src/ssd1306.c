@@ -1,47 +1,100 @@
 #include "../inc/ssd1306.h"
 #include "../inc/font.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include <string.h>
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
-  ssd->width = width;
-  ssd->height = height;
-  ssd->pages = height / 8U;
+// Custo fixo de uma janela: controle + 6 comandos, controle de dados e os
+// bytes de endereço das duas transações
+#define SSD1306_WINDOW_OVERHEAD 10
+
+static inline void ssd1306_mark(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+  // dirty_x0/x1 só têm SSD1306_PAGES entradas; o que passa do painel é cortado
+  if (x0 >= SSD1306_WIDTH || p0 >= SSD1306_PAGES || x0 > x1 || p0 > p1) return;
+  if (x1 >= SSD1306_WIDTH) x1 = SSD1306_WIDTH - 1;
+  if (p1 >= SSD1306_PAGES) p1 = SSD1306_PAGES - 1;
+  for (uint8_t p = p0; p <= p1; ++p) {
+    if (x0 < ssd->dirty_x0[p]) ssd->dirty_x0[p] = x0;
+    if (x1 > ssd->dirty_x1[p]) ssd->dirty_x1[p] = x1;
+  }
+}
+
+static void ssd1306_clear_dirty(ssd1306_t *ssd) {
+  memset(ssd->dirty_x0, 0xFF, sizeof(ssd->dirty_x0));
+  memset(ssd->dirty_x1, 0x00, sizeof(ssd->dirty_x1));
+}
+
+// Preenche as linhas y0..y1 de uma coluna com máscaras por página
+static void ssd1306_vspan(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+  if (x >= SSD1306_WIDTH || y0 >= SSD1306_HEIGHT) return;
+  if (y1 >= SSD1306_HEIGHT) y1 = SSD1306_HEIGHT - 1;
+  if (y0 > y1) return;
+
+  uint8_t *col = &ssd->ram_buffer[ssd1306_index(x, 0)];
+  uint8_t p0 = y0 >> 3, p1 = y1 >> 3;
+  ssd1306_mark(ssd, x, x, p0, p1);
+  for (uint8_t p = p0; p <= p1; ++p) {
+    uint8_t mask = 0xFF;
+    if (p == p0) mask &= 0xFF << (y0 & 7);
+    if (p == p1) mask &= 0xFF >> (7 - (y1 & 7));
+    if (value)
+      col[p] |= mask;
+    else
+      col[p] &= ~mask;
+  }
+}
+
+void ssd1306_init(ssd1306_t *ssd, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
   ssd->address = address;
   ssd->i2c_port = i2c;
-  ssd->bufsize = ssd->pages * ssd->width + 1;
-  ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
+  ssd->external_vcc = external_vcc;
+  memset(ssd->ram_buffer, 0, sizeof(ssd->ram_buffer));
   ssd->ram_buffer[0] = 0x40;
+  ssd->tx_buffer[0] = 0x40;
   ssd->port_buffer[0] = 0x80;
+  ssd->bytes_last_frame = 0;
+  ssd->bytes_total = 0;
+  ssd->dma_chan = -1;
+  ssd->dma_pending = -1;
+  ssd->frame_done = true;
+  // A RAM do display é indefinida ao ligar: o primeiro envio é completo
+  ssd1306_invalidate(ssd);
+}
+
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+  ssd1306_mark(ssd, x0, x1, p0, p1);
+}
+
+void ssd1306_invalidate(ssd1306_t *ssd) {
+  ssd1306_clear_dirty(ssd);
+  ssd1306_mark(ssd, 0, SSD1306_WIDTH - 1, 0, SSD1306_PAGES - 1);
 }
 
 void ssd1306_config(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_DISP | 0x00);
-  ssd1306_command(ssd, SET_MEM_ADDR);
-  ssd1306_command(ssd, 0x01);
-  ssd1306_command(ssd, SET_DISP_START_LINE | 0x00);
-  ssd1306_command(ssd, SET_SEG_REMAP | 0x01);
-  ssd1306_command(ssd, SET_MUX_RATIO);
-  ssd1306_command(ssd, HEIGHT - 1);
-  ssd1306_command(ssd, SET_COM_OUT_DIR | 0x08);
-  ssd1306_command(ssd, SET_DISP_OFFSET);
-  ssd1306_command(ssd, 0x00);
-  ssd1306_command(ssd, SET_COM_PIN_CFG);
-  ssd1306_command(ssd, 0x12);
-  ssd1306_command(ssd, SET_DISP_CLK_DIV);
-  ssd1306_command(ssd, 0x80);
-  ssd1306_command(ssd, SET_PRECHARGE);
-  ssd1306_command(ssd, 0xF1);
-  ssd1306_command(ssd, SET_VCOM_DESEL);
-  ssd1306_command(ssd, 0x30);
-  ssd1306_command(ssd, SET_CONTRAST);
-  ssd1306_command(ssd, 0xFF);
-  ssd1306_command(ssd, SET_ENTIRE_ON);
-  ssd1306_command(ssd, SET_NORM_INV);
-  ssd1306_command(ssd, SET_CHARGE_PUMP);
-  ssd1306_command(ssd, 0x14);
-  ssd1306_command(ssd, SET_DISP | 0x01);
+  const uint8_t commands[] = {
+    SET_DISP | 0x00,
+    SET_MEM_ADDR, 0x01,
+    SET_DISP_START_LINE | 0x00,
+    SET_SEG_REMAP | 0x01,
+    SET_MUX_RATIO, HEIGHT - 1,
+    SET_COM_OUT_DIR | 0x08,
+    SET_DISP_OFFSET, 0x00,
+    SET_COM_PIN_CFG, SSD1306_HEIGHT == 64 ? 0x12 : 0x02,
+    SET_DISP_CLK_DIV, 0x80,
+    SET_PRECHARGE, 0xF1,
+    SET_VCOM_DESEL, 0x30,
+    SET_CONTRAST, 0xFF,
+    SET_ENTIRE_ON,
+    SET_NORM_INV,
+    SET_CHARGE_PUMP, 0x14,
+    SET_DISP | 0x01
+  };
+  ssd1306_command_stream(ssd, commands, sizeof(commands));
 }
 
 void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
+  // Escritas bloqueantes reprogramam o I2C: o quadro em voo termina antes
+  ssd1306_wait(ssd);
   ssd->port_buffer[1] = command;
   i2c_write_blocking(
     ssd->i2c_port,
@@ -52,66 +105,258 @@ void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   );
 }
 
+// Vários comandos em uma transação: o controle 0x00 (Co = 0, D/C = 0)
+// vale para todos os bytes seguintes
+void ssd1306_command_stream(ssd1306_t *ssd, const uint8_t *commands, size_t count) {
+  uint8_t buf[SSD1306_STREAM_MAX + 1];
+
+  ssd1306_wait(ssd);
+  buf[0] = 0x00;
+  while (count > 0) {
+    size_t n = count < SSD1306_STREAM_MAX ? count : SSD1306_STREAM_MAX;
+    memcpy(buf + 1, commands, n);
+    i2c_write_blocking(ssd->i2c_port, ssd->address, buf, n + 1, false);
+    commands += n;
+    count -= n;
+  }
+}
+
+void ssd1306_set_contrast(ssd1306_t *ssd, uint8_t contrast) {
+  const uint8_t commands[] = { SET_CONTRAST, contrast };
+  ssd1306_command_stream(ssd, commands, sizeof(commands));
+}
+
+void ssd1306_set_invert(ssd1306_t *ssd, bool invert) {
+  uint8_t command = SET_NORM_INV | (invert ? 0x01 : 0x00);
+  ssd1306_command_stream(ssd, &command, 1);
+}
+
+// Envia as colunas c0..c1 das páginas p0..p1
+static void ssd1306_send_window(ssd1306_t *ssd, uint8_t c0, uint8_t c1, uint8_t p0, uint8_t p1) {
+  const uint8_t window[] = { SET_COL_ADDR, c0, c1, SET_PAGE_ADDR, p0, p1 };
+  ssd1306_command_stream(ssd, window, sizeof(window));
+
+  uint8_t rows = p1 - p0 + 1;
+  size_t len = (size_t)(c1 - c0 + 1) * rows;
+  const uint8_t *src;
+
+  if (rows == SSD1306_PAGES) {
+    // Colunas inteiras já estão contíguas no ram_buffer: o byte anterior
+    // recebe o controle 0x40 durante o envio
+    uint8_t *start = &ssd->ram_buffer[ssd1306_index(c0, 0) - 1];
+    uint8_t saved = *start;
+    *start = 0x40;
+    i2c_write_blocking(ssd->i2c_port, ssd->address, start, len + 1, false);
+    *start = saved;
+  } else {
+    uint8_t *dst = ssd->tx_buffer + 1;
+    for (uint8_t c = c0; c <= c1; ++c) {
+      src = &ssd->ram_buffer[ssd1306_index(c, p0)];
+      for (uint8_t r = 0; r < rows; ++r) *dst++ = src[r];
+    }
+    i2c_write_blocking(ssd->i2c_port, ssd->address, ssd->tx_buffer, len + 1, false);
+  }
+
+  ssd->bytes_last_frame += 1 + sizeof(window) + 1 + len;
+}
+
+typedef void (*ssd1306_window_fn)(ssd1306_t *ssd, uint8_t c0, uint8_t c1, uint8_t p0, uint8_t p1);
+
+// Percorre as janelas sujas: uma envolvendo tudo ou uma por página, o que
+// for menor. Retorna false se não há nada a enviar
+static bool ssd1306_for_each_window(ssd1306_t *ssd, ssd1306_window_fn send) {
+  uint8_t cmin = 0xFF, cmax = 0, pmin = 0xFF, pmax = 0;
+  uint32_t paged_cost = 0;
+
+  ssd->bytes_last_frame = 0;
+  for (uint8_t p = 0; p < SSD1306_PAGES; ++p) {
+    if (ssd->dirty_x0[p] > ssd->dirty_x1[p]) continue;
+    if (ssd->dirty_x0[p] < cmin) cmin = ssd->dirty_x0[p];
+    if (ssd->dirty_x1[p] > cmax) cmax = ssd->dirty_x1[p];
+    if (p < pmin) pmin = p;
+    pmax = p;
+    paged_cost += ssd->dirty_x1[p] - ssd->dirty_x0[p] + 1 + SSD1306_WINDOW_OVERHEAD;
+  }
+  if (pmin == 0xFF) return false;
+
+  uint32_t union_cost = (uint32_t)(cmax - cmin + 1) * (pmax - pmin + 1) + SSD1306_WINDOW_OVERHEAD;
+  if (paged_cost < union_cost) {
+    for (uint8_t p = pmin; p <= pmax; ++p) {
+      if (ssd->dirty_x0[p] <= ssd->dirty_x1[p])
+        send(ssd, ssd->dirty_x0[p], ssd->dirty_x1[p], p, p);
+    }
+  } else {
+    send(ssd, cmin, cmax, pmin, pmax);
+  }
+
+  ssd->bytes_total += ssd->bytes_last_frame;
+  ssd1306_clear_dirty(ssd);
+  return true;
+}
+
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  ssd1306_for_each_window(ssd, ssd1306_send_window);
+}
+
+// ---------------------------------------------------------------------
+// Envio assíncrono: cada janela vira duas transações I2C (o fluxo de
+// comandos de endereçamento e os dados após 0x40) em palavras data_cmd, que o
+// DMA alimenta na FIFO do I2C. O ram_buffer é copiado na montagem, então o
+// próximo quadro pode ser desenhado enquanto o anterior está em voo.
+// ---------------------------------------------------------------------
+
+static ssd1306_t *dma_display;
+
+static void ssd1306_dma_start(ssd1306_t *ssd, uint8_t buf) {
+  // O endereço do escravo já está no TAR (ssd1306_init_dma): desabilitar o
+  // controlador aqui esvaziaria a FIFO, que ainda pode ter o fim da janela
+  // anterior. Só o aborto é limpo
+  (void)i2c_get_hw(ssd->i2c_port)->clr_tx_abrt;
+
+  ssd->frame_done = false;
+  dma_channel_transfer_from_buffer_now(ssd->dma_chan, ssd->dma_words[buf], ssd->dma_len[buf]);
+}
+
+static void ssd1306_dma_irq(void) {
+  ssd1306_t *ssd = dma_display;
+  if (!ssd || !dma_channel_get_irq1_status(ssd->dma_chan)) return;
+  dma_channel_acknowledge_irq1(ssd->dma_chan);
+
+  if (ssd->dma_pending >= 0) {
+    uint8_t buf = ssd->dma_pending;
+    ssd->dma_pending = -1;
+    ssd->dma_fill = buf ^ 1;
+    ssd1306_dma_start(ssd, buf);
+  } else {
+    ssd->frame_done = true;
+  }
+}
+
+static void ssd1306_pack_window(ssd1306_t *ssd, uint8_t c0, uint8_t c1, uint8_t p0, uint8_t p1) {
+  uint8_t buf = ssd->dma_fill;
+  uint16_t *dst = ssd->dma_words[buf] + ssd->dma_len[buf];
+  const uint8_t cmds[6] = { SET_COL_ADDR, c0, c1, SET_PAGE_ADDR, p0, p1 };
+
+  *dst++ = 0x00;
+  for (uint8_t i = 0; i < 6; ++i) *dst++ = cmds[i];
+  dst[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+  *dst++ = 0x40;
+
+  uint8_t rows = p1 - p0 + 1;
+  for (uint8_t c = c0; c <= c1; ++c) {
+    const uint8_t *src = &ssd->ram_buffer[ssd1306_index(c, p0)];
+    for (uint8_t r = 0; r < rows; ++r) *dst++ = src[r];
+  }
+  // STOP no último byte encerra a transação; a próxima janela gera novo START
+  dst[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+  uint16_t words = dst - ssd->dma_words[buf] - ssd->dma_len[buf];
+  ssd->dma_len[buf] += words;
+  ssd->bytes_last_frame += words;
+}
+
+// Reserva o canal e os dois buffers; sem DMA o driver segue bloqueante
+bool ssd1306_init_dma(ssd1306_t *ssd) {
+  int chan = dma_claim_unused_channel(false);
+  if (chan < 0) return false;
+
+  ssd->dma_len[0] = ssd->dma_len[1] = 0;
+
+  // TAR uma vez só, com o I2C parado (o TAR só muda com IC_ENABLE em 0)
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  hw->enable = 0;
+  hw->tar = ssd->address;
+  hw->enable = 1;
+
+  dma_channel_config cfg = dma_channel_get_default_config(chan);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, true);
+  channel_config_set_write_increment(&cfg, false);
+  channel_config_set_dreq(&cfg, i2c_get_dreq(ssd->i2c_port, true));
+  dma_channel_configure(chan, &cfg, &i2c_get_hw(ssd->i2c_port)->data_cmd, NULL, 0, false);
+
+  ssd->dma_chan = chan;
+  ssd->dma_fill = 0;
+  ssd->dma_pending = -1;
+  ssd->frame_done = true;
+  dma_display = ssd;
+
+  dma_channel_set_irq1_enabled(chan, true);
+  irq_add_shared_handler(DMA_IRQ_1, ssd1306_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+  return true;
+}
+
+// Monta o quadro e retorna sem esperar o I2C. Com um quadro em voo e outro
+// já na fila retorna false e mantém as regiões sujas para a próxima chamada
+bool ssd1306_send_data_async(ssd1306_t *ssd) {
+  if (ssd->dma_chan < 0) {
+    ssd1306_send_data(ssd);
+    return true;
+  }
+  if (ssd->dma_pending >= 0) return false;
+
+  uint8_t buf = ssd->dma_fill;
+  ssd->dma_len[buf] = 0;
+  if (!ssd1306_for_each_window(ssd, ssd1306_pack_window)) return true;
+
+  // O IRQ de fim de transferência também consulta dma_pending
+  uint32_t irq = save_and_disable_interrupts();
+  if (dma_channel_is_busy(ssd->dma_chan)) {
+    ssd->dma_pending = buf;
+  } else {
+    ssd->dma_fill = buf ^ 1;
+    ssd1306_dma_start(ssd, buf);
+  }
+  restore_interrupts(irq);
+  return true;
+}
+
+bool ssd1306_busy(ssd1306_t *ssd) {
+  if (ssd->dma_chan < 0) return false;
+  if (!ssd->frame_done || ssd->dma_pending >= 0) return true;
+  // O fim do DMA só garante que os bytes chegaram à FIFO do I2C
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  return !(hw->status & I2C_IC_STATUS_TFE_BITS) || (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS);
+}
+
+void ssd1306_wait(ssd1306_t *ssd) {
+  while (ssd1306_busy(ssd)) tight_loop_contents();
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
-  uint16_t index = (y >> 3) + (x << 3) + 1;
+  if (x >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) return;
+  uint16_t index = ssd1306_index(x, y >> 3);
   uint8_t pixel = (y & 0b111);
+  ssd1306_mark(ssd, x, x, y >> 3, y >> 3);
   if (value)
     ssd->ram_buffer[index] |= (1 << pixel);
   else
     ssd->ram_buffer[index] &= ~(1 << pixel);
 }
 
-/*
 void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
-
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+  // O framebuffer inteiro recebe o mesmo byte (o controle fica em [0])
+  memset(ssd->ram_buffer + 1, value ? 0xFF : 0x00, SSD1306_BUFSIZE - 1);
+  ssd1306_mark(ssd, 0, SSD1306_WIDTH - 1, 0, SSD1306_PAGES - 1);
 }
 
-
-
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
-  }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
-  }
+  if (width == 0 || height == 0) return;
+  uint8_t right = left + width - 1;
+  uint8_t bottom = top + height - 1;
 
   if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
+    // Borda e interior têm o mesmo valor: colunas inteiras com máscara
+    for (uint8_t x = left; x <= right && x < SSD1306_WIDTH; ++x)
+      ssd1306_vspan(ssd, x, top, bottom, value);
+    return;
   }
+
+  ssd1306_hline(ssd, left, right, top, value);
+  ssd1306_hline(ssd, left, right, bottom, value);
+  ssd1306_vspan(ssd, left, top, bottom, value);
+  ssd1306_vspan(ssd, right, top, bottom, value);
 }
 
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
@@ -144,13 +389,24 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 
 
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  if (y >= SSD1306_HEIGHT || x0 >= SSD1306_WIDTH) return;
+  if (x1 >= SSD1306_WIDTH) x1 = SSD1306_WIDTH - 1;
+
+  // Mesmo bit em colunas consecutivas: passo de uma coluna (SSD1306_PAGES
+  // bytes) no buffer
+  uint8_t mask = 1 << (y & 7);
+  uint8_t *p = &ssd->ram_buffer[ssd1306_index(x0, y >> 3)];
+  ssd1306_mark(ssd, x0, x1, y >> 3, y >> 3);
+  for (uint8_t x = x0; x <= x1; ++x, p += SSD1306_PAGES) {
+    if (value)
+      *p |= mask;
+    else
+      *p &= ~mask;
+  }
 }
 
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  ssd1306_vspan(ssd, x, y0, y1, value);
 }
 
 // Função para desenhar um caractere
@@ -169,13 +425,30 @@ void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
     index = 0; // Índice 0 corresponde ao caractere "nada" (espaço)
   }
 
-  // Desenha o caractere na tela
-  for (uint8_t i = 0; i < 8; ++i)
+  if (y >= SSD1306_HEIGHT) return;
+
+  // Cada byte da fonte já é uma coluna no formato de página do SSD1306
+  const uint8_t *glyph = &font[index];
+  uint8_t page = y >> 3;
+  uint8_t shift = y & 7;
+  if (x >= SSD1306_WIDTH) return;
+  uint8_t last = x + 7 < SSD1306_WIDTH ? x + 7 : SSD1306_WIDTH - 1;
+  ssd1306_mark(ssd, x, last, page, (shift && page + 1 < SSD1306_PAGES) ? page + 1 : page);
+
+  for (uint8_t i = 0; i < 8 && x + i < SSD1306_WIDTH; ++i)
   {
-    uint8_t line = font[index + i]; // Acessa a linha correspondente do caractere na fonte
-    for (uint8_t j = 0; j < 8; ++j)
+    uint8_t *col = &ssd->ram_buffer[ssd1306_index(x + i, page)];
+    if (shift == 0)
+    {
+      // Alinhado à página: a coluna é copiada direto
+      col[0] = glyph[i];
+    }
+    else
     {
-      ssd1306_pixel(ssd, x + i, y + j, line & (1 << j)); // Desenha cada pixel do caractere
+      // Desalinhado: a coluna se divide entre duas páginas
+      col[0] = (col[0] & (0xFF >> (8 - shift))) | (glyph[i] << shift);
+      if (page + 1 < SSD1306_PAGES)
+        col[1] = (col[1] & (0xFF << shift)) | (glyph[i] >> (8 - shift));
     }
   }
 }
@@ -187,12 +460,12 @@ void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y)
   {
     ssd1306_draw_char(ssd, *str++, x, y);
     x += 8;
-    if (x + 8 >= ssd->width)
+    if (x + 8 >= SSD1306_WIDTH)
     {
       x = 0;
       y += 8;
     }
-    if (y + 8 >= ssd->height)
+    if (y + 8 >= SSD1306_HEIGHT)
     {
       break;
     }
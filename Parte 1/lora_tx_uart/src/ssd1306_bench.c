@@ -0,0 +1,78 @@
+#include "../inc/ssd1306_bench.h"
+#include "../inc/font.h"
+#include "../inc/ciclos.h"
+#include <stdio.h>
+
+#define BENCH_REPETICOES 16
+
+// Coluna inteira e retângulo de meia altura, centrado no painel
+#define BENCH_RECT_TOPO   (SSD1306_HEIGHT / 4)
+#define BENCH_RECT_ALTURA (SSD1306_HEIGHT / 2)
+
+// Versões pixel a pixel anteriores, mantidas como referência
+static void ref_fill(ssd1306_t *ssd, bool value) {
+  for (uint8_t y = 0; y < SSD1306_HEIGHT; ++y)
+    for (uint8_t x = 0; x < SSD1306_WIDTH; ++x)
+      ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
+  for (uint8_t x = x0; x <= x1; ++x)
+    ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+  for (uint8_t y = y0; y <= y1; ++y)
+    ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_rect_fill(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value) {
+  for (uint8_t x = left; x < left + width; ++x)
+    for (uint8_t y = top; y < top + height; ++y)
+      ssd1306_pixel(ssd, x, y, value);
+}
+
+static void ref_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y) {
+  for (; *str && x + 8 < SSD1306_WIDTH; ++str, x += 8) {
+    char c = *str;
+    uint16_t index = (c >= ' ' && c <= '~') ? (c - ' ') * 8 : 0;
+    for (uint8_t i = 0; i < 8; ++i) {
+      uint8_t line = font[index + i];
+      for (uint8_t j = 0; j < 8; ++j)
+        ssd1306_pixel(ssd, x + i, y + j, line & (1 << j));
+    }
+  }
+}
+
+#define MEDIR(nome_, chamada_) do {                         \
+    uint32_t total = 0;                                     \
+    for (int r = 0; r < BENCH_REPETICOES; ++r) {            \
+      uint32_t t0 = ciclos_ler();                           \
+      chamada_;                                             \
+      total += ciclos_desde(t0);                            \
+    }                                                       \
+    printf("  %-14s %8lu ciclos\n", nome_, (unsigned long)(total / BENCH_REPETICOES)); \
+  } while (0)
+
+void ssd1306_bench(ssd1306_t *ssd) {
+  ciclos_iniciar();
+
+  printf("ssd1306_bench: ciclos por chamada (media de %d)\n", BENCH_REPETICOES);
+  printf(" pixel a pixel:\n");
+  MEDIR("fill", ref_fill(ssd, false));
+  MEDIR("hline 128", ref_hline(ssd, 0, 127, 9, true));
+  MEDIR("vline", ref_vline(ssd, 10, 0, SSD1306_HEIGHT - 1, true));
+  MEDIR("rect", ref_rect_fill(ssd, BENCH_RECT_TOPO, 32, 64, BENCH_RECT_ALTURA, true));
+  MEDIR("string 15 y=8", ref_draw_string(ssd, "LoRa BitDogLab!", 0, 8));
+  MEDIR("string 15 y=12", ref_draw_string(ssd, "LoRa BitDogLab!", 0, 12));
+
+  printf(" por pagina:\n");
+  MEDIR("fill", ssd1306_fill(ssd, false));
+  MEDIR("hline 128", ssd1306_hline(ssd, 0, 127, 9, true));
+  MEDIR("vline", ssd1306_vline(ssd, 10, 0, SSD1306_HEIGHT - 1, true));
+  MEDIR("rect", ssd1306_rect(ssd, BENCH_RECT_TOPO, 32, 64, BENCH_RECT_ALTURA, true, true));
+  MEDIR("string 15 y=8", ssd1306_draw_string(ssd, "LoRa BitDogLab!", 0, 8));
+  MEDIR("string 15 y=12", ssd1306_draw_string(ssd, "LoRa BitDogLab!", 0, 12));
+
+  ssd1306_fill(ssd, false);
+}
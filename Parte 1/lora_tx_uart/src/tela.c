@@ -0,0 +1,75 @@
+#include "../inc/tela.h"
+#include "../inc/widgets.h"
+#include "../inc/grafico.h"
+#include "../inc/display_agendador.h"
+
+// O agendador copia o estado para buffers de DISPLAY_ESTADO_MAX bytes e
+// truncaria o que passar disso
+_Static_assert(sizeof(tela_estado_t) <= DISPLAY_ESTADO_MAX, "estado da tela nao cabe no agendador");
+
+enum {
+    W_TITULO,
+    W_STATUS,
+    W_TX,
+    W_MSG_ROTULO,
+    W_MSG,
+    W_TOTAL
+};
+
+// No painel de 32 linhas ficam o status, o contador e o gráfico da
+// temperatura na última página; a última mensagem e a umidade saem
+#if SSD1306_HEIGHT == 64
+#define TELA_WIDGETS W_TOTAL
+#else
+#define TELA_WIDGETS W_MSG_ROTULO
+#endif
+
+static widget_t widgets[W_TOTAL];
+
+// Histórico de temperatura e umidade na última página
+static serie_t serie_temp, serie_umid;
+static sparkline_t graf_temp;
+#if SSD1306_HEIGHT == 64
+static sparkline_t graf_umid;
+#endif
+static uint32_t amostras;
+
+void tela_init(ssd1306_t *ssd) {
+    widget_rotulo(&widgets[W_TITULO], 0, 0, 16, "LoRa Transceiver");
+    widget_status(&widgets[W_STATUS], 0, 12, 16, 1, "Status: ");
+    serie_init(&serie_temp);
+    serie_init(&serie_umid);
+#if SSD1306_HEIGHT == 64
+    widget_contador(&widgets[W_TX], 0, 20, 16, "TX:");
+    widget_rotulo(&widgets[W_MSG_ROTULO], 0, 28, 16, "Ultima msg:");
+    widget_status(&widgets[W_MSG], 0, 36, 16, 2, NULL);
+    sparkline_init(&graf_temp, &serie_temp, 0, 62, SSD1306_PAGES - 1, 1, 0, 0);
+    sparkline_init(&graf_umid, &serie_umid, 66, 62, SSD1306_PAGES - 1, 1, 0, 0);
+#else
+    widget_contador(&widgets[W_TX], 0, 24, 8, "TX:");
+    sparkline_init(&graf_temp, &serie_temp, 66, 62, SSD1306_PAGES - 1, 1, 0, 0);
+#endif
+    amostras = 0;
+
+    ssd1306_fill(ssd, false);
+    ssd1306_hline(ssd, 0, 127, 9, true);
+}
+
+bool tela_atualizar(ssd1306_t *ssd, const tela_estado_t *estado) {
+    widget_set_texto(&widgets[W_STATUS], estado->status);
+    widget_set_valor(&widgets[W_TX], (int32_t)estado->tx_count);
+    widget_set_texto(&widgets[W_MSG], estado->last_message);
+    bool mudou = widgets_desenhar(ssd, widgets, TELA_WIDGETS) > 0;
+
+    // Publicações agrupadas num mesmo quadro contribuem só com a última leitura
+    if (estado->amostras != amostras) {
+        amostras = estado->amostras;
+        serie_adicionar(&serie_temp, estado->temp_x10);
+        serie_adicionar(&serie_umid, estado->umid_x10);
+    }
+    mudou |= sparkline_desenhar(ssd, &graf_temp);
+#if SSD1306_HEIGHT == 64
+    mudou |= sparkline_desenhar(ssd, &graf_umid);
+#endif
+    return mudou;
+}
@@ -0,0 +1,28 @@
+#include "../inc/tempo_no_ar.h"
+
+// Larguras de banda de RegModemConfig1 (bits 7..4), em Hz
+static const uint32_t larguras_banda_hz[] = {
+    7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000
+};
+
+uint32_t tempo_no_ar_us(const rfm95_profile_t *perfil, uint8_t length) {
+    uint8_t bw = perfil->modem_config1 >> 4;
+    if (bw >= sizeof(larguras_banda_hz) / sizeof(larguras_banda_hz[0])) return 0;
+
+    uint32_t sf = perfil->modem_config2 >> 4;
+    uint32_t cr = (perfil->modem_config1 >> 1) & 0x07;
+    uint32_t implicito = perfil->modem_config1 & 0x01;
+    uint32_t crc = (perfil->modem_config2 >> 2) & 0x01;
+    uint32_t ldro = (perfil->modem_config3 >> 3) & 0x01;
+    if (sf < 6 || cr == 0) return 0;
+
+    // Símbolo em 1/4 de us para acomodar os 4,25 símbolos do preâmbulo
+    uint32_t simbolo_q = (uint32_t)(((uint64_t)4000000 << sf) / larguras_banda_hz[bw]);
+
+    int32_t num = 8 * length - 4 * (int32_t)sf + 28 + 16 * crc - 20 * implicito;
+    int32_t den = 4 * ((int32_t)sf - 2 * ldro);
+    int32_t extra = num > 0 ? (num + den - 1) / den * (int32_t)(cr + 4) : 0;
+
+    uint32_t simbolos_q = (TEMPO_PREAMBULO_SIMBOLOS * 4 + 17) + 4 * (8 + extra);
+    return (uint32_t)(((uint64_t)simbolos_q * simbolo_q) / 16);
+}
@@ -0,0 +1,124 @@
+#include "../inc/widgets.h"
+#include <string.h>
+
+static void widget_base(widget_t *w, widget_tipo_t tipo, uint8_t x, uint8_t y,
+                        uint8_t colunas, uint8_t linhas, const char *prefixo) {
+    memset(w, 0, sizeof(*w));
+    w->tipo = tipo;
+    w->x = x;
+    w->y = y;
+    w->colunas = colunas;
+    w->linhas = linhas;
+    w->prefixo = prefixo ? prefixo : "";
+    w->unidade = "";
+    w->visivel = true;
+    w->sujo = true;
+}
+
+void widget_rotulo(widget_t *w, uint8_t x, uint8_t y, uint8_t colunas, const char *texto) {
+    widget_base(w, WIDGET_ROTULO, x, y, colunas, 1, texto);
+}
+
+void widget_contador(widget_t *w, uint8_t x, uint8_t y, uint8_t colunas, const char *prefixo) {
+    widget_base(w, WIDGET_CONTADOR, x, y, colunas, 1, prefixo);
+}
+
+void widget_valor(widget_t *w, uint8_t x, uint8_t y, uint8_t colunas, const char *prefixo,
+                  uint8_t decimais, const char *unidade) {
+    widget_base(w, WIDGET_VALOR, x, y, colunas, 1, prefixo);
+    w->decimais = decimais;
+    w->unidade = unidade ? unidade : "";
+}
+
+void widget_status(widget_t *w, uint8_t x, uint8_t y, uint8_t colunas, uint8_t linhas, const char *prefixo) {
+    widget_base(w, WIDGET_STATUS, x, y, colunas, linhas, prefixo);
+}
+
+void widget_set_valor(widget_t *w, int32_t valor) {
+    if (w->valor == valor) return;
+    w->valor = valor;
+    w->sujo = true;
+}
+
+void widget_set_texto(widget_t *w, const char *texto) {
+    if (strncmp(w->texto, texto, sizeof(w->texto) - 1) == 0) return;
+    strncpy(w->texto, texto, sizeof(w->texto) - 1);
+    w->texto[sizeof(w->texto) - 1] = '\0';
+    w->sujo = true;
+}
+
+void widget_set_visivel(widget_t *w, bool visivel) {
+    if (w->visivel == visivel) return;
+    w->visivel = visivel;
+    w->sujo = true;
+}
+
+void widgets_invalidar(widget_t *widgets, uint8_t n) {
+    for (uint8_t i = 0; i < n; ++i) widgets[i].sujo = true;
+}
+
+// Escreve o inteiro em 'dst' com 'decimais' casas, sem passar por printf
+static char *widget_formatar(char *dst, const char *fim, int32_t valor, uint8_t decimais) {
+    char digitos[12];
+    uint8_t n = 0;
+    uint32_t v = valor < 0 ? -(uint32_t)valor : (uint32_t)valor;
+
+    do {
+        digitos[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v || n <= decimais);
+
+    if (valor < 0 && dst < fim) *dst++ = '-';
+    while (n > 0 && dst < fim) {
+        if (n == decimais && decimais > 0) {
+            *dst++ = '.';
+            if (dst == fim) break;
+        }
+        *dst++ = digitos[--n];
+    }
+    return dst;
+}
+
+static char *widget_copiar(char *dst, const char *fim, const char *src) {
+    while (*src && dst < fim) *dst++ = *src++;
+    return dst;
+}
+
+static void widget_desenhar(ssd1306_t *ssd, const widget_t *w) {
+    char linha[WIDGET_TEXTO_MAX * 2];
+    char *p = linha;
+    const char *fim = linha + sizeof(linha) - 1;
+
+    if (w->visivel) {
+        p = widget_copiar(p, fim, w->prefixo);
+        if (w->tipo == WIDGET_CONTADOR) {
+            p = widget_formatar(p, fim, w->valor < 0 ? 0 : w->valor, 0);
+        } else if (w->tipo == WIDGET_VALOR) {
+            p = widget_formatar(p, fim, w->valor, w->decimais);
+            p = widget_copiar(p, fim, w->unidade);
+        } else if (w->tipo == WIDGET_STATUS) {
+            p = widget_copiar(p, fim, w->texto);
+        }
+    }
+    *p = '\0';
+
+    // Cada célula da região é reescrita; o espaço da fonte apaga o resto
+    const char *c = linha;
+    for (uint8_t l = 0; l < w->linhas; ++l) {
+        uint8_t y = w->y + l * 8;
+        for (uint8_t col = 0; col < w->colunas; ++col) {
+            ssd1306_draw_char(ssd, *c ? *c++ : ' ', w->x + col * WIDGET_CHAR_W, y);
+        }
+    }
+}
+
+uint8_t widgets_desenhar(ssd1306_t *ssd, widget_t *widgets, uint8_t n) {
+    uint8_t desenhados = 0;
+    for (uint8_t i = 0; i < n; ++i) {
+        if (!widgets[i].sujo) continue;
+        widget_desenhar(ssd, &widgets[i]);
+        widgets[i].sujo = false;
+        desenhados++;
+    }
+    return desenhados;
+}
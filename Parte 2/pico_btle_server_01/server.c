@@ -1,10 +1,12 @@
 #include <stdio.h>                  // Biblioteca padrão para entrada e saída
+#include <stdlib.h>                 // abs
 #include "pico/stdlib.h"            // Biblioteca padrão da Pico para GPIO, temporização, etc.
 #include "pico/cyw43_arch.h"        // Biblioteca de arquitetura CYW43 para Raspberry Pi Pico
-#include "hardware/adc.h"           // Biblioteca para controle do ADC (Conversor Analógico-Digital)
 #include "btstack.h"                // Biblioteca para manipulação da pilha Bluetooth (BTstack)
 #include "pico/btstack_cyw43.h"     // Biblioteca para integrar BTstack com CYW43
 #include "temp_sensor.h"            // Arquivo .gatt define a estrutura e os atributos de um perfil de dispositivo BLE
+#include "excecao.h"                // Relatório por exceção das notificações
+#include "temp_adc.h"               // Sensor de temperatura interno via ADC contínuo + DMA
 
 
 //Definições iniciais de execução
@@ -12,6 +14,15 @@
 #define APP_AD_FLAGS 0x06
 #define HEARTBEAT_PERIOD_MS 1000 // Define o período de batimento cardíaco em milissegundos
 
+// Relatório por exceção: a temperatura é lida a cada batimento, mas só é
+// notificada quando muda 0,5 °C (a média de 256 amostras reduz o ruído de
+// uma leitura isolada, perto de 1 °C, a poucos centésimos),
+// pelo menos a cada 60 s e no máximo a cada 2 s
+#define TEMP_BANDA_CENTI    50
+#define TEMP_SILENCIO_MS    60000
+#define TEMP_INTERVALO_MS   2000
+#define STATS_BATIMENTOS    60
+
 static uint8_t adv_data[] = {
     // Flags general discoverable
     0x02, BLUETOOTH_DATA_TYPE_FLAGS, APP_AD_FLAGS,
@@ -31,6 +42,7 @@ extern uint8_t const profile_data[];
 // Variáveis estáticas e estruturas usadas no programa
 static btstack_timer_source_t heartbeat; // Estrutura para gerenciar o temporizador
 static btstack_packet_callback_registration_t hci_event_callback_registration; // Registro de callback para eventos HCI (Host Controller Interface)
+static excecao_t relatorio; // Decide quando a temperatura é notificada
 
 // Variáveis para conexão Bluetooth
 static hci_con_handle_t connection_handle = HCI_CON_HANDLE_INVALID; // Handle da conexão Bluetooth, inicializado como inválido
@@ -58,10 +70,11 @@ int main()
         return -1; // Finaliza o programa com erro
     }
 
-    // Conversor analógico digital - sensor de temperatura
-    adc_init(); // Inicializa o ADC para uso do sensor de temperatura
-    adc_select_input(ADC_CHANNEL_TEMPSENSOR); // Seleciona o canal do sensor de temperatura
-    adc_set_temp_sensor_enabled(true); // Habilita o sensor de temperatura interno
+    // Conversor analógico digital - sensor de temperatura, em blocos por DMA
+    if (!temp_adc_iniciar()) {
+        printf("sem canal de DMA livre para o ADC\n");
+        return -1;
+    }
 
     //Protocolos bluetooth
     l2cap_init(); // Inicializa o protocolo L2CAP (Logical Link Control and Adaptation Protocol)
@@ -78,6 +91,9 @@ int main()
     // Registra o callback para pacotes do servidor ATT
     att_server_register_packet_handler(packet_handler);
 
+    const int32_t bandas[1] = { TEMP_BANDA_CENTI };
+    excecao_init(&relatorio, 1, bandas, TEMP_SILENCIO_MS, TEMP_INTERVALO_MS);
+
     // Configura e adiciona o temporizador de batimento cardíaco
     heartbeat.process = &heartbeat_handler; // Define a função de processamento do batimento
     btstack_run_loop_set_timer(&heartbeat, HEARTBEAT_PERIOD_MS); // Configura o temporizador
@@ -123,6 +139,9 @@ int att_write_callback(hci_con_handle_t connection_handle, uint16_t att_handle,
     le_notification_enabled = little_endian_read_16(buffer, 0) == GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION;
     con_handle = connection_handle;
     if (le_notification_enabled) {
+        // O valor atual sai já e vira a referência das bandas
+        int32_t valor = (int16_t)current_temp;
+        excecao_registrar(&relatorio, &valor, true, btstack_run_loop_get_time_ms());
         att_server_request_can_send_now_event(con_handle);
     }
     return 0;
@@ -167,38 +186,35 @@ void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint
     }
 }
 
-// Coleta dos dados de temperatura do sensor interno do RP2040
+// Coleta dos dados de temperatura do sensor interno do RP2040: usa o bloco
+// que o DMA terminou de capturar, se houver; senão mantém o valor anterior
 void poll_temp(void) {
-    adc_select_input(ADC_CHANNEL_TEMPSENSOR);
-    uint32_t raw32 = adc_read();
-    const uint32_t bits = 12;
-
-    // Scale raw reading to 16 bit value using a Taylor expansion (for 8 <= bits <= 16)
-    uint16_t raw16 = raw32 << (16 - bits) | raw32 >> (2 * bits - 16);
-
-    // ref https://github.com/raspberrypi/pico-micropython-examples/blob/master/adc/temperature.py
-    const float conversion_factor = 3.3 / (65535);
-    float reading = raw16 * conversion_factor;
-    
-    // The temperature sensor measures the Vbe voltage of a biased bipolar diode, connected to the fifth ADC channel
-    // Typically, Vbe = 0.706V at 27 degrees C, with a slope of -1.721mV (0.001721) per degree. 
-    float deg_c = 27 - (reading - 0.706) / 0.001721;
-    current_temp = deg_c * 100;
-    printf("Write temp %.2f degc\n", deg_c);
- }
+    int16_t centi;
+    if (temp_adc_coletar(&centi)) current_temp = (uint16_t)centi;
+}
 
  // Função chamada a cada batimento cardíaco
 static void heartbeat_handler(struct btstack_timer_source *ts) {
     static uint32_t counter = 0; // Contador para rastrear os ciclos do temporizador
     counter++; // Incrementa o contador
 
-    // Atualiza a temperatura a cada 10 batimentos
-    if (counter % 10 == 0) {
-        poll_temp(); // Função para ler a temperatura
-        if (le_notification_enabled) { // Verifica se notificações estão habilitadas
+    // Lê a temperatura a cada batimento; só notifica se o relatório por
+    // exceção pedir (mudança além da banda ou silêncio máximo)
+    poll_temp(); // Função para ler a temperatura
+    if (le_notification_enabled) { // Verifica se notificações estão habilitadas
+        int32_t valor = (int16_t)current_temp;
+        excecao_motivo_t motivo = excecao_avaliar(&relatorio, &valor, true, btstack_run_loop_get_time_ms());
+        if (excecao_enviar(motivo)) {
             att_server_request_can_send_now_event(con_handle); // Solicita permissão para enviar dados
         }
     }
+    if (counter % STATS_BATIMENTOS == 0) {
+        int16_t t = (int16_t)current_temp;
+        printf("Temp %s%d.%02d degc; notificacoes: %lu de %lu leituras (%lu por mudanca, %lu por silencio)\n",
+               t < 0 ? "-" : "", abs(t) / 100, abs(t) % 100,
+               (unsigned long)relatorio.enviadas, (unsigned long)relatorio.avaliadas,
+               (unsigned long)relatorio.por_mudanca, (unsigned long)relatorio.por_silencio);
+    }
 
     // Inverte o estado do LED
     static int led_on = true; // Variável para armazenar o estado do LED
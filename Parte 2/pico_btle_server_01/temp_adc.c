@@ -0,0 +1,90 @@
+#include "temp_adc.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#define TEMP_ADC_CANAL 4
+
+// Vbe do diodo a 27 °C e inclinação, em µV; Vref em µV
+#define TEMP_VBE_27_UV      706000
+#define TEMP_UV_POR_GRAU    1721
+#define TEMP_VREF_UV        3300000
+
+static uint16_t amostras[TEMP_ADC_AMOSTRAS];
+static int canal_dma = -1;
+static volatile bool bloco_pronto;
+
+static void temp_adc_disparar(void) {
+    // Sobras da FIFO do bloco anterior atrasariam o novo em uma amostra
+    adc_fifo_drain();
+    bloco_pronto = false;
+    dma_channel_transfer_to_buffer_now(canal_dma, amostras, TEMP_ADC_AMOSTRAS);
+    adc_run(true);
+}
+
+static void temp_adc_dma_irq(void) {
+    if (canal_dma < 0 || !dma_channel_get_irq1_status(canal_dma)) return;
+    dma_channel_acknowledge_irq1(canal_dma);
+    adc_run(false);
+    bloco_pronto = true;
+}
+
+bool temp_adc_iniciar(void) {
+    int chan = dma_claim_unused_channel(false);
+    if (chan < 0) return false;
+
+    adc_init();
+    adc_set_temp_sensor_enabled(true);
+    adc_select_input(TEMP_ADC_CANAL);
+    adc_set_round_robin(0);
+    // FIFO com DREQ a cada amostra, 12 bits, sem o bit de erro
+    adc_fifo_setup(true, true, 1, false, false);
+    // Uma conversão leva 96 ciclos do clk_adc; o divisor espaça as amostras
+    adc_set_clkdiv((float)clock_get_hz(clk_adc) / TEMP_ADC_TAXA_HZ - 1.0f);
+
+    dma_channel_config cfg = dma_channel_get_default_config(chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    dma_channel_configure(chan, &cfg, amostras, &adc_hw->fifo, TEMP_ADC_AMOSTRAS, false);
+    canal_dma = chan;
+
+    dma_channel_set_irq1_enabled(chan, true);
+    irq_add_shared_handler(DMA_IRQ_1, temp_adc_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    temp_adc_disparar();
+    return true;
+}
+
+bool temp_adc_pronto(void) {
+    return bloco_pronto;
+}
+
+// Divisão com arredondamento para o mais próximo (divisor positivo)
+static int32_t div_arred(int32_t n, int32_t d) {
+    return n >= 0 ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+int16_t temp_adc_centi(uint32_t soma) {
+    // soma / (4096 * TEMP_ADC_AMOSTRAS) * Vref, já em µV
+    int32_t uv = (int32_t)(((uint64_t)soma * TEMP_VREF_UV) >> (12 + TEMP_ADC_AMOSTRAS_LOG2));
+    int32_t centi = 2700 - div_arred((uv - TEMP_VBE_27_UV) * 100, TEMP_UV_POR_GRAU);
+    // Só leituras absurdas (entrada em 0 ou no fundo de escala) saem do int16
+    if (centi > INT16_MAX) centi = INT16_MAX;
+    if (centi < INT16_MIN) centi = INT16_MIN;
+    return (int16_t)centi;
+}
+
+bool temp_adc_coletar(int16_t *centi) {
+    if (!bloco_pronto) return false;
+
+    uint32_t soma = 0;
+    for (uint32_t i = 0; i < TEMP_ADC_AMOSTRAS; ++i) soma += amostras[i];
+    temp_adc_disparar();
+
+    *centi = temp_adc_centi(soma);
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef TEMP_ADC_H
+#define TEMP_ADC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Amostras por bloco (potência de 2: a média é um deslocamento)
+#define TEMP_ADC_AMOSTRAS_LOG2  8
+#define TEMP_ADC_AMOSTRAS       (1u << TEMP_ADC_AMOSTRAS_LOG2)
+
+// Taxa do ADC em modo contínuo: 1 amostra por ms, um bloco em ~256 ms
+#define TEMP_ADC_TAXA_HZ        1000
+
+// Sensor de temperatura interno amostrado sem a CPU: o ADC roda em modo
+// contínuo no canal 4 e o DMA copia um bloco de amostras da FIFO para um
+// buffer. No fim do bloco o IRQ do DMA só para o ADC e marca o bloco como
+// pronto; a média e a conversão (em ponto fixo) ficam para quem chamar
+// temp_adc_coletar, que já dispara o bloco seguinte.
+bool temp_adc_iniciar(void);
+
+// Há um bloco completo esperando temp_adc_coletar
+bool temp_adc_pronto(void);
+
+// Média do bloco em centésimos de °C; false se o bloco ainda não terminou
+bool temp_adc_coletar(int16_t *centi);
+
+// Conversão da soma de TEMP_ADC_AMOSTRAS leituras de 12 bits para
+// centésimos de °C (Vbe = 0,706 V a 27 °C, -1,721 mV/°C, Vref = 3,3 V)
+int16_t temp_adc_centi(uint32_t soma);
+
+#endif